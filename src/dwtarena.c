@@ -0,0 +1,288 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_MMAN_H
+#  include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_SYSCALL_H
+#  include <sys/syscall.h>
+#endif
+
+#include "dwtarena.h"
+
+/* cache line alignment for the vectorised passes */
+#define DWT_ARENA_ALIGN 64
+
+#define DWT_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+static GMutex arena_lock;
+static GQueue arena_idle = G_QUEUE_INIT;
+static guint arena_users;
+
+static gdouble *
+aligned_alloc_doubles (gsize n)
+{
+	void *mem;
+
+	if (posix_memalign (&mem, DWT_ARENA_ALIGN, MAX (n, 1) * sizeof (gdouble)) != 0)
+		return NULL;
+
+	return mem;
+}
+
+/* NUMA node of the calling thread, -1 when it cannot be told */
+static gint
+current_node (void)
+{
+#ifdef SYS_getcpu
+	unsigned int cpu, node;
+
+	if (syscall (SYS_getcpu, &cpu, &node, NULL) == 0)
+		return node;
+#endif
+	return -1;
+}
+
+#ifdef HAVE_SYS_MMAN_H
+/* maps a 2 MB aligned anonymous region and asks for transparent huge pages */
+static void *
+map_transparent (gsize bytes)
+{
+	guint8 *mem, *aligned;
+	gsize head;
+
+	mem = mmap (NULL, bytes + DWT_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED)
+		return NULL;
+
+	aligned = (guint8 *) (((guintptr) mem + DWT_HUGE_PAGE_SIZE - 1) &
+			~(guintptr) (DWT_HUGE_PAGE_SIZE - 1));
+	head = aligned - mem;
+	if (head > 0)
+		munmap (mem, head);
+	if (DWT_HUGE_PAGE_SIZE - head > 0)
+		munmap (aligned + bytes, DWT_HUGE_PAGE_SIZE - head);
+
+#ifdef MADV_HUGEPAGE
+	madvise (aligned, bytes, MADV_HUGEPAGE);
+#endif
+
+	return aligned;
+}
+#endif
+
+/* Allocates the plane of a block. The memory is left untouched, so the
+ * pages are placed on the node of the thread that fills the plane first,
+ * which is the one about to transform into it. */
+static gboolean
+plane_alloc (DwtArenaBlock *block, gsize n, DwtArenaPages pages)
+{
+	block->pages = pages;
+	block->node = current_node ();
+	block->plane_mapped = 0;
+	block->plane = NULL;
+	block->plane_size = 0;
+
+#ifdef HAVE_SYS_MMAN_H
+	if (pages != DWT_ARENA_PAGES_DEFAULT)
+	{
+		gsize bytes = (n * sizeof (gdouble) + DWT_HUGE_PAGE_SIZE - 1) &
+				~(gsize) (DWT_HUGE_PAGE_SIZE - 1);
+		void *mem = NULL;
+
+#ifdef MAP_HUGETLB
+		if (pages == DWT_ARENA_PAGES_EXPLICIT)
+		{
+			mem = mmap (NULL, bytes, PROT_READ | PROT_WRITE,
+					MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (mem == MAP_FAILED)
+				mem = NULL;
+		}
+#endif
+		if (mem == NULL)
+			mem = map_transparent (bytes);
+
+		if (mem != NULL)
+		{
+			block->plane = mem;
+			block->plane_mapped = bytes;
+			block->plane_size = n;
+		}
+		return block->plane != NULL;
+	}
+#endif
+
+	block->plane = aligned_alloc_doubles (n);
+	block->plane_size = block->plane ? n : 0;
+	return block->plane != NULL;
+}
+
+static void
+plane_free (DwtArenaBlock *block)
+{
+#ifdef HAVE_SYS_MMAN_H
+	if (block->plane_mapped > 0)
+	{
+		munmap (block->plane, block->plane_mapped);
+		block->plane = NULL;
+		return;
+	}
+#endif
+	free (block->plane);
+	block->plane = NULL;
+}
+
+static void
+block_free (DwtArenaBlock *block)
+{
+	plane_free (block);
+	free (block->line);
+	g_free (block);
+}
+
+/* Every element instance holds a reference between READY and NULL. When
+ * the last one goes away the idle blocks are released. */
+void
+dwt_arena_ref (void)
+{
+	g_mutex_lock (&arena_lock);
+	arena_users++;
+	g_mutex_unlock (&arena_lock);
+}
+
+void
+dwt_arena_unref (void)
+{
+	DwtArenaBlock *block;
+
+	g_mutex_lock (&arena_lock);
+	if (--arena_users == 0)
+	{
+		while ((block = g_queue_pop_head (&arena_idle)) != NULL)
+			block_free (block);
+	}
+	g_mutex_unlock (&arena_lock);
+}
+
+/* Hands out an idle block with the requested page backing. Blocks that
+ * already fit are preferred, then blocks first touched from this thread's
+ * NUMA node, then the smaller ones; an idle block that does not fit is
+ * grown. Returns NULL when out of memory. */
+DwtArenaBlock *
+dwt_arena_acquire (gsize plane_size, gsize line_size, DwtArenaPages pages)
+{
+	DwtArenaBlock *block = NULL;
+	gint node = current_node ();
+	gint best_score = -1;
+	GList *l;
+
+	g_mutex_lock (&arena_lock);
+	for (l = arena_idle.head; l != NULL; l = l->next)
+	{
+		DwtArenaBlock *candidate = l->data;
+		gint score;
+
+		if (candidate->pages != pages)
+			continue;
+
+		score = (candidate->plane_size >= plane_size && candidate->line_size >= line_size) * 2 +
+			(candidate->node == node);
+
+		if (score > best_score ||
+			(score == best_score && candidate->plane_size < block->plane_size))
+		{
+			block = candidate;
+			best_score = score;
+		}
+	}
+	if (block != NULL)
+		g_queue_remove (&arena_idle, block);
+	g_mutex_unlock (&arena_lock);
+
+	if (block == NULL)
+		block = g_new0 (DwtArenaBlock, 1);
+
+	if (block->plane == NULL || block->plane_size < plane_size)
+	{
+		plane_free (block);
+		plane_alloc (block, plane_size, pages);
+	}
+	if (block->line == NULL || block->line_size < line_size)
+	{
+		free (block->line);
+		block->line = aligned_alloc_doubles (line_size);
+		block->line_size = block->line ? line_size : 0;
+	}
+
+	if (block->plane == NULL || block->line == NULL)
+	{
+		block_free (block);
+		return NULL;
+	}
+
+	return block;
+}
+
+/* Returns a block to the pool. No more blocks than users are kept idle,
+ * so a burst of concurrent transforms does not pin memory forever. */
+void
+dwt_arena_release (DwtArenaBlock *block)
+{
+	g_mutex_lock (&arena_lock);
+	if (g_queue_get_length (&arena_idle) < arena_users)
+	{
+		g_queue_push_tail (&arena_idle, block);
+		block = NULL;
+	}
+	g_mutex_unlock (&arena_lock);
+
+	if (block != NULL)
+		block_free (block);
+}
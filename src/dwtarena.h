@@ -0,0 +1,85 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __DWT_ARENA_H__
+#define __DWT_ARENA_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _DwtArenaBlock DwtArenaBlock;
+
+/* backing of the coefficient planes */
+typedef enum
+{
+	DWT_ARENA_PAGES_DEFAULT,	/* regular pages from the C allocator */
+	DWT_ARENA_PAGES_TRANSPARENT,	/* 2 MB aligned mapping advised for THP */
+	DWT_ARENA_PAGES_EXPLICIT	/* MAP_HUGETLB, transparent when none are reserved */
+} DwtArenaPages;
+
+/* A coefficient plane plus a line of scratch, borrowed from a process wide
+ * pool for the duration of one transform. Instances that are not
+ * transforming at the same time share the same blocks. */
+struct _DwtArenaBlock
+{
+	gdouble *plane;
+	gsize plane_size;	/* in doubles */
+	gdouble *line;
+	gsize line_size;	/* in doubles */
+
+	DwtArenaPages pages;
+	gsize plane_mapped;	/* length of the mapping, 0 for the C allocator */
+	gint node;		/* NUMA node that first touched the plane, -1 if unknown */
+};
+
+void dwt_arena_ref (void);
+void dwt_arena_unref (void);
+
+DwtArenaBlock *dwt_arena_acquire (gsize plane_size, gsize line_size,
+	DwtArenaPages pages);
+void dwt_arena_release (DwtArenaBlock *block);
+
+G_END_DECLS
+
+#endif /* __DWT_ARENA_H__ */
@@ -0,0 +1,453 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "dwtcodec.h"
+
+/* adaptive binary range coder (LZMA style), probabilities of a 0 bit in
+ * PROB_BITS fixed point */
+#define PROB_BITS 11
+#define PROB_ONE (1u << PROB_BITS)
+#define PROB_SHIFT 5
+#define RANGE_TOP (1u << 24)
+
+#define MAX_PLANES 31
+
+/* per coefficient state */
+#define STATE_SIGNIFICANT 1
+#define STATE_REFINED 2
+#define STATE_NEGATIVE 4
+
+/* significance contexts: ring classes x significant neighbours (0, 1, 2+) */
+#define SIG_RINGS 12
+#define SIG_CONTEXTS (SIG_RINGS * 3)
+#define REF_CONTEXTS 2
+
+/* a tile record: number of planes and length of the range coded bytes */
+#define RECORD_HEADER_SIZE 5
+
+typedef struct
+{
+	guint64 low;
+	guint32 range;
+	guint8 cache;
+	guint64 cache_size;
+	GByteArray *out;
+} RangeEncoder;
+
+typedef struct
+{
+	const guint8 *data, *end;
+	guint32 range, code;
+} RangeDecoder;
+
+typedef struct
+{
+	guint16 sig[SIG_CONTEXTS];
+	guint16 ref[REF_CONTEXTS];
+	guint16 sign;
+} Contexts;
+
+static void contexts_init (Contexts *ctx);
+static guint significance_context (const DwtCodec *codec, guint x, guint y, guint ring);
+static void encoder_init (RangeEncoder *rc, GByteArray *out);
+static void encode_bit (RangeEncoder *rc, guint16 *prob, guint bit);
+static void encoder_flush (RangeEncoder *rc);
+static void decoder_init (RangeDecoder *rc, const guint8 *data, gsize size);
+static guint decode_bit (RangeDecoder *rc, guint16 *prob);
+static void put_u32 (guint8 *p, guint32 v);
+static guint32 get_u32 (const guint8 *p);
+
+/* Visits the coefficients coarse levels first: ring r > 0 holds the
+ * positions whose larger coordinate lies in [2^(r-1), 2^r), in raster
+ * order, which in the standard layout are the detail coefficients of one
+ * level in x or y. */
+#define FOR_EACH_RING_POSITION(codec, r, x, y) \
+	for (r = 0; r < (codec)->rings; r++) \
+		for (y = 0; y < MIN ((codec)->height, 1u << r); y++) \
+			for (x = (r > 0 && y < (1u << (r - 1))) ? (1u << (r - 1)) : 0; \
+					x < MIN ((codec)->width, 1u << r); x++)
+
+DwtCodec *
+dwt_codec_new (guint width, guint height)
+{
+	DwtCodec *codec = g_new0 (DwtCodec, 1);
+
+	codec->width = width;
+	codec->height = height;
+	for (codec->rings = 1; (1u << (codec->rings - 1)) < MAX (width, height); codec->rings++);
+	codec->magnitudes = g_new (guint32, (gsize) width * height);
+	codec->state = g_new (guint8, (gsize) width * height);
+
+	return codec;
+}
+
+void
+dwt_codec_free (DwtCodec *codec)
+{
+	if (codec == NULL)
+		return;
+
+	g_free (codec->magnitudes);
+	g_free (codec->state);
+	g_free (codec);
+}
+
+void
+dwt_codec_write_header (GByteArray *out, guint width, guint tile_height,
+	guint n_tiles, gdouble step)
+{
+	guint8 header[DWT_CODEC_HEADER_SIZE];
+	union { gdouble d; guint64 u; } bits;
+
+	bits.d = step;
+	put_u32 (header, width);
+	put_u32 (header + 4, tile_height);
+	put_u32 (header + 8, n_tiles);
+	put_u32 (header + 12, (guint32) bits.u);
+	put_u32 (header + 16, (guint32) (bits.u >> 32));
+
+	g_byte_array_append (out, header, sizeof (header));
+}
+
+gboolean
+dwt_codec_read_header (const guint8 *data, gsize size, guint *width,
+	guint *tile_height, guint *n_tiles, gdouble *step)
+{
+	union { gdouble d; guint64 u; } bits;
+
+	if (size < DWT_CODEC_HEADER_SIZE)
+		return FALSE;
+
+	*width = get_u32 (data);
+	*tile_height = get_u32 (data + 4);
+	*n_tiles = get_u32 (data + 8);
+	bits.u = get_u32 (data + 12) | ((guint64) get_u32 (data + 16) << 32);
+	*step = bits.d;
+
+	return *step > 0;
+}
+
+/* Appends the record of one plane of coefficients quantized by step. */
+void
+dwt_codec_encode (DwtCodec *codec, const gdouble *coefs, gdouble step,
+	GByteArray *out)
+{
+	gsize n = (gsize) codec->width * codec->height;
+	gsize i, start;
+	guint32 max = 0;
+	guint planes, p, r, x, y;
+	RangeEncoder rc;
+	Contexts ctx;
+
+	for (i = 0; i < n; i++)
+	{
+		gdouble q = fabs (coefs[i]) / step;
+
+		codec->magnitudes[i] = q < (gdouble) G_MAXINT32 ? (guint32) q : G_MAXINT32;
+		codec->state[i] = coefs[i] < 0 ? STATE_NEGATIVE : 0;
+		max |= codec->magnitudes[i];
+	}
+	for (planes = 0; planes < MAX_PLANES && (max >> planes) != 0; planes++);
+
+	start = out->len;
+	g_byte_array_set_size (out, start + RECORD_HEADER_SIZE);
+	out->data[start] = planes;
+
+	contexts_init (&ctx);
+	encoder_init (&rc, out);
+
+	for (p = planes; p-- > 0;)
+	{
+		FOR_EACH_RING_POSITION (codec, r, x, y)
+		{
+			guint8 *state = &codec->state[y * codec->width + x];
+			guint bit = (codec->magnitudes[y * codec->width + x] >> p) & 1;
+
+			if (*state & STATE_SIGNIFICANT)
+			{
+				encode_bit (&rc, &ctx.ref[(*state & STATE_REFINED) ? 1 : 0], bit);
+				*state |= STATE_REFINED;
+				continue;
+			}
+
+			encode_bit (&rc, &ctx.sig[significance_context (codec, x, y, r)], bit);
+			if (bit)
+			{
+				encode_bit (&rc, &ctx.sign, (*state & STATE_NEGATIVE) ? 1 : 0);
+				*state |= STATE_SIGNIFICANT;
+			}
+		}
+	}
+
+	encoder_flush (&rc);
+	put_u32 (out->data + start + 1, out->len - start - RECORD_HEADER_SIZE);
+}
+
+/* Decodes one record into coefs, reconstructing in the middle of each
+ * quantization interval. Returns the size of the record, 0 if it is
+ * malformed. */
+gsize
+dwt_codec_decode (DwtCodec *codec, const guint8 *data, gsize size,
+	gdouble step, gdouble *coefs)
+{
+	gsize n = (gsize) codec->width * codec->height;
+	gsize i, len;
+	guint planes, p, r, x, y;
+	RangeDecoder rc;
+	Contexts ctx;
+
+	if (size < RECORD_HEADER_SIZE)
+		return 0;
+
+	planes = data[0];
+	len = get_u32 (data + 1);
+	if (planes > MAX_PLANES || len > size - RECORD_HEADER_SIZE)
+		return 0;
+
+	memset (codec->magnitudes, 0, n * sizeof (guint32));
+	memset (codec->state, 0, n);
+
+	contexts_init (&ctx);
+	decoder_init (&rc, data + RECORD_HEADER_SIZE, len);
+
+	for (p = planes; p-- > 0;)
+	{
+		FOR_EACH_RING_POSITION (codec, r, x, y)
+		{
+			guint8 *state = &codec->state[y * codec->width + x];
+			guint32 *magnitude = &codec->magnitudes[y * codec->width + x];
+
+			if (*state & STATE_SIGNIFICANT)
+			{
+				*magnitude |= decode_bit (&rc, &ctx.ref[(*state & STATE_REFINED) ? 1 : 0]) << p;
+				*state |= STATE_REFINED;
+				continue;
+			}
+
+			if (decode_bit (&rc, &ctx.sig[significance_context (codec, x, y, r)]))
+			{
+				*magnitude |= 1u << p;
+				*state |= STATE_SIGNIFICANT;
+				if (decode_bit (&rc, &ctx.sign))
+					*state |= STATE_NEGATIVE;
+			}
+		}
+	}
+
+	for (i = 0; i < n; i++)
+	{
+		gdouble c = codec->magnitudes[i] ? (codec->magnitudes[i] + 0.5) * step : 0;
+
+		coefs[i] = (codec->state[i] & STATE_NEGATIVE) ? -c : c;
+	}
+
+	return RECORD_HEADER_SIZE + len;
+}
+
+static void
+contexts_init (Contexts *ctx)
+{
+	guint i;
+
+	for (i = 0; i < SIG_CONTEXTS; i++)
+		ctx->sig[i] = PROB_ONE / 2;
+	for (i = 0; i < REF_CONTEXTS; i++)
+		ctx->ref[i] = PROB_ONE / 2;
+	ctx->sign = PROB_ONE / 2;
+}
+
+/* Neighbours that are already significant. The encoder and the decoder
+ * visit the plane in the same order, so they see the same states. */
+static guint
+significance_context (const DwtCodec *codec, guint x, guint y, guint ring)
+{
+	const guint8 *state = &codec->state[y * codec->width + x];
+	guint count = 0;
+
+	if (x > 0)
+		count += state[-1] & STATE_SIGNIFICANT;
+	if (y > 0)
+		count += state[-(gssize) codec->width] & STATE_SIGNIFICANT;
+	if (x + 1 < codec->width)
+		count += state[1] & STATE_SIGNIFICANT;
+	if (y + 1 < codec->height)
+		count += state[codec->width] & STATE_SIGNIFICANT;
+
+	return MIN (ring, SIG_RINGS - 1) * 3 + MIN (count, 2);
+}
+
+static void
+shift_low (RangeEncoder *rc)
+{
+	if ((guint32) rc->low < 0xFF000000u || (rc->low >> 32) != 0)
+	{
+		guint8 carry = rc->low >> 32;
+		guint8 byte = rc->cache;
+
+		do
+		{
+			byte += carry;
+			g_byte_array_append (rc->out, &byte, 1);
+			byte = 0xFF;
+		}
+		while (--rc->cache_size != 0);
+
+		rc->cache = (guint8) (rc->low >> 24);
+	}
+	rc->cache_size++;
+	rc->low = (rc->low & 0x00FFFFFF) << 8;
+}
+
+static void
+encoder_init (RangeEncoder *rc, GByteArray *out)
+{
+	rc->low = 0;
+	rc->range = 0xFFFFFFFFu;
+	rc->cache = 0;
+	rc->cache_size = 1;
+	rc->out = out;
+}
+
+static void
+encode_bit (RangeEncoder *rc, guint16 *prob, guint bit)
+{
+	guint32 bound = (rc->range >> PROB_BITS) * *prob;
+
+	if (bit == 0)
+	{
+		rc->range = bound;
+		*prob += (PROB_ONE - *prob) >> PROB_SHIFT;
+	}
+	else
+	{
+		rc->low += bound;
+		rc->range -= bound;
+		*prob -= *prob >> PROB_SHIFT;
+	}
+
+	while (rc->range < RANGE_TOP)
+	{
+		rc->range <<= 8;
+		shift_low (rc);
+	}
+}
+
+static void
+encoder_flush (RangeEncoder *rc)
+{
+	guint i;
+
+	for (i = 0; i < 5; i++)
+		shift_low (rc);
+}
+
+/* reads zeros past the end, so a short record decodes without overrun */
+static guint8
+next_byte (RangeDecoder *rc)
+{
+	return rc->data < rc->end ? *rc->data++ : 0;
+}
+
+static void
+decoder_init (RangeDecoder *rc, const guint8 *data, gsize size)
+{
+	guint i;
+
+	rc->data = data;
+	rc->end = data + size;
+	rc->range = 0xFFFFFFFFu;
+	rc->code = 0;
+	for (i = 0; i < 5; i++)
+		rc->code = (rc->code << 8) | next_byte (rc);
+}
+
+static guint
+decode_bit (RangeDecoder *rc, guint16 *prob)
+{
+	guint32 bound = (rc->range >> PROB_BITS) * *prob;
+	guint bit;
+
+	if (rc->code < bound)
+	{
+		rc->range = bound;
+		*prob += (PROB_ONE - *prob) >> PROB_SHIFT;
+		bit = 0;
+	}
+	else
+	{
+		rc->code -= bound;
+		rc->range -= bound;
+		*prob -= *prob >> PROB_SHIFT;
+		bit = 1;
+	}
+
+	while (rc->range < RANGE_TOP)
+	{
+		rc->range <<= 8;
+		rc->code = (rc->code << 8) | next_byte (rc);
+	}
+
+	return bit;
+}
+
+static void
+put_u32 (guint8 *p, guint32 v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+static guint32
+get_u32 (const guint8 *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((guint32) p[3] << 24);
+}
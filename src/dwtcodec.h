@@ -0,0 +1,86 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __DWT_CODEC_H__
+#define __DWT_CODEC_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _DwtCodec DwtCodec;
+
+/* Embedded bitplane coder for width x height planes of DWT coefficients
+ * in the layout dwt_plan_execute() leaves them. The coefficients are
+ * quantized with a dead zone of one step and coded from the most
+ * significant bitplane down, each plane scanning the coarse levels before
+ * the fine ones. Significance, sign and refinement decisions go through
+ * an adaptive binary range coder whose significance contexts are the
+ * level and the number of significant neighbours. */
+struct _DwtCodec
+{
+	guint width, height;
+	guint rings;		/* levels of the scan, the LL coefficient being ring 0 */
+	guint32 *magnitudes;
+	guint8 *state;
+};
+
+/* a coded frame: a header followed by one record per tile */
+#define DWT_CODEC_HEADER_SIZE 20
+
+DwtCodec *dwt_codec_new (guint width, guint height);
+void dwt_codec_free (DwtCodec *codec);
+
+void dwt_codec_write_header (GByteArray *out, guint width, guint tile_height,
+	guint n_tiles, gdouble step);
+gboolean dwt_codec_read_header (const guint8 *data, gsize size, guint *width,
+	guint *tile_height, guint *n_tiles, gdouble *step);
+
+void dwt_codec_encode (DwtCodec *codec, const gdouble *coefs, gdouble step,
+	GByteArray *out);
+gsize dwt_codec_decode (DwtCodec *codec, const guint8 *data, gsize size,
+	gdouble step, gdouble *coefs);
+
+G_END_DECLS
+
+#endif /* __DWT_CODEC_H__ */
@@ -0,0 +1,255 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#  include <sys/mman.h>
+#endif
+
+#include "dwtdump.h"
+
+static DwtDumpSlot *
+slot_at (const DwtDump *dump, guint64 sequence)
+{
+	return (DwtDumpSlot *) ((guint8 *) (dump->header + 1) +
+			(sequence % dump->header->slots) * dump->slot_size);
+}
+
+#ifdef HAVE_SYS_MMAN_H
+
+/* the bytes of one slot and of a file of slots of them, FALSE when they
+ * do not fit in a gsize */
+static gboolean
+dump_sizes (guint width, guint height, guint slots, gsize *slot_size, gsize *size)
+{
+	guint64 plane = (guint64) width * height;
+
+	if (plane > (G_MAXSIZE - sizeof (DwtDumpSlot)) / sizeof (gdouble))
+		return FALSE;
+	*slot_size = sizeof (DwtDumpSlot) + plane * sizeof (gdouble);
+
+	if (slots > (G_MAXSIZE - sizeof (DwtDumpHeader)) / *slot_size)
+		return FALSE;
+	*size = sizeof (DwtDumpHeader) + slots * *slot_size;
+
+	return TRUE;
+}
+
+static DwtDump *
+map_file (int fd, gsize size, gboolean writable)
+{
+	DwtDump *dump;
+	void *mem;
+
+	mem = mmap (NULL, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+			MAP_SHARED, fd, 0);
+	if (mem == MAP_FAILED)
+		return NULL;
+
+	dump = g_new0 (DwtDump, 1);
+	dump->header = mem;
+	dump->size = size;
+	dump->writable = writable;
+	return dump;
+}
+
+/* Creates (or truncates) the file at path with room for slots frames and
+ * maps it; NULL when it cannot. */
+DwtDump *
+dwt_dump_create (const gchar *path, guint width, guint height,
+	guint tile_height, const gchar *wavelet, guint slots)
+{
+	gsize slot_size, size;
+	DwtDump *dump;
+	int fd;
+
+	if (width == 0 || height == 0 || slots == 0 ||
+		!dump_sizes (width, height, slots, &slot_size, &size))
+		return NULL;
+
+	fd = open (path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return NULL;
+	if (ftruncate (fd, size) != 0)
+	{
+		close (fd);
+		return NULL;
+	}
+	dump = map_file (fd, size, TRUE);
+	close (fd);
+	if (dump == NULL)
+		return NULL;
+
+	dump->slot_size = slot_size;
+	dump->header->magic = DWT_DUMP_MAGIC;
+	dump->header->version = DWT_DUMP_VERSION;
+	dump->header->width = width;
+	dump->header->height = height;
+	dump->header->tile_height = tile_height;
+	dump->header->slots = slots;
+	g_strlcpy (dump->header->wavelet, wavelet, sizeof (dump->header->wavelet));
+	dump->header->written = 0;
+
+	return dump;
+}
+
+/* Maps a dump read only; NULL unless it is a complete dump file, every
+ * slot its header claims inside the file. Meant
+ * for files no longer written to: a frame being written meanwhile may be
+ * read half old, half new. */
+DwtDump *
+dwt_dump_open (const gchar *path)
+{
+	DwtDumpHeader *h;
+	DwtDump *dump;
+	struct stat st;
+	gsize size;
+	int fd;
+
+	fd = open (path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	if (fstat (fd, &st) != 0 || (guint64) st.st_size > G_MAXSIZE ||
+		(gsize) st.st_size < sizeof (DwtDumpHeader))
+	{
+		close (fd);
+		return NULL;
+	}
+	dump = map_file (fd, st.st_size, FALSE);
+	close (fd);
+	if (dump == NULL)
+		return NULL;
+
+	h = dump->header;
+	if (h->magic != DWT_DUMP_MAGIC || h->version != DWT_DUMP_VERSION ||
+		h->width == 0 || h->height == 0 || h->slots == 0 ||
+		h->tile_height == 0 || h->height % h->tile_height != 0 ||
+		h->wavelet[sizeof (h->wavelet) - 1] != '\0' ||
+		!dump_sizes (h->width, h->height, h->slots, &dump->slot_size, &size) ||
+		dump->size < size)
+	{
+		dwt_dump_close (dump);
+		return NULL;
+	}
+
+	return dump;
+}
+
+void
+dwt_dump_close (DwtDump *dump)
+{
+	if (dump == NULL)
+		return;
+
+	munmap (dump->header, dump->size);
+	g_free (dump);
+}
+
+#else /* HAVE_SYS_MMAN_H */
+
+DwtDump *
+dwt_dump_create (const gchar *path, guint width, guint height,
+	guint tile_height, const gchar *wavelet, guint slots)
+{
+	return NULL;
+}
+
+DwtDump *
+dwt_dump_open (const gchar *path)
+{
+	return NULL;
+}
+
+void
+dwt_dump_close (DwtDump *dump)
+{
+}
+
+#endif /* HAVE_SYS_MMAN_H */
+
+/* the coefficients of the next frame go here, overwriting the oldest */
+gdouble *
+dwt_dump_begin (DwtDump *dump)
+{
+	return (gdouble *) (slot_at (dump, dump->header->written) + 1);
+}
+
+/* publishes the frame filled in since dwt_dump_begin() */
+void
+dwt_dump_commit (DwtDump *dump, guint64 pts)
+{
+	DwtDumpSlot *slot = slot_at (dump, dump->header->written);
+
+	slot->sequence = dump->header->written;
+	slot->pts = pts;
+	dump->header->written++;
+}
+
+guint
+dwt_dump_n_frames (const DwtDump *dump)
+{
+	return MIN (dump->header->written, dump->header->slots);
+}
+
+/* frame index of the ring, 0 being the oldest still held */
+const gdouble *
+dwt_dump_frame (const DwtDump *dump, guint index, guint64 *pts)
+{
+	guint64 first = dump->header->written - dwt_dump_n_frames (dump);
+	DwtDumpSlot *slot;
+
+	if (index >= dwt_dump_n_frames (dump))
+		return NULL;
+
+	slot = slot_at (dump, first + index);
+	if (pts)
+		*pts = slot->pts;
+	return (const gdouble *) (slot + 1);
+}
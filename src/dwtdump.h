@@ -0,0 +1,102 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __DWT_DUMP_H__
+#define __DWT_DUMP_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _DwtDumpHeader DwtDumpHeader;
+typedef struct _DwtDumpSlot   DwtDumpSlot;
+typedef struct _DwtDump       DwtDump;
+
+#define DWT_DUMP_MAGIC   0x44545744	/* "DWTD" on little endian */
+#define DWT_DUMP_VERSION 1
+
+/* Start of a dump file. The slots follow, each a DwtDumpSlot and the
+ * width x height coefficients of one frame as doubles, tiles of
+ * tile_height rows one after the other. Written in host byte order. */
+struct _DwtDumpHeader
+{
+	guint32 magic;
+	guint32 version;
+	guint32 width, height;
+	guint32 tile_height;
+	guint32 slots;
+	gchar wavelet[8];	/* name as the wavelet property takes it */
+	guint64 written;	/* frames ever written, the last in slot (written - 1) % slots */
+};
+
+struct _DwtDumpSlot
+{
+	guint64 sequence;	/* of the frame, counting from 0 */
+	guint64 pts;		/* GstClockTime, or G_MAXUINT64 for none */
+};
+
+/* A ring of frames of coefficients in a memory mapped file: the writer
+ * fills the slot of the next frame in place and the reader hands out
+ * pointers into the mapping, so neither side copies. */
+struct _DwtDump
+{
+	DwtDumpHeader *header;	/* the start of the mapping */
+	gsize size;		/* of the mapping */
+	gsize slot_size;	/* in bytes */
+	gboolean writable;
+};
+
+DwtDump *dwt_dump_create (const gchar *path, guint width, guint height,
+	guint tile_height, const gchar *wavelet, guint slots);
+DwtDump *dwt_dump_open (const gchar *path);
+void dwt_dump_close (DwtDump *dump);
+
+gdouble *dwt_dump_begin (DwtDump *dump);
+void dwt_dump_commit (DwtDump *dump, guint64 pts);
+
+guint dwt_dump_n_frames (const DwtDump *dump);
+const gdouble *dwt_dump_frame (const DwtDump *dump, guint index, guint64 *pts);
+
+G_END_DECLS
+
+#endif /* __DWT_DUMP_H__ */
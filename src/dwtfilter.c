@@ -0,0 +1,1002 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dwtfilter.h"
+
+/* the orders GSL accepts, the same for the centered variants */
+static const guint haar_orders[] = { 2 };
+static const guint daubechies_orders[] = { 4, 6, 8, 10, 12, 14, 16, 18, 20 };
+static const guint bspline_orders[] = { 103, 105, 202, 204, 206, 208, 301, 303, 305, 307, 309 };
+static const guint lifting_orders[] = { 202 };
+
+/* the 5/3 wavelet (bspline 202) as a predict and an update step, scaled
+ * to the DC gain of the GSL filters */
+static const DwtLifting lifting_53 = { 2, { -0.5, 0.25 }, M_SQRT2 };
+
+#define MAX_WAVELETS (2 * (G_N_ELEMENTS (haar_orders) + \
+	G_N_ELEMENTS (daubechies_orders) + G_N_ELEMENTS (bspline_orders)) + \
+	G_N_ELEMENTS (lifting_orders))
+
+static DwtWavelet wavelets[MAX_WAVELETS];
+static guint n_wavelets;
+
+/* without centered_type only the plain variant, with lifting the
+ * directional variant of every order */
+static void
+add_wavelets (gchar family, const gsl_wavelet_type *type,
+	const gsl_wavelet_type *centered_type, const guint *orders, guint n_orders,
+	const DwtLifting *lifting)
+{
+	guint c, i;
+
+	for (c = 0; c < (centered_type ? 2 : 1); c++)
+	{
+		for (i = 0; i < n_orders; i++)
+		{
+			DwtWavelet *w = &wavelets[n_wavelets];
+
+			w->gsl = gsl_wavelet_alloc (c ? centered_type : type, orders[i]);
+			if (w->gsl == NULL)
+				continue;
+			if (!dwt_kernel_init (&w->kernel, w->gsl))
+			{
+				gsl_wavelet_free (w->gsl);
+				continue;
+			}
+			w->family = family;
+			w->centered = c;
+			w->order = orders[i];
+			w->lifting = lifting;
+			n_wavelets++;
+		}
+	}
+}
+
+/* Builds the table of every wavelet the names can select. Called once,
+ * at plugin load; lookups would otherwise build it on first use. */
+void
+dwt_wavelets_init (void)
+{
+	static gsize done = 0;
+
+	if (g_once_init_enter (&done))
+	{
+		add_wavelets ('h', gsl_wavelet_haar, gsl_wavelet_haar_centered,
+			haar_orders, G_N_ELEMENTS (haar_orders), NULL);
+		add_wavelets ('d', gsl_wavelet_daubechies, gsl_wavelet_daubechies_centered,
+			daubechies_orders, G_N_ELEMENTS (daubechies_orders), NULL);
+		add_wavelets ('b', gsl_wavelet_bspline, gsl_wavelet_bspline_centered,
+			bspline_orders, G_N_ELEMENTS (bspline_orders), NULL);
+		add_wavelets ('l', gsl_wavelet_bspline, NULL,
+			lifting_orders, G_N_ELEMENTS (lifting_orders), &lifting_53);
+		g_once_init_leave (&done, 1);
+	}
+}
+
+/* The table entry of a wavelet name, NULL for malformed names and for
+ * combinations GSL does not provide. Allocates nothing. */
+const DwtWavelet *
+dwt_wavelet_lookup (const gchar *name)
+{
+	const gchar *p;
+	gboolean centered;
+	gchar family;
+	guint64 order = 0;
+	guint i;
+
+	if (name == NULL || name[0] == '\0')
+		return NULL;
+
+	family = g_ascii_tolower (name[0]);
+	p = name + 1;
+	centered = *p == 'c' || *p == 'C';
+	if (centered)
+		p++;
+	if (*p == '\0')
+		return NULL;
+	for (; *p != '\0'; p++)
+	{
+		if (!g_ascii_isdigit (*p) || order > 1000)
+			return NULL;
+		order = 10 * order + (*p - '0');
+	}
+
+	dwt_wavelets_init ();
+	for (i = 0; i < n_wavelets; i++)
+	{
+		if (wavelets[i].family == family && wavelets[i].centered == centered &&
+			wavelets[i].order == order)
+			return &wavelets[i];
+	}
+
+	return NULL;
+}
+
+/* coarsest level that still leaves at least one coefficient per dimension */
+guint
+dwt_max_level (guint width, guint height)
+{
+	guint level;
+
+	for (level = 0; (width >> (level + 1)) > 0 && (height >> (level + 1)) > 0; level++);
+
+	return level;
+}
+
+DwtPlan *
+dwt_plan_new (guint width, guint height)
+{
+	DwtPlan *plan = g_new0 (DwtPlan, 1);
+
+	plan->width = width;
+	plan->height = height;
+	plan->inverse = TRUE;
+	plan->mask = dwt_mask_new (width, height);
+
+	return plan;
+}
+
+void
+dwt_plan_free (DwtPlan *plan)
+{
+	if (plan == NULL)
+		return;
+
+	dwt_mask_free (plan->mask);
+	g_free (plan->bands);
+	g_free (plan->ext);
+	g_free (plan->packet_cost);
+	g_free (plan->packet_split);
+	g_free (plan->directions);
+	g_free (plan->lifting_rows);
+	g_free (plan);
+}
+
+DwtPlanCache *
+dwt_plan_cache_new (guint size)
+{
+	DwtPlanCache *cache = g_new0 (DwtPlanCache, 1);
+
+	cache->size = MAX (size, 1);
+	g_queue_init (&cache->plans);
+
+	return cache;
+}
+
+void
+dwt_plan_cache_free (DwtPlanCache *cache)
+{
+	if (cache == NULL)
+		return;
+
+	g_queue_clear_full (&cache->plans, (GDestroyNotify) dwt_plan_free);
+	g_free (cache);
+}
+
+/* The plan of that size, owned by the cache and valid until a later call
+ * evicts it: the one kept from before, or a new one pushing out the
+ * least recently used. The others give up their stationary planes, by
+ * far the largest part of a plan, until they are used again. */
+DwtPlan *
+dwt_plan_cache_get (DwtPlanCache *cache, guint width, guint height)
+{
+	DwtPlan *plan = NULL;
+	GList *l;
+
+	for (l = cache->plans.head; l != NULL; l = l->next)
+	{
+		plan = l->data;
+		if (plan->width == width && plan->height == height)
+		{
+			g_queue_unlink (&cache->plans, l);
+			g_queue_push_head_link (&cache->plans, l);
+			break;
+		}
+	}
+
+	if (l == NULL)
+	{
+		plan = dwt_plan_new (width, height);
+		g_queue_push_head (&cache->plans, plan);
+		if (g_queue_get_length (&cache->plans) > cache->size)
+			dwt_plan_free (g_queue_pop_tail (&cache->plans));
+	}
+
+	for (l = cache->plans.head->next; l != NULL; l = l->next)
+		dwt_plan_set_stationary (l->data, 0);
+
+	return plan;
+}
+
+void
+dwt_plan_set_kernel (DwtPlan *plan, const DwtKernel *kernel)
+{
+	plan->kernel = kernel;
+}
+
+void
+dwt_plan_set_inverse (DwtPlan *plan, gboolean inverse)
+{
+	plan->inverse = inverse;
+}
+
+/* in the stationary mode only the levels it computes have a preview */
+void
+dwt_plan_set_preview (DwtPlan *plan, guint level, gdouble *preview)
+{
+	plan->preview_level = MIN (level, dwt_max_level (plan->width, plan->height));
+	if (plan->stationary_levels > 0)
+		plan->preview_level = MIN (plan->preview_level, plan->stationary_levels);
+	plan->preview = plan->preview_level > 0 ? preview : NULL;
+}
+
+/* Switches to the stationary transform of the given number of levels,
+ * clamped like the decimated one, or back with 0. The planes are
+ * reallocated only when the depth changes. Returns FALSE, the plan left
+ * on the decimated transform, when they cannot be allocated. */
+gboolean
+dwt_plan_set_stationary (DwtPlan *plan, guint levels)
+{
+	gsize size = (gsize) plan->width * plan->height;
+
+	levels = MIN (levels, dwt_max_level (plan->width, plan->height));
+	if (levels == plan->stationary_levels)
+		return TRUE;
+
+	g_free (plan->bands);
+	g_free (plan->ext);
+	plan->bands = NULL;
+	plan->ext = NULL;
+	plan->stationary_levels = 0;
+
+	if (levels == 0)
+		return TRUE;
+
+	if (size <= G_MAXSIZE / (3 * levels + 2))
+	{
+		plan->bands = g_try_new (gdouble, (3 * levels + 2) * size);
+		plan->ext = g_try_new (gdouble, dwt_kernel_atrous_ext_size (
+					MAX (plan->width, plan->height), (gsize) 1 << (levels - 1)));
+	}
+	if (plan->bands == NULL || plan->ext == NULL)
+	{
+		g_free (plan->bands);
+		g_free (plan->ext);
+		plan->bands = NULL;
+		plan->ext = NULL;
+		return FALSE;
+	}
+	plan->stationary_levels = levels;
+
+	return TRUE;
+}
+
+/* Switches the decimated transform to wavelet packets splitting the
+ * detail bands up to levels more times, clamped to the levels of the
+ * frame and DWT_PACKET_MAX_LEVELS, or back with 0. The tree is one level
+ * deeper than that. Only the cost and the choice of every node are held,
+ * the packets are transformed in place. */
+void
+dwt_plan_set_packets (DwtPlan *plan, guint levels)
+{
+	guint max_level = dwt_max_level (plan->width, plan->height);
+	gsize nodes;
+
+	levels = MIN (levels, MIN (max_level > 0 ? max_level - 1 : 0,
+				DWT_PACKET_MAX_LEVELS));
+	if (levels == plan->packet_levels)
+		return;
+
+	g_free (plan->packet_cost);
+	g_free (plan->packet_split);
+	plan->packet_cost = NULL;
+	plan->packet_split = NULL;
+	plan->packet_levels = levels;
+
+	if (levels > 0)
+	{
+		nodes = (((gsize) 1 << (2 * (levels + 2))) - 1) / 3;
+		plan->packet_cost = g_new (gdouble, nodes);
+		plan->packet_split = g_new (guint8, nodes);
+	}
+}
+
+/* levels of the directional transform, as deep as the decimated one
+ * while the bands split evenly */
+static guint
+lifting_levels (guint width, guint height)
+{
+	guint levels = dwt_max_level (width, height), d;
+
+	for (d = 0; d < levels && ((width >> d) & 1) == 0 && ((height >> d) & 1) == 0; d++);
+
+	return d;
+}
+
+/* Switches the decimated transform to the directional lifting of a
+ * wavelet, or back to the kernel with NULL; the stationary and packet
+ * modes go first. The directions and the rows set aside are allocated
+ * only when the wavelet changes. */
+void
+dwt_plan_set_lifting (DwtPlan *plan, const DwtLifting *lifting)
+{
+	gsize n = 0;
+	guint d;
+
+	if (lifting == plan->lifting)
+		return;
+
+	g_free (plan->directions);
+	g_free (plan->lifting_rows);
+	plan->directions = NULL;
+	plan->lifting_rows = NULL;
+	plan->lifting = lifting;
+
+	if (lifting == NULL)
+		return;
+
+	for (d = 0; d < lifting_levels (plan->width, plan->height); d++)
+		n += dwt_lifting_directions (plan->width >> d, plan->height >> d);
+	plan->directions = g_new (gint8, MAX (n, 1));
+	plan->lifting_rows = g_new (gdouble, MAX ((gsize) (plan->height / 2) * plan->width, 1));
+}
+
+void
+dwt_plan_set_stats (DwtPlan *plan, DwtStats *stats)
+{
+	plan->stats = stats;
+}
+
+/* doubles of scratch dwt_plan_execute() needs */
+gsize
+dwt_plan_scratch_size (const DwtPlan *plan)
+{
+	return MAX (plan->width, plan->height);
+}
+
+/* DC gain of the low-pass filter, per dimension and level */
+static gdouble
+dc_gain (const DwtKernel *kern)
+{
+	gdouble gain = 0;
+	guint i;
+
+	for (i = 0; i < kern->nc; i++)
+		gain += kern->h1[i];
+
+	return gain;
+}
+
+/* The top-left (width >> level) x (height >> level) block of the
+ * transformed plane is the full transform of the LL band of that level,
+ * so transforming it back gives the downscaled image, up to the DC gain
+ * of the low-pass filter, (sum h1)^level in each direction. */
+static void
+finish_preview (const DwtPlan *plan, gdouble *scratch)
+{
+	guint width = plan->width >> plan->preview_level;
+	guint height = plan->height >> plan->preview_level;
+	gdouble scale = 1 / pow (dc_gain (plan->kernel), 2.0 * plan->preview_level);
+	gsize i;
+
+	dwt_transform_inverse (plan->kernel, plan->preview, width, height, scratch);
+
+	for (i = 0; i < (gsize) width * height; i++)
+		plan->preview[i] *= scale;
+}
+
+/* The a trous transform: every level filters the LL band of the previous
+ * one with the taps spaced 2^(level - 1) apart, rows into the two scratch
+ * planes and then columns into the new LL band (in data) and the three
+ * detail bands of the level. The subband gains of the mask are applied
+ * per band, bands that end up all zero are skipped on the way back.
+ * Without inverse, data is left holding the LL band of the last level on
+ * the scale of the input. */
+static void
+execute_stationary (const DwtPlan *plan, gdouble *data, gdouble *scratch)
+{
+	const DwtKernel *kern = plan->kernel;
+	const guint width = plan->width, height = plan->height;
+	const guint levels = plan->stationary_levels;
+	const gsize size = (gsize) width * height;
+	const gboolean windows = plan->mask->windows->len > 0;
+	const gdouble dc = dc_gain (kern);
+	gdouble *t1 = plan->bands + 3 * levels * size, *t2 = t1 + size;
+	gdouble ll_gain;
+	guint level, o, r;
+	gsize i;
+
+	for (level = 1; level <= levels; level++)
+	{
+		gsize d = (gsize) 1 << (level - 1);
+		gdouble *hl = plan->bands + 3 * (level - 1) * size;
+		gdouble *lh = hl + size, *hh = lh + size;
+
+		for (r = 0; r < height; r++)
+			dwt_kernel_atrous_forward_line (kern, data + r * width, width, d,
+					t1 + r * width, t2 + r * width, plan->ext);
+		dwt_kernel_atrous_forward_planes (kern, t1, width, height, d, data, lh);
+		dwt_kernel_atrous_forward_planes (kern, t2, width, height, d, hl, hh);
+
+		if (plan->preview && level == plan->preview_level)
+		{
+			guint pw = width >> level, ph = height >> level, x, y;
+			gdouble scale = 1 / pow (dc, 2.0 * level);
+
+			for (y = 0; y < ph; y++)
+				for (x = 0; x < pw; x++)
+					plan->preview[y * pw + x] = scale * data[(y << level) * width + (x << level)];
+		}
+
+		for (o = 0; o < 3; o++)
+		{
+			gdouble gain = dwt_mask_level_gain (plan->mask, level, DWT_SUBBAND_HL << o);
+
+			for (r = 0; gain != 1. && r < height; r++)
+				dwt_mask_scale_stationary_row (plan->mask, r, hl + o * size + r * width,
+						gain, scratch);
+		}
+	}
+
+	ll_gain = dwt_mask_level_gain (plan->mask, levels, DWT_SUBBAND_LL);
+	if (!plan->inverse)
+		ll_gain /= pow (dc, 2.0 * levels);
+	if (ll_gain != 1.)
+	{
+		for (i = 0; i < size; i++)
+			data[i] *= ll_gain;
+	}
+
+	if (!plan->inverse)
+		return;
+
+	for (level = levels; level >= 1; level--)
+	{
+		gsize d = (gsize) 1 << (level - 1);
+		gdouble *band[3];
+
+		for (o = 0; o < 3; o++)
+		{
+			band[o] = plan->bands + (3 * (level - 1) + o) * size;
+			if (!windows &&
+				dwt_mask_level_gain (plan->mask, level, DWT_SUBBAND_HL << o) == 0.)
+				band[o] = NULL;
+		}
+
+		dwt_kernel_atrous_inverse_planes (kern, data, band[1], width, height, d, t1);
+		if (band[0] || band[2])
+			dwt_kernel_atrous_inverse_planes (kern, band[0], band[2], width, height, d, t2);
+
+		for (r = 0; r < height; r++)
+			dwt_kernel_atrous_inverse_line (kern, t1 + r * width,
+					band[0] || band[2] ? t2 + r * width : NULL, width, d,
+					data + r * width, plan->ext);
+	}
+}
+
+/* The LL band of preview_level, reached on the way down the levels, as
+ * the preview: the top-left block scaled by the DC gain per dimension
+ * and level. */
+static void
+copy_preview (const DwtPlan *plan, const gdouble *data, gdouble dc)
+{
+	guint w = plan->width >> plan->preview_level, h = plan->height >> plan->preview_level;
+	gdouble scale = 1 / pow (dc, 2.0 * plan->preview_level);
+	guint x, y;
+
+	for (y = 0; y < h; y++)
+		for (x = 0; x < w; x++)
+			plan->preview[y * w + x] = scale * data[(gsize) y * plan->width + x];
+}
+
+/* Wavelet packets: one level of the 2D transform splits a block into its
+ * LL, HL, LH and HH quarters, which are nodes of the next depth at the
+ * same places in the plane. The LL chain is split to the last level,
+ * the detail nodes of depth 1 up to packet_levels more times, so the
+ * tree is packet_levels + 1 deep. The levels are non-standard (Mallat)
+ * ones, each splitting the LL block both ways, unlike the standard form
+ * of the dyadic transform that runs all levels down the columns before
+ * the rows: with packets the bands are squares of the same size. Node
+ * (bx, by) of depth d is the block bx * (width >> d), by * (height >> d),
+ * number (4^d - 1) / 3 + by * 2^d + bx of the tree. */
+
+#define PACKET_NODE(d, bx, by) (((1u << (2 * (d))) - 1) / 3 + ((by) << (d)) + (bx))
+
+/* additive entropy cost of Coifman and Wickerhauser, - sum c^2 ln c^2 */
+static gdouble
+entropy_cost (const gdouble *c, guint n)
+{
+	gdouble cost = 0;
+	guint i;
+
+	for (i = 0; i < n; i++)
+	{
+		gdouble v = c[i] * c[i];
+
+		if (v > 0)
+			cost -= v * log (v);
+	}
+
+	return cost;
+}
+
+/* One level of the transform of the w x h block at block. With cost, the
+ * costs of the quarters, taken while each row is in cache, go to the
+ * nodes at cost (LL), cost + 1 (HL) and pitch further down (LH, HH). */
+static void
+packet_split (const DwtKernel *kern, gdouble *block, guint stride, guint w, guint h,
+	gdouble *cost, guint pitch, gdouble *scratch)
+{
+	guint i;
+
+	for (i = 0; i < w; i++)
+		kern->forward_step (kern, block + i, stride, h, scratch);
+
+	if (cost)
+		cost[0] = cost[1] = cost[pitch] = cost[pitch + 1] = 0;
+	for (i = 0; i < h; i++)
+	{
+		gdouble *row = block + (gsize) i * stride;
+		guint q = i < h / 2 ? 0 : pitch;
+
+		kern->forward_step (kern, row, 1, w, scratch);
+		if (cost)
+		{
+			cost[q] += entropy_cost (row, w / 2);
+			cost[q + 1] += entropy_cost (row + w / 2, w / 2);
+		}
+	}
+}
+
+static void
+packet_merge (const DwtKernel *kern, gdouble *block, guint stride, guint w, guint h,
+	gdouble *scratch)
+{
+	guint i;
+
+	for (i = 0; i < h; i++)
+		kern->inverse_step (kern, block + (gsize) i * stride, 1, w, scratch);
+	for (i = 0; i < w; i++)
+		kern->inverse_step (kern, block + i, stride, h, scratch);
+}
+
+/* Splits (or with merge, merges back) every detail node of depth d whose
+ * packet_split entry equals split. */
+static void
+packet_pass (const DwtPlan *plan, gdouble *data, guint d, gboolean split,
+	gboolean merge, gdouble *scratch)
+{
+	guint w = plan->width >> d, h = plan->height >> d;
+	guint bx, by;
+
+	for (by = 0; by < 1u << d; by++)
+	{
+		for (bx = 0; bx < 1u << d; bx++)
+		{
+			guint node = PACKET_NODE (d, bx, by);
+			gdouble *block = data + (gsize) by * h * plan->width + bx * w;
+
+			if ((bx == 0 && by == 0) || plan->packet_split[node] != split)
+				continue;
+			if (merge)
+				packet_merge (plan->kernel, block, plan->width, w, h, scratch);
+			else
+				packet_split (plan->kernel, block, plan->width, w, h,
+						&plan->packet_cost[PACKET_NODE (d + 1, 2 * bx, 2 * by)], 2u << d, scratch);
+		}
+	}
+}
+
+/* Packets down to packet_levels are all computed, with their costs, in
+ * place; the best basis is then picked bottom up, a node staying whole
+ * when its cost is below the best of its children, and the nodes left
+ * whole are merged back from their children. Mask and inverse follow. */
+static void
+execute_packets (const DwtPlan *plan, gdouble *data, gdouble *scratch)
+{
+	const DwtKernel *kern = plan->kernel;
+	const guint levels = plan->packet_levels + 1;
+	guint ll_levels, d, bx, by, i;
+	gdouble *cost = plan->packet_cost;
+	guint8 *split = plan->packet_split;
+
+	/* the LL chain, leaving the preview on the way */
+	ll_levels = dwt_max_level (plan->width, plan->height);
+	for (d = 0; d <= ll_levels; d++)
+	{
+		guint w = plan->width >> d, h = plan->height >> d;
+
+		if (plan->preview && d == plan->preview_level)
+			copy_preview (plan, data, dc_gain (kern));
+		if (d == ll_levels)
+			break;
+		packet_split (kern, data, plan->width, w, h,
+				d < levels ? &cost[PACKET_NODE (d + 1, 0, 0)] : NULL, 2u << d, scratch);
+	}
+
+	/* every detail node above the last depth is split */
+	for (d = 1; d < levels; d++)
+	{
+		memset (split + PACKET_NODE (d, 0, 0), 0, (gsize) 1 << (2 * d));
+		packet_pass (plan, data, d, FALSE, FALSE, scratch);
+	}
+
+	/* best basis: cost becomes the best cost of the subtree */
+	for (d = levels - 1; d >= 1; d--)
+	{
+		for (by = 0; by < 1u << d; by++)
+		{
+			for (bx = 0; bx < 1u << d; bx++)
+			{
+				guint node = PACKET_NODE (d, bx, by);
+				gdouble children = cost[PACKET_NODE (d + 1, 2 * bx, 2 * by)] +
+					cost[PACKET_NODE (d + 1, 2 * bx + 1, 2 * by)] +
+					cost[PACKET_NODE (d + 1, 2 * bx, 2 * by + 1)] +
+					cost[PACKET_NODE (d + 1, 2 * bx + 1, 2 * by + 1)];
+
+				split[node] = children < cost[node];
+				cost[node] = MIN (cost[node], children);
+			}
+		}
+	}
+
+	/* below a node left whole nothing is split */
+	for (d = 2; d < levels; d++)
+	{
+		for (by = 0; by < 1u << d; by++)
+		{
+			for (bx = 0; bx < 1u << d; bx++)
+			{
+				guint parent = PACKET_NODE (d - 1, bx / 2, by / 2);
+
+				if (bx / 2 + by / 2 > 0 && !split[parent])
+					split[PACKET_NODE (d, bx, by)] = FALSE;
+			}
+		}
+	}
+
+	for (d = levels - 1; d >= 1; d--)
+		packet_pass (plan, data, d, FALSE, TRUE, scratch);
+
+	for (i = 0; i < plan->height; i++)
+		dwt_mask_apply_row (plan->mask, i, data + (gsize) i * plan->width);
+
+	if (!plan->inverse)
+		return;
+
+	for (d = levels - 1; d >= 1; d--)
+		packet_pass (plan, data, d, TRUE, TRUE, scratch);
+	for (d = ll_levels; d-- > 0;)
+		packet_merge (kern, data, plan->width, plan->width >> d, plan->height >> d, scratch);
+}
+
+/* The directional transform of the plane at data in place, down the
+ * levels of the LL band, leaving the preview and the statistics on the
+ * way. The directions go to the plan for lifting_inverse(). */
+static void
+lifting_forward (const DwtPlan *plan, gdouble *data, gdouble *scratch)
+{
+	const guint levels = lifting_levels (plan->width, plan->height);
+	gint8 *dirs = plan->directions;
+	guint d, i;
+
+	for (d = 0; d <= levels; d++)
+	{
+		guint w = plan->width >> d, h = plan->height >> d;
+
+		if (plan->preview && d == plan->preview_level)
+			copy_preview (plan, data, plan->lifting->scale);
+		if (d == levels)
+			break;
+		dwt_lifting_forward (plan->lifting, data, plan->width, w, h, dirs,
+				plan->lifting_rows, scratch);
+		dirs += dwt_lifting_directions (w, h);
+	}
+
+	for (i = 0; plan->stats && i < plan->height; i++)
+		dwt_stats_add_row (plan->stats, i, data + (gsize) i * plan->width);
+}
+
+static void
+lifting_inverse (const DwtPlan *plan, gdouble *data, gdouble *scratch)
+{
+	const guint levels = lifting_levels (plan->width, plan->height);
+	const gint8 *dirs = plan->directions;
+	guint d;
+
+	for (d = 0; d < levels; d++)
+		dirs += dwt_lifting_directions (plan->width >> d, plan->height >> d);
+
+	for (d = levels; d-- > 0;)
+	{
+		guint w = plan->width >> d, h = plan->height >> d;
+
+		dirs -= dwt_lifting_directions (w, h);
+		dwt_lifting_inverse (plan->lifting, data, plan->width, w, h, dirs,
+				plan->lifting_rows, scratch);
+	}
+}
+
+/* Forward transform, mask and inverse transform of the plane at data in
+ * place. The 2D transform is separable, so the column pass is done first
+ * and each row is then transformed, masked and (with inverse) transformed
+ * back while it is still in cache; the mask costs no extra sweep over the
+ * plane. The result matches gsl_wavelet2d_transform_forward()/_inverse()
+ * up to rounding. */
+void
+dwt_plan_execute (const DwtPlan *plan, gdouble *data, gdouble *scratch)
+{
+	const DwtKernel *kern = plan->kernel;
+	guint i;
+
+	if (plan->stationary_levels > 0)
+	{
+		execute_stationary (plan, data, scratch);
+		return;
+	}
+	if (plan->packet_levels > 0)
+	{
+		execute_packets (plan, data, scratch);
+		return;
+	}
+	if (plan->lifting)
+	{
+		lifting_forward (plan, data, scratch);
+		for (i = 0; i < plan->height; i++)
+			dwt_mask_apply_row (plan->mask, i, data + (gsize) i * plan->width);
+		if (plan->inverse)
+			lifting_inverse (plan, data, scratch);
+		return;
+	}
+
+	for (i = 0; i < plan->width; i++)
+		dwt_kernel_forward (kern, data + i, plan->width, plan->height, scratch);
+
+	for (i = 0; i < plan->height; i++)
+	{
+		gdouble *row = data + i * plan->width;
+
+		dwt_kernel_forward (kern, row, 1, plan->width, scratch);
+		if (plan->stats)
+			dwt_stats_add_row (plan->stats, i, row);
+		dwt_mask_apply_row (plan->mask, i, row);
+
+		if (plan->preview && i < (plan->height >> plan->preview_level))
+			memcpy (plan->preview + i * (plan->width >> plan->preview_level), row,
+					(plan->width >> plan->preview_level) * sizeof (gdouble));
+
+		if (plan->inverse)
+			dwt_kernel_inverse (kern, row, 1, plan->width, scratch);
+	}
+
+	if (plan->inverse)
+	{
+		for (i = 0; i < plan->width; i++)
+			dwt_kernel_inverse (kern, data + i, plan->width, plan->height, scratch);
+	}
+
+	if (plan->preview)
+		finish_preview (plan, scratch);
+}
+
+/* The forward half of dwt_plan_execute() without the mask: the decimated
+ * transform of the plane at data in place, for plans that share one
+ * forward transform through dwt_plan_synthesize() or that pick the mask
+ * from the statistics gathered on the way. Dyadic only, packet_levels
+ * is not looked at. The directions of a lifting plan stay in the plan,
+ * only its own dwt_plan_synthesize() can undo it. */
+void
+dwt_plan_forward (const DwtPlan *plan, gdouble *data, gdouble *scratch)
+{
+	const DwtKernel *kern = plan->kernel;
+	guint i;
+
+	if (plan->lifting)
+	{
+		lifting_forward (plan, data, scratch);
+		return;
+	}
+
+	for (i = 0; i < plan->width; i++)
+		dwt_kernel_forward (kern, data + i, plan->width, plan->height, scratch);
+
+	for (i = 0; i < plan->height; i++)
+	{
+		dwt_kernel_forward (kern, data + i * plan->width, 1, plan->width, scratch);
+		if (plan->stats)
+			dwt_stats_add_row (plan->stats, i, data + i * plan->width);
+	}
+}
+
+/* The other half: the coefficients left by dwt_plan_forward() at coefs,
+ * which are not modified unless they are data, masked into data and with
+ * inverse transformed back. Every row is copied, masked and transformed
+ * back while it is in cache, so each output costs the mask and the
+ * inverse only. Together
+ * they give what dwt_plan_execute() gives for the decimated transform. */
+void
+dwt_plan_synthesize (const DwtPlan *plan, const gdouble *coefs, gdouble *data,
+	gdouble *scratch)
+{
+	const DwtKernel *kern = plan->kernel;
+	guint i;
+
+	if (plan->lifting)
+	{
+		/* the preview was left by the forward half */
+		for (i = 0; i < plan->height; i++)
+		{
+			gdouble *row = data + i * plan->width;
+
+			if (coefs != data)
+				memcpy (row, coefs + i * plan->width, plan->width * sizeof (gdouble));
+			dwt_mask_apply_row (plan->mask, i, row);
+		}
+		if (plan->inverse)
+			lifting_inverse (plan, data, scratch);
+		return;
+	}
+
+	for (i = 0; i < plan->height; i++)
+	{
+		gdouble *row = data + i * plan->width;
+
+		if (coefs != data)
+			memcpy (row, coefs + i * plan->width, plan->width * sizeof (gdouble));
+		dwt_mask_apply_row (plan->mask, i, row);
+
+		if (plan->preview && i < (plan->height >> plan->preview_level))
+			memcpy (plan->preview + i * (plan->width >> plan->preview_level), row,
+					(plan->width >> plan->preview_level) * sizeof (gdouble));
+
+		if (plan->inverse)
+			dwt_kernel_inverse (kern, row, 1, plan->width, scratch);
+	}
+
+	if (plan->inverse)
+	{
+		for (i = 0; i < plan->width; i++)
+			dwt_kernel_inverse (kern, data + i, plan->width, plan->height, scratch);
+	}
+
+	if (plan->preview)
+		finish_preview (plan, scratch);
+}
+
+/* Inverse 2D transform of a plane left by dwt_plan_execute() without
+ * inverse; scratch holds MAX (width, height) doubles. */
+void
+dwt_transform_inverse (const DwtKernel *kern, gdouble *data, guint width,
+	guint height, gdouble *scratch)
+{
+	guint i;
+
+	for (i = 0; i < height; i++)
+		dwt_kernel_inverse (kern, data + i * width, 1, width, scratch);
+
+	for (i = 0; i < width; i++)
+		dwt_kernel_inverse (kern, data + i, width, height, scratch);
+}
+
+void
+dwt_plane_from_u8 (const guint8 *src, gdouble *dst, gsize n)
+{
+	gsize i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = src[i];
+}
+
+/* Rounds and saturates. Every element writes its pixels through here, so
+ * a plane gives the same bytes whichever element turns it back into
+ * GRAY8; high-pass planes go negative, which a plain cast leaves
+ * undefined. */
+void
+dwt_plane_to_u8 (const gdouble *src, guint8 *dst, gsize n)
+{
+	gsize i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = src[i] <= 0 ? 0 : src[i] >= 255 ? 255 : (guint8) (src[i] + 0.5);
+}
+
+/* parses "x,y,w,h;x,y,w,h;..." into DwtWindow entries */
+gboolean
+dwt_windows_parse (const gchar *str, GArray *windows)
+{
+	gchar **entries;
+	gboolean ret = TRUE;
+	guint i;
+
+	if (str == NULL)
+		return TRUE;
+
+	entries = g_strsplit (str, ";", -1);
+	for (i = 0; entries[i] != NULL && ret; i++)
+	{
+		DwtWindow win;
+
+		if (*g_strstrip (entries[i]) == '\0')
+			continue;
+
+		if (sscanf (entries[i], "%u , %u , %u , %u", &win.x, &win.y, &win.w, &win.h) != 4)
+			ret = FALSE;
+		else
+			g_array_append_val (windows, win);
+	}
+	g_strfreev (entries);
+
+	return ret;
+}
+
+/* draws the border of win in white, clipped to the image */
+void
+dwt_draw_window_outline (guint8 *data, guint width, guint height, const DwtWindow *win)
+{
+	guint right, bottom;
+	guint i;
+
+	if (win->x >= width || win->y >= height || win->w == 0 || win->h == 0)
+		return;
+
+	right = MIN ((guint64) win->x + win->w, width - 1);
+	bottom = MIN ((guint64) win->y + win->h, height - 1);
+
+	memset (data + win->x + win->y * width, 255, right - win->x + 1);
+	memset (data + win->x + bottom * width, 255, right - win->x + 1);
+
+	for (i = win->y; i <= bottom; i++)
+	{
+		data[win->x + i * width] = 255;
+		data[right + i * width] = 255;
+	}
+}
@@ -0,0 +1,171 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __DWT_FILTER_H__
+#define __DWT_FILTER_H__
+
+#include <glib.h>
+#include <gsl/gsl_wavelet.h>
+
+#include "dwtkernel.h"
+#include "dwtmask.h"
+#include "dwtstats.h"
+
+G_BEGIN_DECLS
+
+typedef struct _DwtWavelet   DwtWavelet;
+typedef struct _DwtPlan      DwtPlan;
+typedef struct _DwtPlanCache DwtPlanCache;
+
+/* deepest packet tree, 5461 nodes */
+#define DWT_PACKET_MAX_LEVELS 6
+
+/* One of the wavelets GSL provides, prepared once for the life of the
+ * process: the GSL wavelet and the kernel made from it. Names are a
+ * family letter (h)aar, (d)aubechies or (b)spline, an optional c for the
+ * centered variant and the order, e.g. "h2", "d4", "bc103". Family (l)
+ * is the directional lifting of the bspline of that order, "l202" the
+ * 5/3 wavelet; plans switched to it with dwt_plan_set_lifting() use the
+ * lifting, everything else its bspline kernel. */
+struct _DwtWavelet
+{
+	gchar family;		/* 'h', 'd', 'b' or 'l' */
+	gboolean centered;
+	guint order;
+	gsl_wavelet *gsl;
+	DwtKernel kernel;
+	const DwtLifting *lifting;	/* family 'l' only */
+};
+
+/* Forward transform, mask and optional inverse transform of
+ * width x height planes of doubles owned by the caller. A plan is the
+ * geometry, the wavelet kernel and the compiled mask; set the mask up
+ * through the dwt_mask_set_*() calls on plan->mask. One plan serves one
+ * thread. */
+struct _DwtPlan
+{
+	guint width, height;
+	const DwtKernel *kernel;	/* not owned */
+	gboolean inverse;
+	DwtMask *mask;
+
+	/* with preview, every execution also leaves the LL image of level
+	 * preview_level there: (width >> level) x (height >> level) pixels
+	 * on the scale of the input, not owned */
+	guint preview_level;
+	gdouble *preview;
+
+	/* with stationary_levels > 0 the undecimated (a trous) transform of
+	 * that many levels replaces the decimated one: shift invariant, at
+	 * the cost of 3 * levels + 2 planes held by the plan */
+	guint stationary_levels;
+	gdouble *bands;		/* HL, LH, HH of every level, then two planes of scratch */
+	gdouble *ext;		/* wrapped lines */
+
+	/* with packet_levels > 0 the detail bands of the decimated transform
+	 * are split up to that many more times wherever an entropy cost says
+	 * so (best basis), on non-standard levels; the mask applies to the
+	 * resulting layout */
+	guint packet_levels;
+	gdouble *packet_cost;	/* of every node of the packet tree */
+	guint8 *packet_split;	/* nodes of the best basis split further */
+
+	/* with lifting, the decimated transform is the directional lifting
+	 * of that wavelet instead of the separable kernel, level by level on
+	 * the LL band; the directions it picks are kept for the inverse */
+	const DwtLifting *lifting;	/* not owned */
+	gint8 *directions;	/* of every level, the finest first */
+	gdouble *lifting_rows;	/* odd rows set aside, half a plane */
+
+	/* with stats, the decimated dwt_plan_execute() and dwt_plan_forward()
+	 * add every transformed row to it before the mask, not owned */
+	DwtStats *stats;
+};
+
+/* The plans of the last few frame sizes, most recently used first, so a
+ * stream switching between resolutions finds its plans, masks compiled,
+ * instead of allocating new ones. */
+struct _DwtPlanCache
+{
+	guint size;		/* plans kept */
+	GQueue plans;
+};
+
+void dwt_wavelets_init (void);
+const DwtWavelet *dwt_wavelet_lookup (const gchar *name);
+guint dwt_max_level (guint width, guint height);
+
+DwtPlan *dwt_plan_new (guint width, guint height);
+void dwt_plan_free (DwtPlan *plan);
+
+DwtPlanCache *dwt_plan_cache_new (guint size);
+void dwt_plan_cache_free (DwtPlanCache *cache);
+DwtPlan *dwt_plan_cache_get (DwtPlanCache *cache, guint width, guint height);
+
+void dwt_plan_set_kernel (DwtPlan *plan, const DwtKernel *kernel);
+void dwt_plan_set_inverse (DwtPlan *plan, gboolean inverse);
+void dwt_plan_set_preview (DwtPlan *plan, guint level, gdouble *preview);
+gboolean dwt_plan_set_stationary (DwtPlan *plan, guint levels);
+void dwt_plan_set_packets (DwtPlan *plan, guint levels);
+void dwt_plan_set_lifting (DwtPlan *plan, const DwtLifting *lifting);
+void dwt_plan_set_stats (DwtPlan *plan, DwtStats *stats);
+
+gsize dwt_plan_scratch_size (const DwtPlan *plan);
+void dwt_plan_execute (const DwtPlan *plan, gdouble *data, gdouble *scratch);
+void dwt_plan_forward (const DwtPlan *plan, gdouble *data, gdouble *scratch);
+void dwt_plan_synthesize (const DwtPlan *plan, const gdouble *coefs, gdouble *data,
+	gdouble *scratch);
+
+void dwt_transform_inverse (const DwtKernel *kern, gdouble *data, guint width,
+	guint height, gdouble *scratch);
+
+void dwt_plane_from_u8 (const guint8 *src, gdouble *dst, gsize n);
+void dwt_plane_to_u8 (const gdouble *src, guint8 *dst, gsize n);
+
+gboolean dwt_windows_parse (const gchar *str, GArray *windows);
+void dwt_draw_window_outline (guint8 *data, guint width, guint height,
+	const DwtWindow *win);
+
+G_END_DECLS
+
+#endif /* __DWT_FILTER_H__ */
@@ -0,0 +1,863 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "dwtkernel.h"
+
+#if defined (__GNUC__)
+#  define DWT_INLINE static inline __attribute__ ((always_inline))
+#else
+#  define DWT_INLINE static inline
+#endif
+
+#if defined (__GNUC__) && !defined (__clang__) && __GNUC__ >= 8
+#  define DWT_UNROLL _Pragma ("GCC unroll 20")
+#else
+#  define DWT_UNROLL
+#endif
+
+/* The bodies below are instantiated with a constant nc by the wrappers
+ * further down, so the tap loops are unrolled and carry no length
+ * checks. A line of n coefficients is split into the even output
+ * positions [lo, hi) whose support lies inside the line and the edges,
+ * where GSL's wrap-around index (n - 1) & (i + nc * n - offset + k) is
+ * kept. The sums are accumulated in GSL's order. */
+
+DWT_INLINE void
+interior_range (const DwtKernel *kern, const guint nc, gsize n, gsize *lo, gsize *hi)
+{
+	if (n + kern->offset < nc)
+	{
+		*lo = *hi = n;
+		return;
+	}
+
+	*lo = (kern->offset + 1) & ~(gsize) 1;
+	*hi = MAX ((n + kern->offset - nc + 2) & ~(gsize) 1, *lo);
+}
+
+DWT_INLINE void
+forward_edge (const DwtKernel *kern, const guint nc, const gdouble *a,
+	gsize stride, gsize n, gsize i, gdouble *scratch)
+{
+	const gsize n1 = n - 1, nmod = nc * n - kern->offset;
+	gdouble h = 0, g = 0;
+	guint k;
+
+	DWT_UNROLL
+	for (k = 0; k < nc; k++)
+	{
+		gsize jf = n1 & (i + nmod + k);
+
+		h += kern->h1[k] * a[jf * stride];
+		g += kern->g1[k] * a[jf * stride];
+	}
+	scratch[i >> 1] = h;
+	scratch[(i >> 1) + (n >> 1)] = g;
+}
+
+DWT_INLINE void
+forward_step (const DwtKernel *kern, const guint nc, gdouble *a,
+	gsize stride, gsize n, gdouble *scratch)
+{
+	gsize lo, hi, i;
+	guint k;
+
+	interior_range (kern, nc, n, &lo, &hi);
+
+	for (i = 0; i < lo; i += 2)
+		forward_edge (kern, nc, a, stride, n, i, scratch);
+
+	for (i = lo; i < hi; i += 2)
+	{
+		const gdouble *p = a + (i - kern->offset) * stride;
+		gdouble h = 0, g = 0;
+
+		DWT_UNROLL
+		for (k = 0; k < nc; k++)
+		{
+			h += kern->h1[k] * p[k * stride];
+			g += kern->g1[k] * p[k * stride];
+		}
+		scratch[i >> 1] = h;
+		scratch[(i >> 1) + (n >> 1)] = g;
+	}
+
+	for (i = hi; i < n; i += 2)
+		forward_edge (kern, nc, a, stride, n, i, scratch);
+
+	for (i = 0; i < n; i++)
+		a[i * stride] = scratch[i];
+}
+
+DWT_INLINE void
+inverse_edge (const DwtKernel *kern, const guint nc, gdouble ai, gdouble ai1,
+	gsize n, gsize i, gdouble *scratch)
+{
+	const gsize n1 = n - 1, nmod = nc * n - kern->offset;
+	guint k;
+
+	DWT_UNROLL
+	for (k = 0; k < nc; k++)
+		scratch[n1 & (i + nmod + k)] += kern->h2[k] * ai + kern->g2[k] * ai1;
+}
+
+DWT_INLINE void
+inverse_step (const DwtKernel *kern, const guint nc, gdouble *a,
+	gsize stride, gsize n, gdouble *scratch)
+{
+	const gsize nh = n >> 1;
+	gsize lo, hi, i;
+	guint k;
+
+	interior_range (kern, nc, n, &lo, &hi);
+	memset (scratch, 0, n * sizeof (gdouble));
+
+	for (i = 0; i < lo; i += 2)
+		inverse_edge (kern, nc, a[(i >> 1) * stride], a[((i >> 1) + nh) * stride],
+				n, i, scratch);
+
+	for (i = lo; i < hi; i += 2)
+	{
+		gdouble *p = scratch + i - kern->offset;
+		gdouble ai = a[(i >> 1) * stride], ai1 = a[((i >> 1) + nh) * stride];
+
+		DWT_UNROLL
+		for (k = 0; k < nc; k++)
+			p[k] += kern->h2[k] * ai + kern->g2[k] * ai1;
+	}
+
+	for (i = hi; i < n; i += 2)
+		inverse_edge (kern, nc, a[(i >> 1) * stride], a[((i >> 1) + nh) * stride],
+				n, i, scratch);
+
+	for (i = 0; i < n; i++)
+		a[i * stride] = scratch[i];
+}
+
+/* rows (stride 1) get their own instance so the loads are contiguous */
+#define DWT_DEFINE_KERNEL(NC) \
+static void \
+forward_##NC (const DwtKernel *kern, gdouble *a, gsize stride, gsize n, gdouble *scratch) \
+{ \
+	if (stride == 1) \
+		forward_step (kern, NC, a, 1, n, scratch); \
+	else \
+		forward_step (kern, NC, a, stride, n, scratch); \
+} \
+static void \
+inverse_##NC (const DwtKernel *kern, gdouble *a, gsize stride, gsize n, gdouble *scratch) \
+{ \
+	if (stride == 1) \
+		inverse_step (kern, NC, a, 1, n, scratch); \
+	else \
+		inverse_step (kern, NC, a, stride, n, scratch); \
+}
+
+DWT_DEFINE_KERNEL (2)
+DWT_DEFINE_KERNEL (4)
+DWT_DEFINE_KERNEL (6)
+DWT_DEFINE_KERNEL (8)
+DWT_DEFINE_KERNEL (10)
+DWT_DEFINE_KERNEL (12)
+DWT_DEFINE_KERNEL (14)
+DWT_DEFINE_KERNEL (16)
+DWT_DEFINE_KERNEL (18)
+DWT_DEFINE_KERNEL (20)
+
+/* any other length, with nc read at run time */
+static void
+forward_generic (const DwtKernel *kern, gdouble *a, gsize stride, gsize n, gdouble *scratch)
+{
+	forward_step (kern, kern->nc, a, stride, n, scratch);
+}
+
+static void
+inverse_generic (const DwtKernel *kern, gdouble *a, gsize stride, gsize n, gdouble *scratch)
+{
+	inverse_step (kern, kern->nc, a, stride, n, scratch);
+}
+
+/* filter lengths of haar (2), daubechies (4 - 20) and bspline (4 - 20) */
+static const struct
+{
+	guint nc;
+	DwtKernelStep forward_step;
+	DwtKernelStep inverse_step;
+} kernels[] = {
+	{ 2, forward_2, inverse_2 },
+	{ 4, forward_4, inverse_4 },
+	{ 6, forward_6, inverse_6 },
+	{ 8, forward_8, inverse_8 },
+	{ 10, forward_10, inverse_10 },
+	{ 12, forward_12, inverse_12 },
+	{ 14, forward_14, inverse_14 },
+	{ 16, forward_16, inverse_16 },
+	{ 18, forward_18, inverse_18 },
+	{ 20, forward_20, inverse_20 },
+};
+
+/* Copies the taps of w and picks the steps for its length. Returns FALSE
+ * when the filter is longer than DWT_KERNEL_MAX_TAPS. */
+gboolean
+dwt_kernel_init (DwtKernel *kern, const gsl_wavelet *w)
+{
+	guint i;
+
+	if (w->nc == 0 || w->nc > DWT_KERNEL_MAX_TAPS)
+		return FALSE;
+
+	kern->nc = w->nc;
+	kern->offset = w->offset;
+	memcpy (kern->h1, w->h1, w->nc * sizeof (gdouble));
+	memcpy (kern->g1, w->g1, w->nc * sizeof (gdouble));
+	memcpy (kern->h2, w->h2, w->nc * sizeof (gdouble));
+	memcpy (kern->g2, w->g2, w->nc * sizeof (gdouble));
+
+	kern->forward_step = forward_generic;
+	kern->inverse_step = inverse_generic;
+	for (i = 0; i < G_N_ELEMENTS (kernels); i++)
+	{
+		if (kernels[i].nc == w->nc)
+		{
+			kern->forward_step = kernels[i].forward_step;
+			kern->inverse_step = kernels[i].inverse_step;
+			break;
+		}
+	}
+
+	return TRUE;
+}
+
+/* In place 1D transform of n (a power of two) coefficients spaced by
+ * stride, like gsl_wavelet_transform_forward(). scratch holds n doubles. */
+void
+dwt_kernel_forward (const DwtKernel *kern, gdouble *a, gsize stride,
+	gsize n, gdouble *scratch)
+{
+	gsize i;
+
+	for (i = n; i >= 2; i >>= 1)
+		kern->forward_step (kern, a, stride, i, scratch);
+}
+
+void
+dwt_kernel_inverse (const DwtKernel *kern, gdouble *a, gsize stride,
+	gsize n, gdouble *scratch)
+{
+	gsize i;
+
+	for (i = 2; i <= n; i <<= 1)
+		kern->inverse_step (kern, a, stride, i, scratch);
+}
+
+/* Stationary (à trous) filtering: no decimation, the taps of level j are
+ * spaced d = 2^(j - 1) apart and every position keeps both outputs. The
+ * loops run over the positions with the tap fixed, so they stream through
+ * contiguous doubles and vectorise. At even positions of level 1 the
+ * outputs equal the decimated step's. */
+
+/* the line wrapped around so that ext[j] = in[(j + shift) mod n] */
+static void
+wrap_line (const gdouble *in, gsize n, gssize shift, gdouble *ext, gsize len)
+{
+	gsize pos = ((shift % (gssize) n) + n) % n;
+	gsize done = 0;
+
+	while (done < len)
+	{
+		gsize chunk = MIN (n - pos, len - done);
+
+		memcpy (ext + done, in + pos, chunk * sizeof (gdouble));
+		done += chunk;
+		pos = 0;
+	}
+}
+
+static void
+tap_first (gdouble *out, const gdouble *in, gdouble c, gsize n)
+{
+	gsize i;
+
+	for (i = 0; i < n; i++)
+		out[i] = c * in[i];
+}
+
+static void
+tap_add (gdouble *out, const gdouble *in, gdouble c, gsize n)
+{
+	gsize i;
+
+	for (i = 0; i < n; i++)
+		out[i] += c * in[i];
+}
+
+/* doubles of ext the line functions need for lines of n and dilation d */
+gsize
+dwt_kernel_atrous_ext_size (gsize n, gsize d)
+{
+	return 2 * (n + d * (DWT_KERNEL_MAX_TAPS - 1));
+}
+
+/* lo[i] = sum h1[k] in[i + d (k - offset)], hi likewise with g1, the
+ * indices taken modulo n */
+void
+dwt_kernel_atrous_forward_line (const DwtKernel *kern, const gdouble *in,
+	gsize n, gsize d, gdouble *lo, gdouble *hi, gdouble *ext)
+{
+	guint k;
+
+	wrap_line (in, n, -(gssize) (d * kern->offset), ext, n + d * (kern->nc - 1));
+
+	tap_first (lo, ext, kern->h1[0], n);
+	tap_first (hi, ext, kern->g1[0], n);
+	for (k = 1; k < kern->nc; k++)
+	{
+		tap_add (lo, ext + k * d, kern->h1[k], n);
+		tap_add (hi, ext + k * d, kern->g1[k], n);
+	}
+}
+
+/* lo = sum h1[k] rows[k], hi likewise with g1, for nc rows of width
+ * doubles: one output row of the filtering along the columns */
+void
+dwt_kernel_atrous_forward_rows (const DwtKernel *kern, const gdouble *const *rows,
+	gsize width, gdouble *lo, gdouble *hi)
+{
+	guint k;
+
+	tap_first (lo, rows[0], kern->h1[0], width);
+	tap_first (hi, rows[0], kern->g1[0], width);
+	for (k = 1; k < kern->nc; k++)
+	{
+		tap_add (lo, rows[k], kern->h1[k], width);
+		tap_add (hi, rows[k], kern->g1[k], width);
+	}
+}
+
+/* The same along the columns of width x height planes, wrapping at the
+ * bottom. */
+void
+dwt_kernel_atrous_forward_planes (const DwtKernel *kern, const gdouble *in,
+	gsize width, gsize height, gsize d, gdouble *lo, gdouble *hi)
+{
+	const gdouble *rows[DWT_KERNEL_MAX_TAPS];
+	gsize shift = (d * kern->offset) % height;
+	gsize r;
+	guint k;
+
+	for (r = 0; r < height; r++)
+	{
+		for (k = 0; k < kern->nc; k++)
+			rows[k] = in + ((r + d * k + height - shift) % height) * width;
+
+		dwt_kernel_atrous_forward_rows (kern, rows, width, lo + r * width, hi + r * width);
+	}
+}
+
+/* out[m] = (sum h2[k] lo[m - d (k - offset)] + g2[k] hi[...]) / 2, which
+ * undoes the forward step. hi may be NULL for a band of zeros. */
+void
+dwt_kernel_atrous_inverse_line (const DwtKernel *kern, const gdouble *lo,
+	const gdouble *hi, gsize n, gsize d, gdouble *out, gdouble *ext)
+{
+	const gsize len = n + d * (kern->nc - 1);
+	const gssize shift = (gssize) d * ((gssize) kern->offset - kern->nc + 1);
+	gdouble *ext_hi = ext + len;
+	guint k, last = kern->nc - 1;
+
+	wrap_line (lo, n, shift, ext, len);
+	tap_first (out, ext + last * d, 0.5 * kern->h2[0], n);
+	for (k = 1; k < kern->nc; k++)
+		tap_add (out, ext + (last - k) * d, 0.5 * kern->h2[k], n);
+
+	if (hi == NULL)
+		return;
+
+	wrap_line (hi, n, shift, ext_hi, len);
+	for (k = 0; k < kern->nc; k++)
+		tap_add (out, ext_hi + (last - k) * d, 0.5 * kern->g2[k], n);
+}
+
+/* out = (sum h2[k] lo[k] + g2[k] hi[k]) / 2 where lo[k] and hi[k] are
+ * the rows r - d (k - offset); either may be NULL for a band of zeros */
+void
+dwt_kernel_atrous_inverse_rows (const DwtKernel *kern, const gdouble *const *lo,
+	const gdouble *const *hi, gsize width, gdouble *out)
+{
+	guint k;
+
+	if (lo != NULL)
+		tap_first (out, lo[0], 0.5 * kern->h2[0], width);
+	else
+		memset (out, 0, width * sizeof (gdouble));
+
+	for (k = 0; k < kern->nc; k++)
+	{
+		if (lo != NULL && k > 0)
+			tap_add (out, lo[k], 0.5 * kern->h2[k], width);
+		if (hi != NULL)
+			tap_add (out, hi[k], 0.5 * kern->g2[k], width);
+	}
+}
+
+void
+dwt_kernel_atrous_inverse_planes (const DwtKernel *kern, const gdouble *lo,
+	const gdouble *hi, gsize width, gsize height, gsize d, gdouble *out)
+{
+	const gdouble *lo_rows[DWT_KERNEL_MAX_TAPS], *hi_rows[DWT_KERNEL_MAX_TAPS];
+	gsize shift = (d * kern->offset) % height;
+	gsize r;
+	guint k;
+
+	for (r = 0; r < height; r++)
+	{
+		for (k = 0; k < kern->nc; k++)
+		{
+			gsize src = (r + shift + height - (d * k) % height) % height;
+
+			lo_rows[k] = lo ? lo + src * width : NULL;
+			hi_rows[k] = hi ? hi + src * width : NULL;
+		}
+
+		dwt_kernel_atrous_inverse_rows (kern, lo ? lo_rows : NULL,
+				hi ? hi_rows : NULL, width, out + r * width);
+	}
+}
+
+/* Directional lifting. One level splits a width x height block into its
+ * LL, HL, LH and HH quarters where the mask expects them: down the
+ * columns first, the even rows going to the top half and the odd ones to
+ * the bottom, then along the rows of each half, every row split into its
+ * even and odd columns. Lines are split before they are lifted, so every
+ * step runs over whole lines of contiguous doubles, one direction at a
+ * time, and vectorises. */
+
+#define N_BLOCKS(n) (((n) + DWT_DIRECTION_BLOCK - 1) / DWT_DIRECTION_BLOCK)
+
+/* the directions tried, the smaller shifts first so that they win ties */
+#define N_DIRECTIONS (2 * DWT_DIRECTION_MAX + 1)
+#define DIRECTION(i) ((i) & 1 ? (gint) ((i) + 1) / 2 : -(gint) ((i) / 2))
+
+DWT_INLINE gsize
+clamp_index (gssize i, gsize n)
+{
+	return i < 0 ? 0 : (gsize) i >= n ? n - 1 : (gsize) i;
+}
+
+/* [lo, hi) of [x0, x1) where x - m and x + m stay inside lines of n */
+DWT_INLINE void
+span_interior (gsize m, gsize x0, gsize x1, gsize n, gsize *lo, gsize *hi)
+{
+	*lo = MIN (MAX (x0, m), x1);
+	*hi = n > m ? MAX (MIN (x1, n - m), *lo) : *lo;
+}
+
+/* out[x] += c (a[x - d] + b[x + d]) over [x0, x1) of lines of n, the
+ * indices clamped to the line */
+static void
+lift_span (gdouble *out, const gdouble *a, const gdouble *b, gdouble c,
+	gssize d, gsize x0, gsize x1, gsize n)
+{
+	gsize lo, hi, x;
+
+	span_interior (ABS (d), x0, x1, n, &lo, &hi);
+	for (x = x0; x < lo; x++)
+		out[x] += c * (a[clamp_index ((gssize) x - d, n)] + b[clamp_index ((gssize) x + d, n)]);
+	for (x = lo; x < hi; x++)
+		out[x] += c * (a[x - d] + b[x + d]);
+	for (x = hi; x < x1; x++)
+		out[x] += c * (a[clamp_index ((gssize) x - d, n)] + b[clamp_index ((gssize) x + d, n)]);
+}
+
+/* sum of |o[x] + c (a[x - d] + b[x + d])|, the error of that prediction */
+static gdouble
+span_cost (const gdouble *o, const gdouble *a, const gdouble *b, gdouble c,
+	gssize d, gsize x0, gsize x1, gsize n)
+{
+	gdouble cost = 0;
+	gsize lo, hi, x;
+
+	span_interior (ABS (d), x0, x1, n, &lo, &hi);
+	for (x = x0; x < lo; x++)
+		cost += fabs (o[x] + c * (a[clamp_index ((gssize) x - d, n)] +
+					b[clamp_index ((gssize) x + d, n)]));
+	for (x = lo; x < hi; x++)
+		cost += fabs (o[x] + c * (a[x - d] + b[x + d]));
+	for (x = hi; x < x1; x++)
+		cost += fabs (o[x] + c * (a[clamp_index ((gssize) x - d, n)] +
+					b[clamp_index ((gssize) x + d, n)]));
+
+	return cost;
+}
+
+/* one step over a line of n, running the blocks of equal direction as
+ * one span */
+static void
+lift_line (gdouble *out, const gdouble *a, const gdouble *b, gdouble c,
+	const gint8 *dirs, gsize n)
+{
+	gsize nb = N_BLOCKS (n), j, end;
+
+	for (j = 0; j < nb; j = end)
+	{
+		for (end = j + 1; end < nb && dirs[end] == dirs[j]; end++);
+		lift_span (out, a, b, c, dirs[j], j * DWT_DIRECTION_BLOCK,
+				MIN (end * DWT_DIRECTION_BLOCK, n), n);
+	}
+}
+
+/* Down the columns: pair k is the even row k of the top half and the odd
+ * row k, set aside in odd (height / 2 rows of width) while the block is
+ * lifted. Predictions shift along the rows. */
+static void
+columns_forward (const DwtLifting *lift, gdouble *block, gsize stride, guint w,
+	guint h, gint8 *dirs, gdouble *odd)
+{
+	const guint n = h / 2, nb = N_BLOCKS (w);
+	guint i, j, k, s;
+
+	for (k = 0; k < n; k++)
+	{
+		memcpy (odd + (gsize) k * w, block + (2 * k + 1) * stride, w * sizeof (gdouble));
+		if (k > 0)
+			memcpy (block + k * stride, block + 2 * k * stride, w * sizeof (gdouble));
+	}
+
+	for (k = 0; k < n; k++)
+	{
+		const gdouble *e0 = block + k * stride, *e1 = block + MIN (k + 1, n - 1) * stride;
+
+		for (j = 0; j < nb; j++)
+		{
+			gsize x0 = j * DWT_DIRECTION_BLOCK, x1 = MIN (x0 + DWT_DIRECTION_BLOCK, w);
+			gdouble best = G_MAXDOUBLE;
+
+			for (i = 0; i < N_DIRECTIONS; i++)
+			{
+				gdouble cost = span_cost (odd + (gsize) k * w, e0, e1, lift->steps[0],
+						DIRECTION (i), x0, x1, w);
+
+				if (cost < best)
+				{
+					best = cost;
+					dirs[k * nb + j] = DIRECTION (i);
+				}
+			}
+		}
+	}
+
+	for (s = 0; s < lift->n_steps; s++)
+	{
+		for (k = 0; k < n; k++)
+		{
+			gdouble *e = block + k * stride, *o = odd + (gsize) k * w;
+
+			if (s % 2 == 0)
+				lift_line (o, e, block + MIN (k + 1, n - 1) * stride, lift->steps[s],
+						dirs + k * nb, w);
+			else
+				lift_line (e, odd + (gsize) (k > 0 ? k - 1 : 0) * w, o, lift->steps[s],
+						dirs + k * nb, w);
+		}
+	}
+
+	for (k = 0; k < n; k++)
+	{
+		gdouble *e = block + k * stride, *o = block + (n + k) * stride;
+		const gdouble *src = odd + (gsize) k * w;
+
+		for (i = 0; i < w; i++)
+		{
+			e[i] *= lift->scale;
+			o[i] = src[i] / lift->scale;
+		}
+	}
+}
+
+static void
+columns_inverse (const DwtLifting *lift, gdouble *block, gsize stride, guint w,
+	guint h, const gint8 *dirs, gdouble *odd)
+{
+	const guint n = h / 2, nb = N_BLOCKS (w);
+	guint i, k, s;
+
+	for (k = 0; k < n; k++)
+	{
+		gdouble *e = block + k * stride, *dst = odd + (gsize) k * w;
+		const gdouble *o = block + (n + k) * stride;
+
+		for (i = 0; i < w; i++)
+		{
+			e[i] /= lift->scale;
+			dst[i] = o[i] * lift->scale;
+		}
+	}
+
+	for (s = lift->n_steps; s-- > 0;)
+	{
+		for (k = 0; k < n; k++)
+		{
+			gdouble *e = block + k * stride, *o = odd + (gsize) k * w;
+
+			if (s % 2 == 0)
+				lift_line (o, e, block + MIN (k + 1, n - 1) * stride, -lift->steps[s],
+						dirs + k * nb, w);
+			else
+				lift_line (e, odd + (gsize) (k > 0 ? k - 1 : 0) * w, o, -lift->steps[s],
+						dirs + k * nb, w);
+		}
+	}
+
+	for (k = n; k-- > 0;)
+	{
+		if (k > 0)
+			memcpy (block + 2 * k * stride, block + k * stride, w * sizeof (gdouble));
+		memcpy (block + (2 * k + 1) * stride, odd + (gsize) k * w, w * sizeof (gdouble));
+	}
+}
+
+/* Along the rows of a block of h rows: the even columns of a row go to
+ * its first half, the odd ones to the second, and pair k is column k of
+ * both halves. Predictions shift across the rows, d rows per column:
+ * o[k] of row y takes e[k] of row y - d and e[k + 1] of row y + d. */
+static void
+row_span (gdouble *out, const gdouble *a, const gdouble *b, gdouble c,
+	gboolean predict, gsize x0, gsize x1, gsize n)
+{
+	gsize x;
+
+	if (predict)
+	{
+		for (x = x0; x < MIN (x1, n - 1); x++)
+			out[x] += c * (a[x] + b[x + 1]);
+		if (x1 == n)
+			out[n - 1] += c * (a[n - 1] + b[n - 1]);
+	}
+	else
+	{
+		if (x0 == 0)
+			out[0] += c * (a[0] + b[0]);
+		for (x = MAX (x0, 1); x < x1; x++)
+			out[x] += c * (a[x - 1] + b[x]);
+	}
+}
+
+static gdouble
+row_cost (const gdouble *o, const gdouble *a, const gdouble *b, gdouble c,
+	gsize x0, gsize x1, gsize n)
+{
+	gdouble cost = 0;
+	gsize x;
+
+	for (x = x0; x < MIN (x1, n - 1); x++)
+		cost += fabs (o[x] + c * (a[x] + b[x + 1]));
+	if (x1 == n)
+		cost += fabs (o[n - 1] + c * (a[n - 1] + b[n - 1]));
+
+	return cost;
+}
+
+static void
+rows_step (gdouble *block, gsize stride, guint w, guint h, const gint8 *dirs,
+	gdouble c, gboolean predict)
+{
+	const guint n = w / 2, nb = N_BLOCKS (n);
+	guint j, y;
+
+	for (y = 0; y < h; y++)
+	{
+		gdouble *row = block + y * stride;
+
+		for (j = 0; j < nb; j++)
+		{
+			gssize d = dirs[y * nb + j];
+			const gdouble *a = block + clamp_index ((gssize) y - d, h) * stride;
+			const gdouble *b = block + clamp_index ((gssize) y + d, h) * stride;
+
+			if (predict)
+				row_span (row + n, a, b, c, TRUE, j * DWT_DIRECTION_BLOCK,
+						MIN ((j + 1) * DWT_DIRECTION_BLOCK, n), n);
+			else
+				row_span (row, a + n, b + n, c, FALSE, j * DWT_DIRECTION_BLOCK,
+						MIN ((j + 1) * DWT_DIRECTION_BLOCK, n), n);
+		}
+	}
+}
+
+static void
+rows_forward (const DwtLifting *lift, gdouble *block, gsize stride, guint w,
+	guint h, gint8 *dirs, gdouble *scratch)
+{
+	const guint n = w / 2, nb = N_BLOCKS (n);
+	guint i, j, s, y;
+
+	for (y = 0; y < h; y++)
+	{
+		gdouble *row = block + y * stride;
+
+		for (i = 0; i < n; i++)
+		{
+			scratch[i] = row[2 * i];
+			scratch[n + i] = row[2 * i + 1];
+		}
+		memcpy (row, scratch, w * sizeof (gdouble));
+	}
+
+	for (y = 0; y < h; y++)
+	{
+		for (j = 0; j < nb; j++)
+		{
+			gsize x0 = j * DWT_DIRECTION_BLOCK, x1 = MIN (x0 + DWT_DIRECTION_BLOCK, n);
+			gdouble best = G_MAXDOUBLE;
+
+			for (i = 0; i < N_DIRECTIONS; i++)
+			{
+				gssize d = DIRECTION (i);
+				gdouble cost = row_cost (block + y * stride + n,
+						block + clamp_index ((gssize) y - d, h) * stride,
+						block + clamp_index ((gssize) y + d, h) * stride,
+						lift->steps[0], x0, x1, n);
+
+				if (cost < best)
+				{
+					best = cost;
+					dirs[y * nb + j] = d;
+				}
+			}
+		}
+	}
+
+	for (s = 0; s < lift->n_steps; s++)
+		rows_step (block, stride, w, h, dirs, lift->steps[s], s % 2 == 0);
+
+	for (y = 0; y < h; y++)
+	{
+		gdouble *row = block + y * stride;
+
+		for (i = 0; i < n; i++)
+		{
+			row[i] *= lift->scale;
+			row[n + i] /= lift->scale;
+		}
+	}
+}
+
+static void
+rows_inverse (const DwtLifting *lift, gdouble *block, gsize stride, guint w,
+	guint h, const gint8 *dirs, gdouble *scratch)
+{
+	const guint n = w / 2;
+	guint i, s, y;
+
+	for (y = 0; y < h; y++)
+	{
+		gdouble *row = block + y * stride;
+
+		for (i = 0; i < n; i++)
+		{
+			row[i] /= lift->scale;
+			row[n + i] *= lift->scale;
+		}
+	}
+
+	for (s = lift->n_steps; s-- > 0;)
+		rows_step (block, stride, w, h, dirs, -lift->steps[s], s % 2 == 0);
+
+	for (y = 0; y < h; y++)
+	{
+		gdouble *row = block + y * stride;
+
+		for (i = 0; i < n; i++)
+		{
+			scratch[2 * i] = row[i];
+			scratch[2 * i + 1] = row[n + i];
+		}
+		memcpy (row, scratch, w * sizeof (gdouble));
+	}
+}
+
+/* directions one level of a width x height block chooses */
+gsize
+dwt_lifting_directions (guint width, guint height)
+{
+	return (gsize) (height / 2) * N_BLOCKS (width) + (gsize) height * N_BLOCKS (width / 2);
+}
+
+/* One level of the directional transform of the width x height block at
+ * block, both even, in place, the directions it picks left in dirs.
+ * odd holds height / 2 rows of width, scratch width doubles. */
+void
+dwt_lifting_forward (const DwtLifting *lift, gdouble *block, gsize stride,
+	guint width, guint height, gint8 *dirs, gdouble *odd, gdouble *scratch)
+{
+	const guint half = height / 2;
+	const gsize columns = (gsize) half * N_BLOCKS (width);
+	const gsize rows = (gsize) half * N_BLOCKS (width / 2);
+
+	columns_forward (lift, block, stride, width, height, dirs, odd);
+	rows_forward (lift, block, stride, width, half, dirs + columns, scratch);
+	rows_forward (lift, block + half * stride, stride, width, half,
+			dirs + columns + rows, scratch);
+}
+
+/* undoes dwt_lifting_forward() with the directions it picked */
+void
+dwt_lifting_inverse (const DwtLifting *lift, gdouble *block, gsize stride,
+	guint width, guint height, const gint8 *dirs, gdouble *odd, gdouble *scratch)
+{
+	const guint half = height / 2;
+	const gsize columns = (gsize) half * N_BLOCKS (width);
+	const gsize rows = (gsize) half * N_BLOCKS (width / 2);
+
+	rows_inverse (lift, block, stride, width, half, dirs + columns, scratch);
+	rows_inverse (lift, block + half * stride, stride, width, half,
+			dirs + columns + rows, scratch);
+	columns_inverse (lift, block, stride, width, height, dirs, odd);
+}
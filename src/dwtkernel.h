@@ -0,0 +1,125 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __DWT_KERNEL_H__
+#define __DWT_KERNEL_H__
+
+#include <glib.h>
+#include <gsl/gsl_wavelet.h>
+
+G_BEGIN_DECLS
+
+/* longest filter of the GSL families (daub20, bspline 309) */
+#define DWT_KERNEL_MAX_TAPS 20
+
+typedef struct _DwtKernel DwtKernel;
+typedef struct _DwtLifting DwtLifting;
+
+typedef void (*DwtKernelStep) (const DwtKernel *kern, gdouble *a, gsize stride,
+	gsize n, gdouble *scratch);
+
+/* One wavelet prepared for the transform: its taps and the step functions
+ * compiled for its filter length. The steps compute what GSL's dwt_step()
+ * does with the wrap-around index only at the edges of the line. */
+struct _DwtKernel
+{
+	guint nc;
+	guint offset;		/* nc / 2 for the centered variants, else 0 */
+	gdouble h1[DWT_KERNEL_MAX_TAPS], g1[DWT_KERNEL_MAX_TAPS];
+	gdouble h2[DWT_KERNEL_MAX_TAPS], g2[DWT_KERNEL_MAX_TAPS];
+
+	DwtKernelStep forward_step;
+	DwtKernelStep inverse_step;
+};
+
+/* Directional lifting: the neighbours of every predict and update step
+ * lie along a direction d, d samples across the lifting axis per sample
+ * along it, |d| <= DWT_DIRECTION_MAX. The forward transform picks d for
+ * every DWT_DIRECTION_BLOCK samples of a line by the smallest error of
+ * the first prediction, so edges that are neither horizontal nor
+ * vertical leave little in the detail bands. */
+#define DWT_DIRECTION_MAX   2
+#define DWT_DIRECTION_BLOCK 16
+
+/* A biorthogonal wavelet factored into lifting steps, alternately
+ * predicting the odd samples from the even ones and updating the even
+ * ones from the odd, the halves then scaled by scale and 1 / scale. The
+ * lines are extended symmetrically along the lifting axis and clamped
+ * across it. */
+struct _DwtLifting
+{
+	guint n_steps;
+	gdouble steps[4];
+	gdouble scale;
+};
+
+gboolean dwt_kernel_init (DwtKernel *kern, const gsl_wavelet *w);
+
+void dwt_kernel_forward (const DwtKernel *kern, gdouble *a, gsize stride,
+	gsize n, gdouble *scratch);
+void dwt_kernel_inverse (const DwtKernel *kern, gdouble *a, gsize stride,
+	gsize n, gdouble *scratch);
+
+gsize dwt_kernel_atrous_ext_size (gsize n, gsize d);
+void dwt_kernel_atrous_forward_line (const DwtKernel *kern, const gdouble *in,
+	gsize n, gsize d, gdouble *lo, gdouble *hi, gdouble *ext);
+void dwt_kernel_atrous_forward_rows (const DwtKernel *kern,
+	const gdouble *const *rows, gsize width, gdouble *lo, gdouble *hi);
+void dwt_kernel_atrous_forward_planes (const DwtKernel *kern, const gdouble *in,
+	gsize width, gsize height, gsize d, gdouble *lo, gdouble *hi);
+void dwt_kernel_atrous_inverse_line (const DwtKernel *kern, const gdouble *lo,
+	const gdouble *hi, gsize n, gsize d, gdouble *out, gdouble *ext);
+void dwt_kernel_atrous_inverse_rows (const DwtKernel *kern,
+	const gdouble *const *lo, const gdouble *const *hi, gsize width, gdouble *out);
+void dwt_kernel_atrous_inverse_planes (const DwtKernel *kern, const gdouble *lo,
+	const gdouble *hi, gsize width, gsize height, gsize d, gdouble *out);
+
+gsize dwt_lifting_directions (guint width, guint height);
+void dwt_lifting_forward (const DwtLifting *lift, gdouble *block, gsize stride,
+	guint width, guint height, gint8 *dirs, gdouble *odd, gdouble *scratch);
+void dwt_lifting_inverse (const DwtLifting *lift, gdouble *block, gsize stride,
+	guint width, guint height, const gint8 *dirs, gdouble *odd, gdouble *scratch);
+
+G_END_DECLS
+
+#endif /* __DWT_KERNEL_H__ */
@@ -0,0 +1,353 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "dwtlines.h"
+
+/* Rows are indexed like in the frame, from -reach above it to
+ * height - 1 + reach below it, and kept in rings of span rows. Level j
+ * (d = 2^(j - 1)) filters every row it is given across and keeps the last
+ * (nc - 1) d + 1 of them, enough to filter down the column for the row
+ * (nc - 1 - offset) d above the newest. Its details wait in a ring until
+ * the inverse of the level, which runs offset d rows behind the LL rows it
+ * gets back from the coarser level, has used them. */
+struct _DwtLinesLevel
+{
+	gsize d;
+	guint span;		/* (nc - 1) d + 1 */
+	gdouble *lo, *hi;	/* rows filtered across */
+	guint64 n_in;
+	gdouble *ll;		/* LL row handed to the next level */
+
+	guint band_span;	/* span + the delay of the coarser levels */
+	gdouble *bands;		/* HL, LH, HH rings */
+	gdouble gains[3];
+	gboolean zero[3];	/* dropped on the way back */
+
+	gdouble *rec;		/* reconstructed LL rows */
+	guint64 n_rec;
+	gdouble *out;		/* row handed to the finer level */
+};
+
+static gdouble *ring_row (gdouble *ring, guint span, guint width, gint64 idx);
+static void scale_row (const DwtLines *lines, gint64 m, gdouble *row, gdouble gain);
+static void forward (DwtLines *lines, guint level, gint64 idx, const gdouble *row);
+static void inverse (DwtLines *lines, guint level, gint64 idx, const gdouble *ll);
+static void free_levels (DwtLines *lines);
+
+DwtLines *
+dwt_lines_new (guint width, guint height, guint levels)
+{
+	DwtLines *lines = g_new0 (DwtLines, 1);
+
+	lines->width = width;
+	lines->height = height;
+	lines->levels = levels;
+	lines->inverse = TRUE;
+	lines->mask = dwt_mask_new_levels (width, height);
+
+	return lines;
+}
+
+void
+dwt_lines_free (DwtLines *lines)
+{
+	if (lines == NULL)
+		return;
+
+	free_levels (lines);
+	dwt_mask_free (lines->mask);
+	g_free (lines);
+}
+
+void
+dwt_lines_set_kernel (DwtLines *lines, const DwtKernel *kernel)
+{
+	lines->kernel = kernel;
+}
+
+void
+dwt_lines_set_inverse (DwtLines *lines, gboolean inverse)
+{
+	lines->inverse = inverse;
+}
+
+/* preview holds (width >> level) x (height >> level) doubles, NULL or
+ * level 0 for none */
+void
+dwt_lines_set_preview (DwtLines *lines, guint level, gdouble *preview)
+{
+	lines->preview_level = MIN (level, lines->levels);
+	lines->preview = lines->preview_level > 0 ? preview : NULL;
+}
+
+/* Starts a frame: the rings are sized for the taps of the current kernel
+ * and the gains are read from the mask. */
+void
+dwt_lines_begin (DwtLines *lines, DwtLinesOutput output, gpointer user_data)
+{
+	const DwtKernel *kern = lines->kernel;
+	const guint width = lines->width, levels = lines->levels;
+	guint j, o, i;
+
+	if (lines->level == NULL || lines->nc != kern->nc)
+	{
+		free_levels (lines);
+
+		lines->nc = kern->nc;
+		lines->reach = (kern->nc - 1) * ((1u << levels) - 1);
+		lines->level = g_new0 (DwtLinesLevel, levels);
+		for (j = 1; j <= levels; j++)
+		{
+			DwtLinesLevel *lv = &lines->level[j - 1];
+
+			lv->d = (gsize) 1 << (j - 1);
+			lv->span = (kern->nc - 1) * lv->d + 1;
+			lv->band_span = lv->span + (kern->nc - 1) * ((1u << levels) - (1u << j));
+			lv->lo = g_new (gdouble, 2 * lv->span * width);
+			lv->hi = lv->lo + lv->span * width;
+			lv->bands = g_new (gdouble, 3 * lv->band_span * width);
+			lv->rec = g_new (gdouble, (lv->span + 2) * width);
+			lv->ll = lv->rec + lv->span * width;
+			lv->out = lv->ll + width;
+		}
+		lines->t1 = g_new (gdouble, 2 * width);
+		lines->t2 = lines->t1 + width;
+		lines->ext = g_new (gdouble,
+				dwt_kernel_atrous_ext_size (width, (gsize) 1 << (levels - 1)));
+	}
+
+	for (j = 1; j <= levels; j++)
+	{
+		DwtLinesLevel *lv = &lines->level[j - 1];
+
+		lv->n_in = lv->n_rec = 0;
+		for (o = 0; o < 3; o++)
+		{
+			lv->gains[o] = dwt_mask_level_gain (lines->mask, j, DWT_SUBBAND_HL << o);
+			lv->zero[o] = lv->gains[o] == 0. && lines->mask->windows->len == 0;
+		}
+	}
+
+	for (lines->dc = 0, i = 0; i < kern->nc; i++)
+		lines->dc += kern->h1[i];
+	lines->ll_gain = dwt_mask_level_gain (lines->mask, levels, DWT_SUBBAND_LL);
+	if (!lines->inverse)
+		lines->ll_gain /= pow (lines->dc, 2.0 * levels);
+
+	lines->next = -(gint64) lines->reach;
+	lines->output = output;
+	lines->user_data = user_data;
+}
+
+/* Pushes the next of the height rows of the frame. The rows above and
+ * below it are the first and last one repeated. */
+void
+dwt_lines_push (DwtLines *lines, const gdouble *row)
+{
+	if (lines->next == -(gint64) lines->reach)
+	{
+		while (lines->next < 0)
+			forward (lines, 1, lines->next++, row);
+	}
+
+	forward (lines, 1, lines->next++, row);
+
+	if (lines->next == lines->height)
+	{
+		while (lines->next < (gint64) lines->height + lines->reach)
+			forward (lines, 1, lines->next++, row);
+	}
+}
+
+static gdouble *
+ring_row (gdouble *ring, guint span, guint width, gint64 idx)
+{
+	gint64 slot = idx % span;
+
+	return ring + (gsize) (slot < 0 ? slot + span : slot) * width;
+}
+
+/* row m of a detail band, rows outside the frame have no windows */
+static void
+scale_row (const DwtLines *lines, gint64 m, gdouble *row, gdouble gain)
+{
+	guint x;
+
+	if (m >= 0 && m < lines->height)
+		dwt_mask_scale_stationary_row (lines->mask, m, row, gain, lines->t1);
+	else if (gain == 0.)
+		memset (row, 0, lines->width * sizeof (gdouble));
+	else if (gain != 1.)
+	{
+		for (x = 0; x < lines->width; x++)
+			row[x] *= gain;
+	}
+}
+
+/* row idx of the LL band of level - 1 (the frame for level 1) */
+static void
+forward (DwtLines *lines, guint level, gint64 idx, const gdouble *row)
+{
+	DwtLinesLevel *lv = &lines->level[level - 1];
+	const DwtKernel *kern = lines->kernel;
+	const guint width = lines->width, nc = kern->nc;
+	const gdouble *rows[DWT_KERNEL_MAX_TAPS];
+	gdouble *band[3];
+	gint64 m;
+	guint k, o;
+
+	dwt_kernel_atrous_forward_line (kern, row, width, lv->d,
+			ring_row (lv->lo, lv->span, width, idx),
+			ring_row (lv->hi, lv->span, width, idx), lines->ext);
+	if (++lv->n_in < lv->span)
+		return;
+
+	m = idx - (gint64) ((nc - 1 - kern->offset) * lv->d);
+	for (o = 0; o < 3; o++)
+		band[o] = ring_row (lv->bands + o * lv->band_span * width, lv->band_span, width, m);
+
+	for (k = 0; k < nc; k++)
+		rows[k] = ring_row (lv->lo, lv->span, width,
+				m + (gint64) lv->d * k - (gint64) lv->d * kern->offset);
+	dwt_kernel_atrous_forward_rows (kern, rows, width, lv->ll, band[1]);
+	for (k = 0; k < nc; k++)
+		rows[k] = ring_row (lv->hi, lv->span, width,
+				m + (gint64) lv->d * k - (gint64) lv->d * kern->offset);
+	dwt_kernel_atrous_forward_rows (kern, rows, width, band[0], band[2]);
+
+	for (o = 0; o < 3; o++)
+		scale_row (lines, m, band[o], lv->gains[o]);
+
+	if (lines->preview && level == lines->preview_level &&
+		m >= 0 && m % ((gint64) 1 << level) == 0 && (m >> level) < lines->height >> level)
+	{
+		guint pw = width >> level, x;
+		gdouble scale = 1 / pow (lines->dc, 2.0 * level);
+		gdouble *dst = lines->preview + (gsize) (m >> level) * pw;
+
+		for (x = 0; x < pw; x++)
+			dst[x] = scale * lv->ll[x << level];
+	}
+
+	if (level < lines->levels)
+	{
+		forward (lines, level + 1, m, lv->ll);
+		return;
+	}
+
+	for (k = 0; lines->ll_gain != 1. && k < width; k++)
+		lv->ll[k] *= lines->ll_gain;
+	if (lines->inverse)
+		inverse (lines, level, m, lv->ll);
+	else if (m >= 0 && m < lines->height)
+		lines->output (m, lv->ll, lines->user_data);
+}
+
+/* row idx of the reconstructed LL band of level */
+static void
+inverse (DwtLines *lines, guint level, gint64 idx, const gdouble *ll)
+{
+	DwtLinesLevel *lv = &lines->level[level - 1];
+	const DwtKernel *kern = lines->kernel;
+	const guint width = lines->width, nc = kern->nc;
+	const gdouble *rec[DWT_KERNEL_MAX_TAPS];
+	const gdouble *band[3][DWT_KERNEL_MAX_TAPS];
+	gboolean details = !lv->zero[0] || !lv->zero[2];
+	gint64 r;
+	guint k, o;
+
+	memcpy (ring_row (lv->rec, lv->span, width, idx), ll, width * sizeof (gdouble));
+	if (++lv->n_rec < lv->span)
+		return;
+
+	r = idx - (gint64) (kern->offset * lv->d);
+	for (k = 0; k < nc; k++)
+	{
+		gint64 t = r - (gint64) lv->d * k + (gint64) lv->d * kern->offset;
+
+		rec[k] = ring_row (lv->rec, lv->span, width, t);
+		for (o = 0; o < 3; o++)
+			band[o][k] = ring_row (lv->bands + o * lv->band_span * width,
+					lv->band_span, width, t);
+	}
+
+	dwt_kernel_atrous_inverse_rows (kern, rec, lv->zero[1] ? NULL : band[1], width,
+			lines->t1);
+	if (details)
+		dwt_kernel_atrous_inverse_rows (kern, lv->zero[0] ? NULL : band[0],
+				lv->zero[2] ? NULL : band[2], width, lines->t2);
+	dwt_kernel_atrous_inverse_line (kern, lines->t1, details ? lines->t2 : NULL,
+			width, lv->d, lv->out, lines->ext);
+
+	if (level > 1)
+		inverse (lines, level - 1, r, lv->out);
+	else if (r >= 0 && r < lines->height)
+		lines->output (r, lv->out, lines->user_data);
+}
+
+static void
+free_levels (DwtLines *lines)
+{
+	guint j;
+
+	if (lines->level == NULL)
+		return;
+
+	for (j = 0; j < lines->levels; j++)
+	{
+		g_free (lines->level[j].lo);
+		g_free (lines->level[j].bands);
+		g_free (lines->level[j].rec);
+	}
+	g_free (lines->level);
+	g_free (lines->t1);
+	g_free (lines->ext);
+	lines->level = NULL;
+}
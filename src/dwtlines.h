@@ -0,0 +1,106 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __DWT_LINES_H__
+#define __DWT_LINES_H__
+
+#include <glib.h>
+
+#include "dwtkernel.h"
+#include "dwtmask.h"
+
+G_BEGIN_DECLS
+
+typedef struct _DwtLinesLevel DwtLinesLevel;
+typedef struct _DwtLines      DwtLines;
+
+/* receives output row r, valid until the next push */
+typedef void (*DwtLinesOutput) (guint r, const gdouble *row, gpointer user_data);
+
+/* The stationary transform of a plan (see dwt_plan_set_stationary()) run
+ * line by line: rows are pushed top to bottom and every output row is
+ * handed out as soon as the rows below it that it depends on have been
+ * pushed. Only ring buffers of lines are held, about
+ * 3 * levels * (nc - 1) * 2^levels rows of width doubles, whatever the
+ * height. Across the rows the frame is extended by repeating its first
+ * and last row instead of wrapping around, so the rows within reach of the
+ * top and bottom differ from the plan's; across the columns it wraps like
+ * the plan. */
+struct _DwtLines
+{
+	guint width, height;
+	guint levels;
+	const DwtKernel *kernel;	/* not owned */
+	gboolean inverse;
+	DwtMask *mask;		/* windows and gains, see dwt_mask_new_levels() */
+
+	/* with preview, the LL image of level preview_level is left there like
+	 * with the plan, not owned */
+	guint preview_level;
+	gdouble *preview;
+
+	/* private */
+	DwtLinesLevel *level;
+	guint nc;		/* taps the rings were sized for */
+	guint reach;		/* rows an output row depends on below it */
+	gint64 next;		/* index of the next row, from -reach */
+	gdouble dc;		/* DC gain of the low-pass taps */
+	gdouble ll_gain;
+	gdouble *t1, *t2, *ext;
+	DwtLinesOutput output;
+	gpointer user_data;
+};
+
+DwtLines *dwt_lines_new (guint width, guint height, guint levels);
+void dwt_lines_free (DwtLines *lines);
+
+void dwt_lines_set_kernel (DwtLines *lines, const DwtKernel *kernel);
+void dwt_lines_set_inverse (DwtLines *lines, gboolean inverse);
+void dwt_lines_set_preview (DwtLines *lines, guint level, gdouble *preview);
+
+void dwt_lines_begin (DwtLines *lines, DwtLinesOutput output, gpointer user_data);
+void dwt_lines_push (DwtLines *lines, const gdouble *row);
+
+G_END_DECLS
+
+#endif /* __DWT_LINES_H__ */
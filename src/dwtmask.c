@@ -0,0 +1,845 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dwtmask.h"
+
+/* half-open rectangle [x0, x1) x [y0, y1) of the coefficient plane */
+typedef struct
+{
+	guint x0, x1, y0, y1;
+} DwtRect;
+
+/* columns [start, start + len) kept whole by the windows */
+typedef struct
+{
+	guint start, len;
+} DwtSpan;
+
+static void add_rect (GArray *rects, guint x0, guint x1, guint y0, guint y1);
+static void window_to_rects (const DwtMask *mask, const DwtWindow *win, GArray *rects);
+static guint mark_changed_rows (DwtMask *mask, GArray *old_rects, GArray *new_rects);
+static void compile_gains (DwtMask *mask);
+static void build_row (DwtMask *mask, guint r, GArray *active);
+static void sweep (DwtMask *mask);
+static gboolean parse_rule (gchar *entry, DwtSubbandRule *rule);
+
+/* orders by top row first, the rest only makes the order total */
+static gint
+compare_rect (gconstpointer a, gconstpointer b)
+{
+	const DwtRect *ra = a, *rb = b;
+
+	if (ra->y0 != rb->y0)
+		return ra->y0 < rb->y0 ? -1 : 1;
+	if (ra->y1 != rb->y1)
+		return ra->y1 < rb->y1 ? -1 : 1;
+	if (ra->x0 != rb->x0)
+		return ra->x0 < rb->x0 ? -1 : 1;
+	if (ra->x1 != rb->x1)
+		return ra->x1 < rb->x1 ? -1 : 1;
+	return 0;
+}
+
+static gint
+compare_rect_left (gconstpointer a, gconstpointer b)
+{
+	const DwtRect *ra = a, *rb = b;
+
+	return (ra->x0 > rb->x0) - (ra->x0 < rb->x0);
+}
+
+DwtMask *
+dwt_mask_new (guint width, guint height)
+{
+	DwtMask *mask = g_new0 (DwtMask, 1);
+
+	mask->width = width;
+	mask->height = height;
+	mask->rows = g_new0 (DwtMaskRow, height);
+
+	/* low-pass over the whole plane: every gain is 1 and the rows are empty */
+	mask->highpass = FALSE;
+	mask->cutoff = MAX (width, height);
+
+	mask->rules = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+	for (mask->levels = 0; 2u << mask->levels <= MIN (width, height); mask->levels++);
+	mask->level_gains = g_new (gdouble, 3 * mask->levels + 1);
+	compile_gains (mask);
+
+	mask->windows = g_array_new (FALSE, FALSE, sizeof (DwtWindow));
+	mask->rects = g_array_new (FALSE, FALSE, sizeof (DwtRect));
+	mask->next_rects = g_array_new (FALSE, FALSE, sizeof (DwtRect));
+	mask->active = g_array_new (FALSE, FALSE, sizeof (DwtRect));
+	mask->keep = g_array_new (FALSE, FALSE, sizeof (DwtSpan));
+	mask->base = g_array_new (FALSE, FALSE, sizeof (DwtRun));
+	mask->dirty = g_new0 (guint8, height);
+
+	return mask;
+}
+
+/* A mask for the stationary transforms, which only use the windows and
+ * dwt_mask_level_gain(): no runs are compiled, so it costs nothing per
+ * row and suits frames of any height. Not for dwt_mask_apply(). */
+DwtMask *
+dwt_mask_new_levels (guint width, guint height)
+{
+	DwtMask *mask = g_new0 (DwtMask, 1);
+
+	mask->width = width;
+	mask->height = height;
+	mask->rows = NULL;
+
+	mask->highpass = FALSE;
+	mask->cutoff = MAX (width, height);
+
+	mask->rules = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+	for (mask->levels = 0; 2u << mask->levels <= MIN (width, height); mask->levels++);
+	mask->level_gains = g_new (gdouble, 3 * mask->levels + 1);
+	compile_gains (mask);
+
+	mask->windows = g_array_new (FALSE, FALSE, sizeof (DwtWindow));
+
+	return mask;
+}
+
+void
+dwt_mask_free (DwtMask *mask)
+{
+	guint i;
+
+	if (mask == NULL)
+		return;
+
+	g_array_free (mask->rules, TRUE);
+	g_free (mask->level_gains);
+	g_array_free (mask->windows, TRUE);
+
+	if (mask->rows != NULL)
+	{
+		for (i = 0; i < mask->height; i++)
+			g_free (mask->rows[i].runs);
+
+		g_free (mask->rows);
+		g_array_free (mask->rects, TRUE);
+		g_array_free (mask->next_rects, TRUE);
+		g_array_free (mask->active, TRUE);
+		g_array_free (mask->keep, TRUE);
+		g_array_free (mask->base, TRUE);
+		g_free (mask->dirty);
+	}
+	g_free (mask);
+}
+
+/* Recompiles the whole mask for a new band selection. Returns FALSE when
+ * the selection is unchanged. */
+gboolean
+dwt_mask_set_band (DwtMask *mask, gboolean highpass, guint cutoff)
+{
+	cutoff = MIN (cutoff, MAX (mask->width, mask->height));
+
+	if (mask->highpass == highpass && mask->cutoff == cutoff)
+		return FALSE;
+
+	mask->highpass = highpass;
+	mask->cutoff = cutoff;
+
+	if (mask->rows != NULL)
+	{
+		memset (mask->dirty, 1, mask->height);
+		sweep (mask);
+	}
+
+	return TRUE;
+}
+
+/* Recompiles the whole mask for new subband gains. Returns FALSE when the
+ * rules are unchanged. */
+gboolean
+dwt_mask_set_subbands (DwtMask *mask, const DwtSubbandRule *rules, guint n_rules)
+{
+	guint i;
+
+	for (i = 0; mask->rules->len == n_rules && i < n_rules; i++)
+	{
+		const DwtSubbandRule *rule = &g_array_index (mask->rules, DwtSubbandRule, i);
+
+		if (rule->first_level != rules[i].first_level ||
+			rule->last_level != rules[i].last_level ||
+			rule->orientations != rules[i].orientations ||
+			rule->gain != rules[i].gain)
+			break;
+	}
+	if (mask->rules->len == n_rules && i == n_rules)
+		return FALSE;
+
+	g_array_set_size (mask->rules, 0);
+	g_array_append_vals (mask->rules, rules, n_rules);
+	compile_gains (mask);
+
+	if (mask->rows != NULL)
+	{
+		memset (mask->dirty, 1, mask->height);
+		sweep (mask);
+	}
+
+	return TRUE;
+}
+
+/* Updates the mask for a new window set. Only the rows touched by
+ * rectangles that appeared or disappeared are rebuilt, so a box moving by
+ * a few pixels mostly costs the rows of its finest levels. Returns FALSE
+ * when the set is the one the mask already holds. */
+gboolean
+dwt_mask_set_windows (DwtMask *mask, const DwtWindow *windows, guint n_windows)
+{
+	GArray *tmp;
+	guint i;
+
+	if (mask->windows->len == n_windows &&
+		(n_windows == 0 ||
+		 memcmp (mask->windows->data, windows, n_windows * sizeof (DwtWindow)) == 0))
+		return FALSE;
+
+	g_array_set_size (mask->windows, 0);
+	g_array_append_vals (mask->windows, windows, n_windows);
+	if (mask->rows == NULL)
+		return TRUE;
+
+	g_array_set_size (mask->next_rects, 0);
+	for (i = 0; i < n_windows; i++)
+		window_to_rects (mask, &windows[i], mask->next_rects);
+	g_array_sort (mask->next_rects, compare_rect);
+
+	memset (mask->dirty, 0, mask->height);
+	if (mark_changed_rows (mask, mask->rects, mask->next_rects) == 0)
+		return FALSE;
+
+	tmp = mask->rects;
+	mask->rects = mask->next_rects;
+	mask->next_rects = tmp;
+
+	sweep (mask);
+
+	return TRUE;
+}
+
+static void
+scale_run (gdouble *coefs, guint len, gdouble gain)
+{
+	guint i;
+
+	for (i = 0; i < len; i++)
+		coefs[i] *= gain;
+}
+
+/* Multiplies the coefficients of row r by their gains; zero runs are
+ * cleared with memset, the rest are plain scaling loops the compiler
+ * vectorises. */
+void
+dwt_mask_apply_row (const DwtMask *mask, guint r, gdouble *line)
+{
+	const DwtMaskRow *row = &mask->rows[r];
+	guint i;
+
+	for (i = 0; i < row->n_runs; i++)
+	{
+		const DwtRun *run = &row->runs[i];
+
+		if (run->gain == 0.)
+			memset (line + run->start, 0, run->len * sizeof (gdouble));
+		else
+			scale_run (line + run->start, run->len, run->gain);
+	}
+}
+
+void
+dwt_mask_apply (const DwtMask *mask, gdouble *coefs)
+{
+	guint r;
+
+	for (r = 0; r < mask->height; r++)
+		dwt_mask_apply_row (mask, r, coefs + (gsize) r * mask->width);
+}
+
+/* Gain of a whole subband for the stationary transform, where the bands
+ * are not decimated and the cutoff square cannot be cut out of them: the
+ * subband rules times the band selection, a band counting as inside the
+ * cutoff when the centre of its block in the decimated layout is. For LL,
+ * level is the one it was left after. Windows are not included. */
+gdouble
+dwt_mask_level_gain (const DwtMask *mask, guint level, DwtSubband orientation)
+{
+	guint s = MIN (mask->width, mask->height) >> level;
+	gboolean inside;
+	gdouble gain = 1.;
+
+	if (orientation == DWT_SUBBAND_LL)
+	{
+		inside = 2 * mask->cutoff > s;
+		gain = mask->ll_gain;
+	}
+	else
+	{
+		inside = 2 * mask->cutoff > 3 * s;
+		if (level >= 1 && level <= mask->levels)
+			gain = mask->level_gains[3 * (level - 1) +
+				(orientation == DWT_SUBBAND_HL ? 0 : orientation == DWT_SUBBAND_LH ? 1 : 2)];
+	}
+
+	return inside != mask->highpass ? gain : 0.;
+}
+
+/* Multiplies row r of a stationary detail band by gain except inside the
+ * windows. The bands are not decimated, so a window covers the same
+ * pixels on every level. line holds width doubles. */
+void
+dwt_mask_scale_stationary_row (const DwtMask *mask, guint r, gdouble *row,
+	gdouble gain, gdouble *line)
+{
+	const DwtWindow *win = (const DwtWindow *) mask->windows->data;
+	gboolean crossed = FALSE;
+	guint i, x;
+
+	if (gain == 1.)
+		return;
+
+	for (i = 0; i < mask->windows->len; i++)
+	{
+		if (r < win[i].y || r - win[i].y >= win[i].h || win[i].x >= mask->width)
+			continue;
+
+		if (!crossed)
+		{
+			for (x = 0; x < mask->width; x++)
+				line[x] = gain;
+			crossed = TRUE;
+		}
+		for (x = win[i].x; x < MIN ((guint64) win[i].x + win[i].w, mask->width); x++)
+			line[x] = 1.;
+	}
+
+	if (crossed)
+	{
+		for (x = 0; x < mask->width; x++)
+			row[x] *= line[x];
+	}
+	else if (gain == 0.)
+		memset (row, 0, mask->width * sizeof (gdouble));
+	else
+		scale_run (row, mask->width, gain);
+}
+
+static void
+add_rect (GArray *rects, guint x0, guint x1, guint y0, guint y1)
+{
+	DwtRect rect;
+
+	if (x1 <= x0 || y1 <= y0)
+		return;
+
+	rect.x0 = x0;
+	rect.x1 = x1;
+	rect.y0 = y0;
+	rect.y1 = y1;
+	g_array_append_val (rects, rect);
+}
+
+/* Maps a window onto the three detail blocks of every level. The detail
+ * blocks of the level with scale s start at column and/or row s and are
+ * s coefficients wide, so the window is scaled by s / size and rounded
+ * outwards to cover every coefficient whose support touches it. */
+static void
+window_to_rects (const DwtMask *mask, const DwtWindow *win, GArray *rects)
+{
+	guint64 x_end = (guint64) win->x + win->w;
+	guint64 y_end = (guint64) win->y + win->h;
+	guint s;
+
+	if (win->w == 0 || win->h == 0)
+		return;
+
+	for (s = 1; 2 * s <= mask->width && 2 * s <= mask->height; s *= 2)
+	{
+		guint x0 = (guint64) win->x * s / mask->width;
+		guint y0 = (guint64) win->y * s / mask->height;
+		guint x1 = MIN ((x_end * s + mask->width - 1) / mask->width, s);
+		guint y1 = MIN ((y_end * s + mask->height - 1) / mask->height, s);
+
+		if (x0 >= s || y0 >= s)
+			continue;
+
+		add_rect (rects, s + x0, s + x1, y0, y1);
+		add_rect (rects, x0, x1, s + y0, s + y1);
+		add_rect (rects, s + x0, s + x1, s + y0, s + y1);
+	}
+}
+
+static guint
+mark_rows (DwtMask *mask, const DwtRect *rect)
+{
+	guint r, n = 0;
+
+	for (r = rect->y0; r < rect->y1; r++)
+	{
+		n += !mask->dirty[r];
+		mask->dirty[r] = 1;
+	}
+
+	return n;
+}
+
+/* Walks both sorted lists in step and flags the rows of every rectangle
+ * present in only one of them. Returns the number of flagged rows. */
+static guint
+mark_changed_rows (DwtMask *mask, GArray *old_rects, GArray *new_rects)
+{
+	guint i = 0, j = 0, n = 0;
+
+	while (i < old_rects->len || j < new_rects->len)
+	{
+		const DwtRect *a = i < old_rects->len ? &g_array_index (old_rects, DwtRect, i) : NULL;
+		const DwtRect *b = j < new_rects->len ? &g_array_index (new_rects, DwtRect, j) : NULL;
+		gint cmp = a == NULL ? 1 : b == NULL ? -1 : compare_rect (a, b);
+
+		if (cmp == 0)
+		{
+			i++;
+			j++;
+		}
+		else if (cmp < 0)
+		{
+			n += mark_rows (mask, a);
+			i++;
+		}
+		else
+		{
+			n += mark_rows (mask, b);
+			j++;
+		}
+	}
+
+	return n;
+}
+
+/* flattens the rules into one gain per level and orientation */
+static void
+compile_gains (DwtMask *mask)
+{
+	guint i, level;
+
+	for (i = 0; i < 3 * mask->levels; i++)
+		mask->level_gains[i] = 1.;
+	mask->ll_gain = 1.;
+
+	for (i = 0; i < mask->rules->len; i++)
+	{
+		const DwtSubbandRule *rule = &g_array_index (mask->rules, DwtSubbandRule, i);
+
+		if (rule->orientations & DWT_SUBBAND_LL)
+			mask->ll_gain = rule->gain;
+
+		for (level = MAX (rule->first_level, 1);
+			level <= MIN (rule->last_level, mask->levels); level++)
+		{
+			gdouble *gains = &mask->level_gains[3 * (level - 1)];
+
+			if (rule->orientations & DWT_SUBBAND_HL)
+				gains[0] = rule->gain;
+			if (rule->orientations & DWT_SUBBAND_LH)
+				gains[1] = rule->gain;
+			if (rule->orientations & DWT_SUBBAND_HH)
+				gains[2] = rule->gain;
+		}
+	}
+}
+
+/* gain of the detail block with scale s, orientation 0 (HL), 1 (LH) or 2 (HH) */
+static gdouble
+subband_gain (const DwtMask *mask, guint s, guint orientation)
+{
+	guint log_s = 0;
+
+	while ((2u << log_s) <= s)
+		log_s++;
+
+	if (log_s >= mask->levels)
+		return 1.;
+
+	return mask->level_gains[3 * (mask->levels - log_s - 1) + orientation];
+}
+
+static void
+push_base (GArray *base, guint start, guint end, gdouble gain)
+{
+	DwtRun *last = base->len ? &g_array_index (base, DwtRun, base->len - 1) : NULL;
+	DwtRun run;
+
+	if (end <= start || gain == 1.)
+		return;
+
+	if (last && last->gain == gain && last->start + last->len == start)
+	{
+		last->len += end - start;
+		return;
+	}
+
+	run.start = start;
+	run.len = end - start;
+	run.gain = gain;
+	g_array_append_val (base, run);
+}
+
+/* pushes the columns [start, end) of row r with the given subband gain,
+ * split at the cutoff column and multiplied by the band selection */
+static void
+push_segment (const DwtMask *mask, guint r, GArray *base,
+	guint start, guint end, gdouble gain)
+{
+	guint split = CLAMP (mask->cutoff, start, end);
+	gdouble inside, outside;
+
+	if (mask->highpass)
+	{
+		inside = r < mask->cutoff ? 0. : 1.;
+		outside = 1.;
+	}
+	else
+	{
+		inside = r < mask->cutoff ? 1. : 0.;
+		outside = 0.;
+	}
+
+	push_base (base, start, split, gain * inside);
+	push_base (base, split, end, gain * outside);
+}
+
+/* The runs the band selection and the subband gains give to row r. Row 0
+ * holds LL followed by the HL blocks of every level; a row in [s, 2s)
+ * holds the LH and HH blocks of scale s followed by the HL blocks of the
+ * coarser scales. */
+static void
+base_runs (const DwtMask *mask, guint r, GArray *base)
+{
+	guint s, t;
+
+	g_array_set_size (base, 0);
+
+	if (r == 0)
+	{
+		push_segment (mask, r, base, 0, MIN (1, mask->width), mask->ll_gain);
+		t = 1;
+	}
+	else
+	{
+		for (s = 1; 2 * s <= r; s *= 2);
+		push_segment (mask, r, base, 0, MIN (s, mask->width), subband_gain (mask, s, 1));
+		push_segment (mask, r, base, MIN (s, mask->width), MIN (2 * s, mask->width),
+				subband_gain (mask, s, 2));
+		t = 2 * s;
+	}
+
+	for (; t < mask->width; t *= 2)
+		push_segment (mask, r, base, t, MIN (2 * t, mask->width), subband_gain (mask, t, 0));
+}
+
+static void
+emit_run (DwtMaskRow *row, guint start, guint end, gdouble gain)
+{
+	DwtRun *run = &row->runs[row->n_runs++];
+
+	run->start = start;
+	run->len = end - start;
+	run->gain = gain;
+}
+
+/* Compiles row r: the band and subband runs with the columns kept by the
+ * windows crossing the row cut out of them. */
+static void
+build_row (DwtMask *mask, guint r, GArray *active)
+{
+	DwtMaskRow *row = &mask->rows[r];
+	GArray *keep = mask->keep;
+	GArray *base = mask->base;
+	guint i, k;
+
+	g_array_set_size (keep, 0);
+	g_array_sort (active, compare_rect_left);
+
+	for (i = 0; i < active->len; i++)
+	{
+		const DwtRect *rect = &g_array_index (active, DwtRect, i);
+		DwtSpan *last = keep->len ? &g_array_index (keep, DwtSpan, keep->len - 1) : NULL;
+
+		if (last && rect->x0 <= last->start + last->len)
+		{
+			last->len = MAX (last->start + last->len, rect->x1) - last->start;
+		}
+		else
+		{
+			DwtSpan span = { rect->x0, rect->x1 - rect->x0 };
+			g_array_append_val (keep, span);
+		}
+	}
+
+	base_runs (mask, r, base);
+
+	/* every kept span splits at most one run in two */
+	if (row->alloc < base->len + keep->len)
+	{
+		row->alloc = base->len + keep->len;
+		row->runs = g_renew (DwtRun, row->runs, row->alloc);
+	}
+
+	row->n_runs = 0;
+	for (i = 0, k = 0; i < base->len; i++)
+	{
+		const DwtRun *run = &g_array_index (base, DwtRun, i);
+		guint start = run->start;
+		guint end = start + run->len;
+
+		while (start < end)
+		{
+			const DwtSpan *span;
+
+			while (k < keep->len &&
+				g_array_index (keep, DwtSpan, k).start + g_array_index (keep, DwtSpan, k).len <= start)
+				k++;
+
+			span = k < keep->len ? &g_array_index (keep, DwtSpan, k) : NULL;
+			if (span == NULL || span->start >= end)
+			{
+				emit_run (row, start, end, run->gain);
+				break;
+			}
+
+			if (span->start > start)
+				emit_run (row, start, span->start, run->gain);
+			start = span->start + span->len;
+		}
+	}
+}
+
+/* Sweeps the rows top to bottom keeping the list of rectangles that cross
+ * the current row, so each row only looks at its own rectangles. Only the
+ * rows flagged dirty are rebuilt. */
+static void
+sweep (DwtMask *mask)
+{
+	GArray *active = mask->active;
+	guint next = 0;
+	guint r, i;
+
+	for (r = 0; r < mask->height; r++)
+	{
+		for (i = 0; i < active->len;)
+		{
+			if (g_array_index (active, DwtRect, i).y1 <= r)
+				g_array_remove_index_fast (active, i);
+			else
+				i++;
+		}
+
+		while (next < mask->rects->len &&
+			g_array_index (mask->rects, DwtRect, next).y0 <= r)
+		{
+			g_array_append_val (active, g_array_index (mask->rects, DwtRect, next));
+			next++;
+		}
+
+		if (mask->dirty[r])
+			build_row (mask, r, active);
+	}
+
+	g_array_set_size (active, 0);
+}
+
+/* Parses subband rules of the form "LEVELS:ORIENTATIONS=GAIN;..." where
+ * LEVELS is "*", "n" or "n-m" (level 1 is the finest, all levels when
+ * omitted), ORIENTATIONS is "*" for every detail block or a '+' separated
+ * list of ll, hl, lh and hh, and GAIN is a number, "keep" or "drop".
+ * "1:hh=drop" drops only the finest diagonal detail, "1-2:lh=0.5"
+ * halves the LH blocks of the two finest levels. */
+gboolean
+dwt_subband_rules_parse (const gchar *str, GArray *rules)
+{
+	gchar **entries;
+	gboolean ret = TRUE;
+	guint i;
+
+	if (str == NULL)
+		return TRUE;
+
+	entries = g_strsplit (str, ";", -1);
+	for (i = 0; entries[i] != NULL && ret; i++)
+	{
+		gchar *entry = g_strstrip (entries[i]);
+		DwtSubbandRule rule;
+
+		if (*entry == '\0')
+			continue;
+
+		ret = parse_rule (entry, &rule);
+		if (ret)
+			g_array_append_val (rules, rule);
+	}
+	g_strfreev (entries);
+
+	return ret;
+}
+
+static gboolean
+parse_levels (const gchar *str, DwtSubbandRule *rule)
+{
+	gchar *end;
+
+	if (strcmp (str, "*") == 0)
+		return TRUE;
+
+	rule->first_level = strtoul (str, &end, 10);
+	if (end == str)
+		return FALSE;
+
+	if (*end == '-')
+	{
+		str = end + 1;
+		rule->last_level = strtoul (str, &end, 10);
+		if (end == str)
+			return FALSE;
+	}
+	else
+	{
+		rule->last_level = rule->first_level;
+	}
+
+	return *end == '\0' && rule->first_level >= 1 &&
+		rule->last_level >= rule->first_level;
+}
+
+static gboolean
+parse_orientations (const gchar *str, guint *orientations)
+{
+	gchar **names;
+	gboolean ret = TRUE;
+	guint i;
+
+	if (strcmp (str, "*") == 0)
+	{
+		*orientations = DWT_SUBBAND_DETAILS;
+		return TRUE;
+	}
+
+	*orientations = 0;
+	names = g_strsplit (str, "+", -1);
+	for (i = 0; names[i] != NULL && ret; i++)
+	{
+		const gchar *name = g_strstrip (names[i]);
+
+		if (g_ascii_strcasecmp (name, "ll") == 0)
+			*orientations |= DWT_SUBBAND_LL;
+		else if (g_ascii_strcasecmp (name, "hl") == 0)
+			*orientations |= DWT_SUBBAND_HL;
+		else if (g_ascii_strcasecmp (name, "lh") == 0)
+			*orientations |= DWT_SUBBAND_LH;
+		else if (g_ascii_strcasecmp (name, "hh") == 0)
+			*orientations |= DWT_SUBBAND_HH;
+		else
+			ret = FALSE;
+	}
+	g_strfreev (names);
+
+	return ret && *orientations != 0;
+}
+
+static gboolean
+parse_gain (const gchar *str, gdouble *gain)
+{
+	gchar *end;
+
+	if (g_ascii_strcasecmp (str, "keep") == 0)
+	{
+		*gain = 1.;
+		return TRUE;
+	}
+	if (g_ascii_strcasecmp (str, "drop") == 0)
+	{
+		*gain = 0.;
+		return TRUE;
+	}
+
+	*gain = g_ascii_strtod (str, &end);
+	return end != str && *end == '\0';
+}
+
+static gboolean
+parse_rule (gchar *entry, DwtSubbandRule *rule)
+{
+	gchar *eq = strchr (entry, '=');
+	gchar *colon;
+	gchar *orientations = entry;
+
+	rule->first_level = 1;
+	rule->last_level = G_MAXUINT;
+
+	if (eq == NULL)
+		return FALSE;
+	*eq = '\0';
+
+	colon = strchr (entry, ':');
+	if (colon != NULL)
+	{
+		*colon = '\0';
+		if (!parse_levels (g_strstrip (entry), rule))
+			return FALSE;
+		orientations = colon + 1;
+	}
+
+	return parse_orientations (g_strstrip (orientations), &rule->orientations) &&
+		parse_gain (g_strstrip (eq + 1), &rule->gain);
+}
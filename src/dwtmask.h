@@ -0,0 +1,151 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __DWT_MASK_H__
+#define __DWT_MASK_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _DwtWindow  DwtWindow;
+typedef struct _DwtSubbandRule DwtSubbandRule;
+typedef struct _DwtRun     DwtRun;
+typedef struct _DwtMaskRow DwtMaskRow;
+typedef struct _DwtMask    DwtMask;
+
+/* rectangle in image (pixel) coordinates */
+struct _DwtWindow
+{
+	guint x, y, w, h;
+};
+
+/* Orientations of the detail blocks. The blocks of the level with scale s
+ * (s = size / 2^level, level 1 being the finest) sit in the square plane as
+ *   HL: columns [s, 2s), rows [0, s)  - high-pass along x
+ *   LH: columns [0, s),  rows [s, 2s) - high-pass along y
+ *   HH: columns [s, 2s), rows [s, 2s)
+ * and LL is the approximation coefficient left after the last level. */
+typedef enum
+{
+	DWT_SUBBAND_LL = 1 << 0,
+	DWT_SUBBAND_HL = 1 << 1,
+	DWT_SUBBAND_LH = 1 << 2,
+	DWT_SUBBAND_HH = 1 << 3,
+	DWT_SUBBAND_DETAILS = DWT_SUBBAND_HL | DWT_SUBBAND_LH | DWT_SUBBAND_HH
+} DwtSubband;
+
+/* multiplies the given orientations of levels [first_level, last_level]
+ * by gain; later rules override earlier ones */
+struct _DwtSubbandRule
+{
+	guint first_level, last_level;
+	guint orientations;
+	gdouble gain;
+};
+
+/* run of coefficients [start, start + len) inside one row scaled by gain */
+struct _DwtRun
+{
+	guint start, len;
+	gdouble gain;
+};
+
+struct _DwtMaskRow
+{
+	DwtRun *runs;
+	guint n_runs;
+	guint alloc;
+};
+
+/* The gain of every DWT coefficient, compiled from the band selection, the
+ * subband gains and a list of windows whose coefficients are kept over every detail level.
+ * Stored as per-row runs of the coefficients whose gain is not 1, so the
+ * untouched parts of the plane are skipped when the mask is applied. */
+struct _DwtMask
+{
+	guint width, height;
+	DwtMaskRow *rows;
+
+	/* band selection: keep (low-pass) or drop (high-pass) the top-left
+	 * cutoff x cutoff square of coefficients */
+	gboolean highpass;
+	guint cutoff;
+
+	GArray *rules;		/* DwtSubbandRule */
+	guint levels;
+	gdouble *level_gains;	/* levels x (HL, LH, HH), level 1 first */
+	gdouble ll_gain;
+
+	GArray *windows;	/* DwtWindow, the set the mask was built from */
+	GArray *rects;		/* coefficient rectangles, sorted by top row */
+
+	/* scratch reused between updates */
+	GArray *next_rects;
+	GArray *active;
+	GArray *keep;
+	GArray *base;
+	guint8 *dirty;
+};
+
+DwtMask *dwt_mask_new (guint width, guint height);
+DwtMask *dwt_mask_new_levels (guint width, guint height);
+void dwt_mask_free (DwtMask *mask);
+
+gboolean dwt_mask_set_band (DwtMask *mask, gboolean highpass, guint cutoff);
+gboolean dwt_mask_set_subbands (DwtMask *mask,
+	const DwtSubbandRule *rules, guint n_rules);
+gboolean dwt_mask_set_windows (DwtMask *mask,
+	const DwtWindow *windows, guint n_windows);
+
+void dwt_mask_apply (const DwtMask *mask, gdouble *coefs);
+gdouble dwt_mask_level_gain (const DwtMask *mask, guint level, DwtSubband orientation);
+void dwt_mask_scale_stationary_row (const DwtMask *mask, guint r, gdouble *row,
+	gdouble gain, gdouble *line);
+void dwt_mask_apply_row (const DwtMask *mask, guint r, gdouble *line);
+
+gboolean dwt_subband_rules_parse (const gchar *str, GArray *rules);
+
+G_END_DECLS
+
+#endif /* __DWT_MASK_H__ */
@@ -0,0 +1,373 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "dwtsched.h"
+
+/* items a stream runs before its worker looks at the other streams */
+#define DWT_SCHED_BATCH 4
+
+typedef struct
+{
+	DwtScheduler *sched;
+	GMutex lock;
+	GQueue ready;		/* DwtStream */
+} DwtWorker;
+
+struct _DwtScheduler
+{
+	guint n_workers;
+	DwtWorker *workers;
+	GThread **threads;
+
+	/* streams sitting in the ready queues, each one claimed by a worker
+	 * before it looks for it */
+	GMutex lock;
+	GCond cond;
+	guint n_ready;
+	guint next;		/* round robin for streams that never ran */
+	gboolean quit;
+};
+
+struct _DwtStream
+{
+	DwtScheduler *sched;
+
+	GMutex lock;
+	GCond cond;
+	GQueue items;
+	guint max_pending;
+	gboolean scheduled;	/* in a ready queue or running */
+	gboolean running;
+	gboolean flushing;
+	gint worker;		/* ran it last, -1 before the first item */
+
+	DwtStreamFunc func;
+	GDestroyNotify drop;
+	gpointer user_data;
+};
+
+static GMutex sched_lock;
+static DwtScheduler *sched_shared;
+static guint sched_users;
+
+static void
+enqueue (DwtScheduler *sched, DwtStream *stream, guint worker)
+{
+	DwtWorker *w = &sched->workers[worker];
+
+	g_mutex_lock (&w->lock);
+	g_queue_push_tail (&w->ready, stream);
+	g_mutex_unlock (&w->lock);
+
+	g_mutex_lock (&sched->lock);
+	sched->n_ready++;
+	g_cond_signal (&sched->cond);
+	g_mutex_unlock (&sched->lock);
+}
+
+/* Takes a stream off the worker's own queue, else steals the oldest one
+ * of the next busy worker. The caller has claimed one of the queued
+ * streams, so the loop ends once the other claimants took theirs. */
+static DwtStream *
+dequeue (DwtScheduler *sched, guint self)
+{
+	DwtStream *stream = NULL;
+	guint i;
+
+	while (stream == NULL)
+	{
+		for (i = 0; i < sched->n_workers && stream == NULL; i++)
+		{
+			DwtWorker *w = &sched->workers[(self + i) % sched->n_workers];
+
+			g_mutex_lock (&w->lock);
+			stream = g_queue_pop_head (&w->ready);
+			g_mutex_unlock (&w->lock);
+		}
+	}
+
+	return stream;
+}
+
+static void
+run_stream (DwtScheduler *sched, DwtStream *stream, guint self)
+{
+	gboolean requeue;
+	gpointer item;
+	guint n;
+
+	g_mutex_lock (&stream->lock);
+	stream->worker = self;
+	for (n = 0; n < DWT_SCHED_BATCH &&
+			(item = g_queue_pop_head (&stream->items)) != NULL; n++)
+	{
+		stream->running = TRUE;
+		g_cond_broadcast (&stream->cond);
+		g_mutex_unlock (&stream->lock);
+
+		stream->func (item, stream->user_data);
+
+		g_mutex_lock (&stream->lock);
+	}
+	stream->running = FALSE;
+
+	requeue = !g_queue_is_empty (&stream->items);
+	if (!requeue)
+		stream->scheduled = FALSE;
+	g_cond_broadcast (&stream->cond);
+	g_mutex_unlock (&stream->lock);
+
+	/* more left: to the back of our own queue, behind the other streams */
+	if (requeue)
+		enqueue (sched, stream, self);
+}
+
+static gpointer
+worker_main (gpointer data)
+{
+	DwtWorker *w = data;
+	DwtScheduler *sched = w->sched;
+	guint self = w - sched->workers;
+
+	for (;;)
+	{
+		g_mutex_lock (&sched->lock);
+		while (!sched->quit && sched->n_ready == 0)
+			g_cond_wait (&sched->cond, &sched->lock);
+		if (sched->quit)
+		{
+			g_mutex_unlock (&sched->lock);
+			break;
+		}
+		sched->n_ready--;
+		g_mutex_unlock (&sched->lock);
+
+		run_stream (sched, dequeue (sched, self), self);
+	}
+
+	return NULL;
+}
+
+/* Every element instance holds a reference between READY and NULL. The
+ * workers start with the first one and are joined with the last. */
+DwtScheduler *
+dwt_scheduler_ref (void)
+{
+	DwtScheduler *sched;
+	guint i;
+
+	g_mutex_lock (&sched_lock);
+	if (sched_users++ == 0)
+	{
+		sched = g_new0 (DwtScheduler, 1);
+		sched->n_workers = MAX (g_get_num_processors (), 1);
+		sched->workers = g_new0 (DwtWorker, sched->n_workers);
+		sched->threads = g_new0 (GThread *, sched->n_workers);
+		g_mutex_init (&sched->lock);
+		g_cond_init (&sched->cond);
+		sched_shared = sched;
+
+		for (i = 0; i < sched->n_workers; i++)
+		{
+			sched->workers[i].sched = sched;
+			g_mutex_init (&sched->workers[i].lock);
+			g_queue_init (&sched->workers[i].ready);
+		}
+		for (i = 0; i < sched->n_workers; i++)
+			sched->threads[i] = g_thread_new ("dwtworker", worker_main,
+					&sched->workers[i]);
+	}
+	sched = sched_shared;
+	g_mutex_unlock (&sched_lock);
+
+	return sched;
+}
+
+/* the streams of the caller must have been freed */
+void
+dwt_scheduler_unref (DwtScheduler *sched)
+{
+	guint i;
+
+	g_mutex_lock (&sched_lock);
+	if (--sched_users == 0)
+	{
+		g_mutex_lock (&sched->lock);
+		sched->quit = TRUE;
+		g_cond_broadcast (&sched->cond);
+		g_mutex_unlock (&sched->lock);
+
+		for (i = 0; i < sched->n_workers; i++)
+		{
+			g_thread_join (sched->threads[i]);
+			g_mutex_clear (&sched->workers[i].lock);
+		}
+
+		g_mutex_clear (&sched->lock);
+		g_cond_clear (&sched->cond);
+		g_free (sched->threads);
+		g_free (sched->workers);
+		g_free (sched);
+		sched_shared = NULL;
+	}
+	g_mutex_unlock (&sched_lock);
+}
+
+/* A stream keeps at most max_pending items waiting; pushing more blocks
+ * the caller. drop releases the items thrown away while flushing. */
+DwtStream *
+dwt_stream_new (DwtScheduler *sched, guint max_pending, DwtStreamFunc func,
+	GDestroyNotify drop, gpointer user_data)
+{
+	DwtStream *stream = g_new0 (DwtStream, 1);
+
+	stream->sched = sched;
+	g_mutex_init (&stream->lock);
+	g_cond_init (&stream->cond);
+	g_queue_init (&stream->items);
+	stream->max_pending = MAX (max_pending, 1);
+	stream->worker = -1;
+	stream->func = func;
+	stream->drop = drop;
+	stream->user_data = user_data;
+
+	return stream;
+}
+
+/* drops what is still waiting and returns once no worker holds the stream */
+void
+dwt_stream_free (DwtStream *stream)
+{
+	if (stream == NULL)
+		return;
+
+	dwt_stream_set_flushing (stream, TRUE);
+
+	g_mutex_lock (&stream->lock);
+	while (stream->scheduled)
+		g_cond_wait (&stream->cond, &stream->lock);
+	g_mutex_unlock (&stream->lock);
+
+	g_mutex_clear (&stream->lock);
+	g_cond_clear (&stream->cond);
+	g_free (stream);
+}
+
+/* Queues item behind the earlier ones. Returns FALSE without taking the
+ * item when the stream is flushing. */
+gboolean
+dwt_stream_push (DwtStream *stream, gpointer item)
+{
+	DwtScheduler *sched = stream->sched;
+	gboolean schedule = FALSE;
+	guint worker;
+
+	g_mutex_lock (&stream->lock);
+	while (!stream->flushing && stream->items.length >= stream->max_pending)
+		g_cond_wait (&stream->cond, &stream->lock);
+	if (stream->flushing)
+	{
+		g_mutex_unlock (&stream->lock);
+		return FALSE;
+	}
+
+	g_queue_push_tail (&stream->items, item);
+	if (!stream->scheduled)
+	{
+		stream->scheduled = schedule = TRUE;
+		worker = stream->worker;
+	}
+	g_mutex_unlock (&stream->lock);
+
+	if (schedule)
+	{
+		if (worker == (guint) -1)
+		{
+			g_mutex_lock (&sched->lock);
+			worker = sched->next++ % sched->n_workers;
+			g_mutex_unlock (&sched->lock);
+		}
+		enqueue (sched, stream, worker);
+	}
+
+	return TRUE;
+}
+
+/* returns once every item pushed so far has run, or the stream flushes */
+void
+dwt_stream_drain (DwtStream *stream)
+{
+	g_mutex_lock (&stream->lock);
+	while (!stream->flushing &&
+			(!g_queue_is_empty (&stream->items) || stream->running))
+		g_cond_wait (&stream->cond, &stream->lock);
+	g_mutex_unlock (&stream->lock);
+}
+
+/* While flushing the waiting items are dropped and pushes fail. Turning
+ * it on returns after the item that is running, if any, completed. */
+void
+dwt_stream_set_flushing (DwtStream *stream, gboolean flushing)
+{
+	gpointer item;
+
+	g_mutex_lock (&stream->lock);
+	stream->flushing = flushing;
+	if (flushing)
+	{
+		while ((item = g_queue_pop_head (&stream->items)) != NULL)
+		{
+			if (stream->drop)
+				stream->drop (item);
+		}
+		g_cond_broadcast (&stream->cond);
+
+		while (stream->running)
+			g_cond_wait (&stream->cond, &stream->lock);
+	}
+	g_mutex_unlock (&stream->lock);
+}
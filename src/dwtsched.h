@@ -0,0 +1,75 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __DWT_SCHED_H__
+#define __DWT_SCHED_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _DwtScheduler DwtScheduler;
+typedef struct _DwtStream    DwtStream;
+
+/* runs one queued item of a stream */
+typedef void (*DwtStreamFunc) (gpointer item, gpointer user_data);
+
+/* Process wide pool with one worker per processor. Every worker owns a
+ * queue of streams that have items waiting; a stream goes back to the
+ * worker that ran it last, so its plan and planes stay in that core's
+ * caches, and idle workers steal streams from the others. The items of a
+ * stream run one at a time in the order they were pushed. */
+DwtScheduler *dwt_scheduler_ref (void);
+void dwt_scheduler_unref (DwtScheduler *sched);
+
+DwtStream *dwt_stream_new (DwtScheduler *sched, guint max_pending,
+	DwtStreamFunc func, GDestroyNotify drop, gpointer user_data);
+void dwt_stream_free (DwtStream *stream);
+
+gboolean dwt_stream_push (DwtStream *stream, gpointer item);
+void dwt_stream_drain (DwtStream *stream);
+void dwt_stream_set_flushing (DwtStream *stream, gboolean flushing);
+
+G_END_DECLS
+
+#endif /* __DWT_SCHED_H__ */
@@ -0,0 +1,153 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "dwtstats.h"
+
+DwtStats *
+dwt_stats_new (guint width, guint height)
+{
+	DwtStats *stats = g_new0 (DwtStats, 1);
+	guint side = MIN (width, height);
+
+	stats->width = width;
+	stats->height = height;
+	for (stats->levels = 0; 2u << stats->levels <= side; stats->levels++);
+	stats->small_threshold = 1.;
+	stats->square = g_new (gdouble, MAX (width, height));
+	stats->bands = g_new (DwtBandStats, 3 * stats->levels + 1);
+	dwt_stats_reset (stats);
+
+	return stats;
+}
+
+void
+dwt_stats_free (DwtStats *stats)
+{
+	if (stats == NULL)
+		return;
+
+	g_free (stats->square);
+	g_free (stats->bands);
+	g_free (stats);
+}
+
+void
+dwt_stats_reset (DwtStats *stats)
+{
+	stats->total = 0;
+	memset (stats->square, 0, MAX (stats->width, stats->height) * sizeof (gdouble));
+	memset (stats->bands, 0, (3 * stats->levels + 1) * sizeof (DwtBandStats));
+}
+
+/* Adds row y of the transformed plane. The row is walked in the dyadic
+ * blocks of the layout, [2^j, 2^(j + 1)), each adding to one subband, in
+ * a single loop over the coefficients. */
+void
+dwt_stats_add_row (DwtStats *stats, guint y, const gdouble *row)
+{
+	const gint by = y > 0 ? (gint) g_bit_storage (y) - 1 : -1;
+	gdouble inner = 0;
+	guint x = 0, end;
+	gint j;
+
+	for (j = -1; x < stats->width; j++)
+	{
+		gint b = MAX (j, by);
+		DwtBandStats *band;
+		gdouble sum = 0, energy = 0;
+		guint start = x, small = 0;
+
+		end = MIN (j < 0 ? 1u : 2u << j, stats->width);
+		for (; x < end; x++)
+		{
+			gdouble c = row[x], v = c * c;
+
+			sum += c;
+			energy += v;
+			small += fabs (c) < stats->small_threshold;
+			if (x < y)
+				inner += v;
+			else
+				stats->square[x] += v;
+		}
+		stats->total += energy;
+
+		if (b < 0 || stats->levels == 0)
+			band = &stats->bands[3 * stats->levels];
+		else
+			band = &stats->bands[3 * (((guint) b < stats->levels ? stats->levels - b : 1) - 1) +
+				(j == by ? 2 : j > by ? 0 : 1)];
+		band->sum += sum;
+		band->energy += energy;
+		band->count += end - start;
+		band->small += small;
+	}
+
+	stats->square[y] += inner;
+}
+
+/* Side of the smallest top-left square of coefficients holding at least
+ * fraction of the energy, what the mask takes as cutoff. */
+guint
+dwt_stats_energy_cutoff (const DwtStats *stats, gdouble fraction)
+{
+	const guint n = MAX (stats->width, stats->height);
+	gdouble target = fraction * stats->total, sum = 0;
+	guint k;
+
+	for (k = 0; k < n; k++)
+	{
+		sum += stats->square[k];
+		if (sum >= target)
+			return k + 1;
+	}
+
+	return n;
+}
@@ -0,0 +1,88 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __DWT_STATS_H__
+#define __DWT_STATS_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _DwtBandStats DwtBandStats;
+typedef struct _DwtStats     DwtStats;
+
+/* sums over the coefficients of one subband */
+struct _DwtBandStats
+{
+	gdouble sum;
+	gdouble energy;		/* sum of the squares */
+	guint64 count;
+	guint64 small;		/* magnitude below small_threshold */
+};
+
+/* Statistics of the coefficients of one transformed plane, gathered row
+ * by row while the plane is transformed, before the mask. Subbands follow
+ * the layout of the mask (see DwtSubband); coefficients right of or below
+ * the square of the shorter side count to level 1. */
+struct _DwtStats
+{
+	guint width, height;
+	guint levels;
+	gdouble small_threshold;	/* 1 unless set */
+	gdouble total;		/* energy */
+	gdouble *square;	/* MAX (width, height) entries, the energy of the
+				 * coefficients with MAX (x, y) == k */
+	DwtBandStats *bands;	/* levels x (HL, LH, HH), level 1 first, then LL */
+};
+
+DwtStats *dwt_stats_new (guint width, guint height);
+void dwt_stats_free (DwtStats *stats);
+
+void dwt_stats_reset (DwtStats *stats);
+void dwt_stats_add_row (DwtStats *stats, guint y, const gdouble *row);
+
+guint dwt_stats_energy_cutoff (const DwtStats *stats, gdouble fraction);
+
+G_END_DECLS
+
+#endif /* __DWT_STATS_H__ */
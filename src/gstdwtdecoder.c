@@ -0,0 +1,295 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:element-dwtdecoder
+ *
+ * Decodes the bitplane coded DWT coefficients dwtfilter outputs with
+ * encode=true back into GRAY8 frames.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 videotestsrc ! video/x-raw,format=GRAY8,width=512,height=512 ! dwtfilter encode=true quant-step=4 ! dwtdecoder ! videoconvert ! autovideosink
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <gst/gst.h>
+
+#include "gstdwtdecoder.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_dwt_decoder_debug);
+#define GST_CAT_DEFAULT gst_dwt_decoder_debug
+
+static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
+		GST_PAD_SINK,
+		GST_PAD_ALWAYS,
+		GST_STATIC_CAPS (GST_DWT_CODED_CAPS)
+);
+
+static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
+		GST_PAD_SRC,
+		GST_PAD_ALWAYS,
+		GST_STATIC_CAPS ("video/x-raw,format=GRAY8")
+);
+
+#define gst_dwt_decoder_parent_class parent_class
+G_DEFINE_TYPE (GstDwtDecoder, gst_dwt_decoder, GST_TYPE_ELEMENT);
+
+static void gst_dwt_decoder_finalize (GObject * object);
+
+static gboolean gst_dwt_decoder_sink_event (GstPad * pad, GstObject * parent, GstEvent * event);
+static GstFlowReturn gst_dwt_decoder_chain (GstPad * pad, GstObject * parent, GstBuffer * buf);
+
+static gboolean set_caps(GstDwtDecoder *dec, GstCaps *caps);
+static gboolean decode_frame(GstDwtDecoder *dec, const guint8 *data, gsize size, guint8 *out);
+
+static void
+gst_dwt_decoder_class_init (GstDwtDecoderClass * klass)
+{
+	GObjectClass *gobject_class;
+	GstElementClass *gstelement_class;
+
+	gobject_class = (GObjectClass *) klass;
+	gstelement_class = (GstElementClass *) klass;
+
+	gobject_class->finalize = gst_dwt_decoder_finalize;
+
+	gst_element_class_set_details_simple(gstelement_class,
+			"DwtDecoder",
+			"Codec/Decoder/Video",
+			"Decodes the bitplane coded DWT coefficients of dwtfilter encode=true "
+			"and transforms them back to the image.",
+			"Martin Petrov Vachovski <<user@hostname.org>>");
+
+	gst_element_class_add_pad_template (gstelement_class,
+			gst_static_pad_template_get (&src_factory));
+	gst_element_class_add_pad_template (gstelement_class,
+			gst_static_pad_template_get (&sink_factory));
+
+	GST_DEBUG_CATEGORY_INIT (gst_dwt_decoder_debug, "dwtdecoder",
+			0, "DWT coefficient decoder");
+}
+
+static void
+gst_dwt_decoder_init (GstDwtDecoder * dec)
+{
+	dec->sinkpad = gst_pad_new_from_static_template (&sink_factory, "sink");
+	gst_pad_set_event_function (dec->sinkpad,
+			GST_DEBUG_FUNCPTR(gst_dwt_decoder_sink_event));
+	gst_pad_set_chain_function (dec->sinkpad,
+			GST_DEBUG_FUNCPTR(gst_dwt_decoder_chain));
+	gst_element_add_pad (GST_ELEMENT (dec), dec->sinkpad);
+
+	dec->srcpad = gst_pad_new_from_static_template (&src_factory, "src");
+	gst_pad_use_fixed_caps (dec->srcpad);
+	gst_element_add_pad (GST_ELEMENT (dec), dec->srcpad);
+
+	dec->width = 0;
+	dec->height = 0;
+	dec->have_kernel = FALSE;
+	dec->codec = NULL;
+	dec->plane = NULL;
+	dec->scratch = NULL;
+}
+
+static void
+gst_dwt_decoder_finalize (GObject * object)
+{
+	GstDwtDecoder *dec = GST_DWTDECODER (object);
+
+	dwt_codec_free (dec->codec);
+	g_free (dec->plane);
+	g_free (dec->scratch);
+
+	G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gboolean
+gst_dwt_decoder_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+	GstDwtDecoder *dec = GST_DWTDECODER (parent);
+	gboolean ret;
+
+	switch (GST_EVENT_TYPE (event)) {
+	case GST_EVENT_CAPS:
+	{
+		GstCaps *caps;
+
+		gst_event_parse_caps (event, &caps);
+		ret = set_caps(dec, caps);
+		gst_event_unref (event);
+		break;
+	}
+	default:
+		ret = gst_pad_event_default (pad, parent, event);
+		break;
+	}
+	return ret;
+}
+
+static GstFlowReturn
+gst_dwt_decoder_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+	GstDwtDecoder *dec = GST_DWTDECODER (parent);
+	GstMapInfo in, out;
+	GstBuffer *outbuf;
+	gboolean ok;
+
+	if(!dec->have_kernel)
+	{
+		GST_ELEMENT_ERROR (dec, CORE, NEGOTIATION, (NULL),
+				("received a buffer before the caps"));
+		gst_buffer_unref (buf);
+		return GST_FLOW_NOT_NEGOTIATED;
+	}
+
+	outbuf = gst_buffer_new_allocate (NULL, dec->width * dec->height, NULL);
+	gst_buffer_copy_into (outbuf, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+
+	gst_buffer_map (buf, &in, GST_MAP_READ);
+	gst_buffer_map (outbuf, &out, GST_MAP_WRITE);
+	ok = decode_frame(dec, in.data, in.size, out.data);
+	gst_buffer_unmap (outbuf, &out);
+	gst_buffer_unmap (buf, &in);
+	gst_buffer_unref (buf);
+
+	if(!ok)
+	{
+		GST_ELEMENT_ERROR (dec, STREAM, DECODE, (NULL),
+				("malformed coded frame"));
+		gst_buffer_unref (outbuf);
+		return GST_FLOW_ERROR;
+	}
+
+	return gst_pad_push (dec->srcpad, outbuf);
+}
+
+/* takes the geometry and the wavelet from the coded caps and announces
+ * the matching GRAY8 caps downstream */
+static gboolean set_caps(GstDwtDecoder *dec, GstCaps *caps)
+{
+	GstStructure *s = gst_caps_get_structure (caps, 0);
+	const gchar *name;
+	const DwtWavelet *w;
+	GstCaps *out;
+	gint num, den;
+	gboolean ret;
+
+	name = gst_structure_get_string (s, "wavelet");
+	if(!gst_structure_get_int (s, "width", &dec->width) ||
+			!gst_structure_get_int (s, "height", &dec->height) ||
+			dec->width <= 0 || dec->height <= 0 || name == NULL)
+	{
+		GST_WARNING_OBJECT (dec, "incomplete caps %" GST_PTR_FORMAT, caps);
+		return FALSE;
+	}
+
+	w = dwt_wavelet_lookup (name);
+	dec->have_kernel = w != NULL;
+	if(w)
+		dec->kernel = w->kernel;
+	if(!dec->have_kernel)
+	{
+		GST_WARNING_OBJECT (dec, "unknown wavelet \"%s\"", name);
+		return FALSE;
+	}
+
+	g_free (dec->scratch);
+	dec->scratch = g_new (gdouble, MAX (dec->width, dec->height));
+
+	out = gst_caps_new_simple ("video/x-raw",
+			"format", G_TYPE_STRING, "GRAY8",
+			"width", G_TYPE_INT, dec->width,
+			"height", G_TYPE_INT, dec->height, NULL);
+	if(gst_structure_get_fraction (s, "framerate", &num, &den))
+		gst_caps_set_simple (out, "framerate", GST_TYPE_FRACTION, num, den, NULL);
+
+	ret = gst_pad_set_caps (dec->srcpad, out);
+	gst_caps_unref (out);
+
+	return ret;
+}
+
+/* decodes every tile record of a frame and transforms it back into out */
+static gboolean decode_frame(GstDwtDecoder *dec, const guint8 *data, gsize size, guint8 *out)
+{
+	guint width, tile_height, n_tiles, t;
+	gsize pos = DWT_CODEC_HEADER_SIZE;
+	gdouble step;
+
+	/* the tiles split the negotiated height exactly, counted in 64 bits
+	 * against a header that overflows the product */
+	if(!dwt_codec_read_header(data, size, &width, &tile_height, &n_tiles, &step) ||
+			width != dec->width || tile_height == 0 ||
+			tile_height > (guint) dec->height || (guint) dec->height % tile_height != 0 ||
+			(guint64) tile_height * n_tiles != (guint64) dec->height)
+		return FALSE;
+
+	if(dec->codec == NULL || dec->codec->width != width || dec->codec->height != tile_height)
+	{
+		dwt_codec_free (dec->codec);
+		dec->codec = dwt_codec_new (width, tile_height);
+		g_free (dec->plane);
+		dec->plane = g_new (gdouble, width * tile_height);
+	}
+
+	for(t = 0; t < n_tiles; t++)
+	{
+		gsize used = dwt_codec_decode(dec->codec, data + pos, size - pos, step, dec->plane);
+
+		if(used == 0)
+			return FALSE;
+		pos += used;
+
+		dwt_transform_inverse(&dec->kernel, dec->plane, width, tile_height, dec->scratch);
+		dwt_plane_to_u8(dec->plane, out + t * width * tile_height, width * tile_height);
+	}
+
+	return TRUE;
+}
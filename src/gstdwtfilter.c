@@ -61,16 +61,29 @@
 #endif
 
 #include <gst/gst.h>
+#include <gst/video/video.h>
 
 #include <string.h>
-#include <gsl/gsl_wavelet.h>
-#include <gsl/gsl_wavelet2d.h>
 
 #include "gstdwtfilter.h"
+#include "gstdwtdecoder.h"
+#include "gstdwtmultifilter.h"
+#include "gstdwtsplitfilter.h"
+#include "gstdwtreplaysrc.h"
+#include "dwtfilter.h"
+#include "dwtarena.h"
+#include "dwtcodec.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_dwt_filter_debug);
 #define GST_CAT_DEFAULT gst_dwt_filter_debug
 
+/* frame sizes whose plans are kept across renegotiations */
+#define PLAN_CACHE_SIZE 4
+
+/* repeated events and queries are logged at debug level once per this
+ * many, every one at log level */
+#define LOG_EVERY 100
+
 /* Filter signals and args */
 enum
 {
@@ -91,6 +104,27 @@ enum
 	PROP_PHOF_Y,
 	PROP_PHOF_W,
 	PROP_PHOF_H,
+	PROP_PHOF_WINDOWS,
+	PROP_PHOF_OUTLINE,
+	PROP_ROI_META,
+	PROP_ROI_TYPE,
+	PROP_SUBBANDS,
+	PROP_HUGEPAGES,
+	PROP_PACKED_TILES,
+	PROP_ENCODE,
+	PROP_QUANT_STEP,
+	PROP_PREVIEW_LEVEL,
+	PROP_STATIONARY_LEVELS,
+	PROP_LINE_BUFFERED,
+	PROP_OUTPUT_QUEUE,
+	PROP_OUTPUT_LEAKY,
+	PROP_OUTPUT_STATS,
+	PROP_CUTOFF_ENERGY,
+	PROP_STATS_META,
+	PROP_STATS_THRESHOLD,
+	PROP_PACKET_LEVELS,
+	PROP_DUMP_LOCATION,
+	PROP_DUMP_FRAMES,
 };
 
 /* the capabilities of the inputs and outputs.
@@ -106,6 +140,13 @@ static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
 static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
 		GST_PAD_SRC,
 		GST_PAD_ALWAYS,
+		GST_STATIC_CAPS ("video/x-raw,format=GRAY8; " GST_DWT_CODED_CAPS)
+);
+
+/* LL band of a coarser level, for thumbnails */
+static GstStaticPadTemplate preview_factory = GST_STATIC_PAD_TEMPLATE ("preview",
+		GST_PAD_SRC,
+		GST_PAD_REQUEST,
 		GST_STATIC_CAPS ("video/x-raw,format=GRAY8")
 );
 
@@ -116,27 +157,56 @@ static void gst_dwt_filter_set_property (GObject * object, guint prop_id,
 		const GValue * value, GParamSpec * pspec);
 static void gst_dwt_filter_get_property (GObject * object, guint prop_id,
 		GValue * value, GParamSpec * pspec);
+static void gst_dwt_filter_finalize (GObject * object);
+
+static GstStateChangeReturn gst_dwt_filter_change_state (GstElement * element,
+		GstStateChange transition);
+static GstPad *gst_dwt_filter_request_new_pad (GstElement * element,
+		GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
+static void gst_dwt_filter_release_pad (GstElement * element, GstPad * pad);
 
 static gboolean gst_dwt_filter_sink_event (GstPad * pad, GstObject * parent, GstEvent * event);
 static gboolean gst_dwt_filter_src_event (GstPad * pad, GstObject * parent, GstEvent * event);
 
 static GstFlowReturn gst_dwt_filter_chain (GstPad * pad, GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_dwt_filter_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list);
 static gboolean gst_dwt_filter_query (GstPad *pad, GstObject *parent, GstQuery *query);
-
-static void guint8_to_gdouble(guint8* src, gdouble *dst, gsize sz);
-static void gdouble_to_guint8(gdouble* src, guint8 *dst, gsize sz);
-
-static gboolean apply_wavelet_change(GstDwtFilter *filter, gchar *wavelet_name);
-
-static void copy_higher_details(gdouble* dest, gdouble* src,
-	guint width, guint height, guint x, guint y, guint block_width, guint block_height);
+static gboolean gst_dwt_filter_sink_query (GstPad *pad, GstObject *parent, GstQuery *query);
+
+static gboolean apply_wavelet_change(GstDwtFilter *filter, const gchar *wavelet_name);
+
+static void collect_windows(GstDwtFilter *filter, GstBuffer *buf);
+
+static gboolean update_frame_layout(GstDwtFilter *filter);
+static GstFlowReturn acquire_block(GstDwtFilter *filter, DwtArenaBlock **block);
+static GstBuffer *process_frame(GstDwtFilter *filter, GstBuffer *buf, GstBuffer **preview);
+static void write_line(guint r, const gdouble *row, gpointer user_data);
+static GstFlowReturn combine_preview_flow(GstFlowReturn ret, GstFlowReturn preview_ret);
+static GstPad *get_preview_pad(GstDwtFilter *filter);
+static GstPad *prepare_preview(GstDwtFilter *filter);
+static void preview_size(GstDwtFilter *filter, guint *level, guint *width, guint *height);
+static GstEvent *preview_caps_event(GstDwtFilter *filter, GstCaps *caps);
+static gboolean copy_sticky_event(GstPad *pad, GstEvent **event, gpointer user_data);
+static GstCaps *sink_allowed_caps(GstDwtFilter *filter, GstPad *pad, GstCaps *filt);
+static GstCaps *coded_caps(GstDwtFilter *filter, GstCaps *caps);
+static gboolean answer_caps_query(GstQuery *query, GstCaps *caps);
+static gboolean process_list_item(GstBuffer **buf, guint idx, gpointer user_data);
+static void tile_windows(GstDwtFilter *filter, guint tile, GArray *out);
+static gboolean open_dump(GstDwtFilter *filter);
+static gboolean gst_dwt_filter_src_activate_mode(GstPad *pad, GstObject *parent,
+		GstPadMode mode, gboolean active);
+static GstFlowReturn push_output(GstDwtFilter *filter, GstMiniObject *item);
+static gboolean push_output_event(GstDwtFilter *filter, GstEvent *event);
+static gboolean forward_event(GstDwtFilter *filter, GstPad *pad, GstEvent *event);
+static GstFlowReturn queue_output(GstDwtFilter *filter, GstMiniObject *item);
+static void set_output_flushing(GstDwtFilter *filter, gboolean flushing);
+static void drain_output(GstDwtFilter *filter);
+static void output_loop(gpointer user_data);
 
 /* GObject vmethod implementations */
 
 
-#define GST_TYPE_DWTFILTER_BAND (gst_dwtfilter_band_get_type ())
-
-static GType gst_dwtfilter_band_get_type (void)
+GType gst_dwtfilter_band_get_type (void)
 {
 	static GType dwtfilter_band_type = 0;
 
@@ -153,6 +223,46 @@ static GType gst_dwtfilter_band_get_type (void)
 	return dwtfilter_band_type;
 }
 
+#define GST_TYPE_DWTFILTER_HUGEPAGES (gst_dwtfilter_hugepages_get_type ())
+
+static GType gst_dwtfilter_hugepages_get_type (void)
+{
+	static GType dwtfilter_hugepages_type = 0;
+
+	if (!dwtfilter_hugepages_type) {
+		static GEnumValue pages[] = {
+				{ DWT_ARENA_PAGES_DEFAULT,     "Regular pages",                     "none" },
+				{ DWT_ARENA_PAGES_TRANSPARENT, "Transparent huge pages",            "transparent" },
+				{ DWT_ARENA_PAGES_EXPLICIT,    "Reserved huge pages, else transparent", "explicit" },
+				{ 0, NULL, NULL },
+		};
+
+		dwtfilter_hugepages_type = g_enum_register_static ("GstDwtFilterHugepages", pages);
+	}
+
+	return dwtfilter_hugepages_type;
+}
+
+#define GST_TYPE_DWTFILTER_LEAKY (gst_dwtfilter_leaky_get_type ())
+
+static GType gst_dwtfilter_leaky_get_type (void)
+{
+	static GType dwtfilter_leaky_type = 0;
+
+	if (!dwtfilter_leaky_type) {
+		static GEnumValue leaky[] = {
+				{ GST_DWTFILTER_LEAKY_NO,         "Not leaky, wait for room",  "no" },
+				{ GST_DWTFILTER_LEAKY_UPSTREAM,   "Drop the new frame",        "upstream" },
+				{ GST_DWTFILTER_LEAKY_DOWNSTREAM, "Drop the oldest frame",     "downstream" },
+				{ 0, NULL, NULL },
+		};
+
+		dwtfilter_leaky_type = g_enum_register_static ("GstDwtFilterLeaky", leaky);
+	}
+
+	return dwtfilter_leaky_type;
+}
+
 /* initialize the dwtfilter's class */
 static void
 gst_dwt_filter_class_init (GstDwtFilterClass * klass)
@@ -165,13 +275,20 @@ gst_dwt_filter_class_init (GstDwtFilterClass * klass)
 
 	gobject_class->set_property = gst_dwt_filter_set_property;
 	gobject_class->get_property = gst_dwt_filter_get_property;
+	gobject_class->finalize = gst_dwt_filter_finalize;
+
+	gstelement_class->change_state = gst_dwt_filter_change_state;
+	gstelement_class->request_new_pad = gst_dwt_filter_request_new_pad;
+	gstelement_class->release_pad = gst_dwt_filter_release_pad;
 
 	g_object_class_install_property (gobject_class, PROP_SILENT,
 			g_param_spec_boolean ("silent", "Silent", "Produce verbose output ?",
 					FALSE, G_PARAM_READWRITE));
 
 	g_object_class_install_property (gobject_class, PROP_WAVELET,
-			g_param_spec_string("wavelet", "Wavelet", "Family and order of the wavelet",
+			g_param_spec_string("wavelet", "Wavelet", "Family and order of the wavelet, "
+					"e.g. h2, d4, bc103; l202 is the 5/3 wavelet lifted along the "
+					"direction of the edges instead of rows and columns",
 					"h2", G_PARAM_READWRITE));
 
 	g_object_class_install_property (gobject_class, PROP_BAND,
@@ -218,6 +335,149 @@ gst_dwt_filter_class_init (GstDwtFilterClass * klass)
 					"Shoud not be bigger than the image size.",
 					0, 8096, 1, G_PARAM_READWRITE));
 
+	g_object_class_install_property (gobject_class, PROP_PHOF_WINDOWS,
+			g_param_spec_string ("phof-windows", "Phof windows",
+					"Additional rectangles with enabled phof, given as "
+					"\"x,y,w,h;x,y,w,h;...\"",
+					NULL, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_PHOF_OUTLINE,
+			g_param_spec_boolean ("phof-outline", "Phof outline",
+					"Draw the outline of the phof rectangles onto the output",
+					TRUE, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_ROI_META,
+			g_param_spec_boolean ("roi-meta", "ROI meta",
+					"Preserve higher order features inside the region of interest "
+					"metas attached to the input buffers, independently of phof",
+					TRUE, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_ROI_TYPE,
+			g_param_spec_string ("roi-type", "ROI type",
+					"Only use region of interest metas of this type, "
+					"NULL for all of them",
+					NULL, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_SUBBANDS,
+			g_param_spec_string ("subbands", "Subbands",
+					"Gains of individual subbands on top of band and cutoff, as "
+					"\"LEVELS:ORIENTATIONS=GAIN;...\" with level 1 the finest, "
+					"orientations ll, hl, lh, hh joined by '+' or * and gain a "
+					"number, keep or drop, e.g. \"1:hh=drop;1-2:lh=0.5\"",
+					NULL, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_HUGEPAGES,
+			g_param_spec_enum ("hugepages", "Huge pages",
+					"Back the coefficient plane with huge pages to cut TLB misses "
+					"on large frames",
+					GST_TYPE_DWTFILTER_HUGEPAGES, DWT_ARENA_PAGES_DEFAULT,
+					G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_PACKED_TILES,
+			g_param_spec_boolean ("packed-tiles", "Packed tiles",
+					"Frames are a vertical stack of width x width tiles, each "
+					"transformed on its own. Windows and region of interest metas "
+					"are given in frame coordinates, the phof ones apply to every tile",
+					FALSE, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_ENCODE,
+			g_param_spec_boolean ("encode", "Encode",
+					"Output the bitplane coded coefficients (" GST_DWT_CODED_CAPS
+					") instead of an image, for dwtdecoder. Set before negotiation",
+					FALSE, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_QUANT_STEP,
+			g_param_spec_double ("quant-step", "Quantization step",
+					"Quantization step of the coded coefficients, larger is smaller and coarser",
+					G_MINDOUBLE, G_MAXDOUBLE, 1.0, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_PREVIEW_LEVEL,
+			g_param_spec_uint ("preview-level", "Preview level",
+					"Level of the LL band pushed on the preview pad, each level "
+					"halving the size; clipped to the levels of the frame",
+					1, 31, 1, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_STATIONARY_LEVELS,
+			g_param_spec_uint ("stationary-levels", "Stationary levels",
+					"Levels of the undecimated (a trous) transform used instead of "
+					"the decimated one, for shift invariant filtering; 0 for the "
+					"decimated transform. Costs 3 planes per level, ignored while "
+					"encoding",
+					0, 31, 0, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_LINE_BUFFERED,
+			g_param_spec_boolean ("line-buffered", "Line buffered",
+					"Run the stationary transform row by row through a few lines per "
+					"level instead of whole planes, for very tall frames; the rows "
+					"near the top and bottom repeat the edge instead of wrapping. "
+					"Needs stationary-levels > 0 and no encode, the decimated "
+					"transform always takes whole planes",
+					FALSE, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_OUTPUT_QUEUE,
+			g_param_spec_uint ("output-queue", "Output queue",
+					"Frames held for a task of the src pad that pushes them, so a slow "
+					"downstream does not hold up the transform of the next frame; 0 "
+					"pushes from the streaming thread. Taken when going to PAUSED",
+					0, 1024, 0, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_OUTPUT_LEAKY,
+			g_param_spec_enum ("output-leaky", "Output leaky",
+					"What a full output queue does with a new frame, events are never "
+					"dropped",
+					GST_TYPE_DWTFILTER_LEAKY, GST_DWTFILTER_LEAKY_NO,
+					G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_OUTPUT_STATS,
+			g_param_spec_boxed ("output-stats", "Output stats",
+					"Level of the output queue: current-level, max-level, pushed and "
+					"dropped frames",
+					GST_TYPE_STRUCTURE, G_PARAM_READABLE));
+
+	g_object_class_install_property (gobject_class, PROP_CUTOFF_ENERGY,
+			g_param_spec_double ("cutoff-energy", "Cutoff energy",
+					"Pick the cutoff of every frame (tile) as the smallest square of "
+					"coefficients holding this fraction of its energy, kept by the "
+					"low-pass and dropped by the high-pass; 0 uses cutoff. Decimated "
+					"transform only",
+					0.0, 1.0, 0.0, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_STATS_META,
+			g_param_spec_boolean ("stats-meta", "Stats meta",
+					"Attach a GstDwtStatsMeta with the energy, mean, variance and "
+					"sparsity of every subband and the cutoff of every frame (tile) to "
+					"the output. Dyadic decimated transform only",
+					FALSE, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_STATS_THRESHOLD,
+			g_param_spec_double ("stats-threshold", "Stats threshold",
+					"Coefficients of a smaller magnitude count as zero in the sparsity "
+					"of the stats meta",
+					0.0, G_MAXDOUBLE, 1.0, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_PACKET_LEVELS,
+			g_param_spec_uint ("packet-levels", "Packet levels",
+					"Wavelet packets: split the detail bands up to this many more "
+					"times wherever it lowers their entropy (best basis). The levels "
+					"become non-standard (square bands) instead of the standard form "
+					"of 0, and the cutoff and subbands apply to that layout. 0 for the "
+					"dyadic transform. Not with stationary, encode or cutoff-energy",
+					0, DWT_PACKET_MAX_LEVELS, 0, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_DUMP_LOCATION,
+			g_param_spec_string ("dump-location", "Dump location",
+					"Write the coefficients of every frame, before the mask, to a memory "
+					"mapped ring in this file for dwtreplaysrc; NULL for none. The file "
+					"is truncated, dropping the frames it held, at the first frame "
+					"after NULL state and whenever the location, frame size or wavelet "
+					"change. Dyadic decimated transform only",
+					NULL, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_DUMP_FRAMES,
+			g_param_spec_uint ("dump-frames", "Dump frames",
+					"Frames the dump file holds, the oldest overwritten first",
+					1, 1 << 20, 64, G_PARAM_READWRITE));
+
 	gst_element_class_set_details_simple(gstelement_class,
 			"DwtFilter",
 			"DWT Element",
@@ -230,6 +490,8 @@ gst_dwt_filter_class_init (GstDwtFilterClass * klass)
 			gst_static_pad_template_get (&src_factory));
 	gst_element_class_add_pad_template (gstelement_class,
 			gst_static_pad_template_get (&sink_factory));
+	gst_element_class_add_pad_template (gstelement_class,
+			gst_static_pad_template_get (&preview_factory));
 }
 
 /* initialize the new element
@@ -245,7 +507,10 @@ gst_dwt_filter_init (GstDwtFilter * filter)
 			GST_DEBUG_FUNCPTR(gst_dwt_filter_sink_event));
 	gst_pad_set_chain_function (filter->sinkpad,
 			GST_DEBUG_FUNCPTR(gst_dwt_filter_chain));
-	GST_PAD_SET_PROXY_CAPS (filter->sinkpad);
+	gst_pad_set_chain_list_function (filter->sinkpad,
+			GST_DEBUG_FUNCPTR(gst_dwt_filter_chain_list));
+	gst_pad_set_query_function (filter->sinkpad,
+			GST_DEBUG_FUNCPTR(gst_dwt_filter_sink_query));
 	gst_element_add_pad (GST_ELEMENT (filter), filter->sinkpad);
 
 	filter->srcpad = gst_pad_new_from_static_template (&src_factory, "src");
@@ -254,21 +519,75 @@ gst_dwt_filter_init (GstDwtFilter * filter)
 
 	gst_pad_set_event_function (filter->srcpad,
 		GST_DEBUG_FUNCPTR(gst_dwt_filter_src_event));
+	gst_pad_set_activatemode_function (filter->srcpad,
+		GST_DEBUG_FUNCPTR(gst_dwt_filter_src_activate_mode));
 
 	filter->phof = FALSE;
 	filter->silent = FALSE;
+	filter->qos_events = 0;
+	filter->latency_queries = 0;
 	filter->inverse = TRUE;
 	filter->cutoff = 1;
 
 	filter->band = GST_DWTFILTER_LOWPASS;
-	filter->wavelet_name = "h2";
+	filter->hugepages = DWT_ARENA_PAGES_DEFAULT;
+	filter->wavelet_name = NULL;
 
 	filter->phof_window.x = 0;
 	filter->phof_window.y = 0;
 	filter->phof_window.w = 0;
 	filter->phof_window.h = 0;
 
-	filter->w = gsl_wavelet_alloc (gsl_wavelet_haar, 2);
+	filter->phof_outline = TRUE;
+	filter->phof_windows_str = NULL;
+	filter->phof_windows = g_array_new (FALSE, FALSE, sizeof (DwtWindow));
+	filter->windows = g_array_new (FALSE, FALSE, sizeof (DwtWindow));
+	filter->tile_windows = g_array_new (FALSE, FALSE, sizeof (DwtWindow));
+	filter->packed_tiles = FALSE;
+	filter->encode = FALSE;
+	filter->quant_step = 1.0;
+	filter->codec = NULL;
+	filter->previewpad = NULL;
+	filter->preview_level = 1;
+	filter->stationary_levels = 0;
+	filter->line_buffered = FALSE;
+	filter->line_buffered_ignored = FALSE;
+	filter->list_failed = FALSE;
+	filter->lines = NULL;
+	filter->cutoff_energy = 0;
+	filter->stats_meta = FALSE;
+	filter->stats_threshold = 1.0;
+	filter->packet_levels = 0;
+	filter->dump_location = NULL;
+	filter->dump_opened = NULL;
+	filter->dump_frames = 64;
+	filter->dump = NULL;
+	filter->stats = NULL;
+	filter->preview_plane = NULL;
+	filter->preview_alloc = 0;
+	filter->output_queue = 0;
+	filter->output_leaky = GST_DWTFILTER_LEAKY_NO;
+	filter->out_size = 0;
+	g_mutex_init (&filter->out_lock);
+	g_cond_init (&filter->out_cond);
+	g_queue_init (&filter->out_queue);
+	filter->out_flushing = TRUE;
+	filter->out_busy = FALSE;
+	filter->out_flow = GST_FLOW_OK;
+	filter->out_max_level = 0;
+	filter->out_pushed = 0;
+	filter->out_dropped = 0;
+	filter->n_phof_windows = 0;
+	filter->roi_meta = TRUE;
+	filter->roi_type = NULL;
+	filter->roi_type_quark = 0;
+
+	filter->subbands_str = NULL;
+	filter->subbands = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+	filter->plan = NULL;
+	filter->plans = dwt_plan_cache_new (PLAN_CACHE_SIZE);
+
+	apply_wavelet_change(filter, "h2");
 
 	gst_pad_set_query_function (filter->srcpad, gst_dwt_filter_query);
 
@@ -285,12 +604,59 @@ gst_dwt_filter_set_property (GObject * object, guint prop_id,
 		filter->silent = g_value_get_boolean (value);
 		break;
 	case PROP_WAVELET:
-		filter->wavelet_name = g_value_get_string (value);
-		apply_wavelet_change(filter, filter->wavelet_name);
+		apply_wavelet_change(filter, g_value_get_string (value));
 		break;
 	case PROP_BAND:
 		filter->band = g_value_get_enum(value);
 		break;
+	case PROP_HUGEPAGES:
+		filter->hugepages = g_value_get_enum(value);
+		break;
+	case PROP_PACKED_TILES:
+		filter->packed_tiles = g_value_get_boolean (value);
+		break;
+	case PROP_ENCODE:
+		filter->encode = g_value_get_boolean (value);
+		break;
+	case PROP_QUANT_STEP:
+		filter->quant_step = g_value_get_double (value);
+		break;
+	case PROP_PREVIEW_LEVEL:
+		filter->preview_level = g_value_get_uint (value);
+		break;
+	case PROP_STATIONARY_LEVELS:
+		filter->stationary_levels = g_value_get_uint (value);
+		break;
+	case PROP_LINE_BUFFERED:
+		filter->line_buffered = g_value_get_boolean (value);
+		break;
+	case PROP_OUTPUT_QUEUE:
+		filter->output_queue = g_value_get_uint (value);
+		break;
+	case PROP_OUTPUT_LEAKY:
+		filter->output_leaky = g_value_get_enum (value);
+		break;
+	case PROP_CUTOFF_ENERGY:
+		filter->cutoff_energy = g_value_get_double (value);
+		break;
+	case PROP_STATS_META:
+		filter->stats_meta = g_value_get_boolean (value);
+		break;
+	case PROP_STATS_THRESHOLD:
+		filter->stats_threshold = g_value_get_double (value);
+		break;
+	case PROP_PACKET_LEVELS:
+		filter->packet_levels = g_value_get_uint (value);
+		break;
+	case PROP_DUMP_LOCATION:
+		GST_OBJECT_LOCK (filter);
+		g_free (filter->dump_location);
+		filter->dump_location = g_value_dup_string (value);
+		GST_OBJECT_UNLOCK (filter);
+		break;
+	case PROP_DUMP_FRAMES:
+		filter->dump_frames = g_value_get_uint (value);
+		break;
 	case PROP_INVERSE:
 		filter->inverse = g_value_get_boolean (value);
 		break;
@@ -312,6 +678,59 @@ gst_dwt_filter_set_property (GObject * object, guint prop_id,
 	case PROP_PHOF_H:
 		filter->phof_window.h = g_value_get_uint (value);
 		break;
+	case PROP_PHOF_WINDOWS:
+	{
+		GArray *windows = g_array_new (FALSE, FALSE, sizeof (DwtWindow));
+
+		if(!dwt_windows_parse(g_value_get_string (value), windows))
+		{
+			GST_WARNING_OBJECT (filter, "invalid phof-windows \"%s\"",
+					g_value_get_string (value));
+			g_array_free (windows, TRUE);
+			break;
+		}
+
+		GST_OBJECT_LOCK (filter);
+		g_array_free (filter->phof_windows, TRUE);
+		filter->phof_windows = windows;
+		g_free (filter->phof_windows_str);
+		filter->phof_windows_str = g_value_dup_string (value);
+		GST_OBJECT_UNLOCK (filter);
+		break;
+	}
+	case PROP_PHOF_OUTLINE:
+		filter->phof_outline = g_value_get_boolean (value);
+		break;
+	case PROP_ROI_META:
+		filter->roi_meta = g_value_get_boolean (value);
+		break;
+	case PROP_SUBBANDS:
+	{
+		GArray *rules = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+
+		if(!dwt_subband_rules_parse(g_value_get_string (value), rules))
+		{
+			GST_WARNING_OBJECT (filter, "invalid subbands \"%s\"",
+					g_value_get_string (value));
+			g_array_free (rules, TRUE);
+			break;
+		}
+
+		GST_OBJECT_LOCK (filter);
+		g_array_free (filter->subbands, TRUE);
+		filter->subbands = rules;
+		g_free (filter->subbands_str);
+		filter->subbands_str = g_value_dup_string (value);
+		GST_OBJECT_UNLOCK (filter);
+		break;
+	}
+	case PROP_ROI_TYPE:
+		GST_OBJECT_LOCK (filter);
+		g_free (filter->roi_type);
+		filter->roi_type = g_value_dup_string (value);
+		filter->roi_type_quark = filter->roi_type ? g_quark_from_string (filter->roi_type) : 0;
+		GST_OBJECT_UNLOCK (filter);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -334,6 +753,62 @@ gst_dwt_filter_get_property (GObject * object, guint prop_id,
 	case PROP_BAND:
 		g_value_set_enum(value, filter->band);
 		break;
+	case PROP_HUGEPAGES:
+		g_value_set_enum(value, filter->hugepages);
+		break;
+	case PROP_PACKED_TILES:
+		g_value_set_boolean (value, filter->packed_tiles);
+		break;
+	case PROP_ENCODE:
+		g_value_set_boolean (value, filter->encode);
+		break;
+	case PROP_QUANT_STEP:
+		g_value_set_double (value, filter->quant_step);
+		break;
+	case PROP_PREVIEW_LEVEL:
+		g_value_set_uint (value, filter->preview_level);
+		break;
+	case PROP_STATIONARY_LEVELS:
+		g_value_set_uint (value, filter->stationary_levels);
+		break;
+	case PROP_LINE_BUFFERED:
+		g_value_set_boolean (value, filter->line_buffered);
+		break;
+	case PROP_OUTPUT_QUEUE:
+		g_value_set_uint (value, filter->output_queue);
+		break;
+	case PROP_OUTPUT_LEAKY:
+		g_value_set_enum (value, filter->output_leaky);
+		break;
+	case PROP_CUTOFF_ENERGY:
+		g_value_set_double (value, filter->cutoff_energy);
+		break;
+	case PROP_STATS_META:
+		g_value_set_boolean (value, filter->stats_meta);
+		break;
+	case PROP_STATS_THRESHOLD:
+		g_value_set_double (value, filter->stats_threshold);
+		break;
+	case PROP_PACKET_LEVELS:
+		g_value_set_uint (value, filter->packet_levels);
+		break;
+	case PROP_DUMP_LOCATION:
+		GST_OBJECT_LOCK (filter);
+		g_value_set_string (value, filter->dump_location);
+		GST_OBJECT_UNLOCK (filter);
+		break;
+	case PROP_DUMP_FRAMES:
+		g_value_set_uint (value, filter->dump_frames);
+		break;
+	case PROP_OUTPUT_STATS:
+		g_mutex_lock (&filter->out_lock);
+		g_value_take_boxed (value, gst_structure_new ("dwtfilter-output-stats",
+				"current-level", G_TYPE_UINT, g_queue_get_length (&filter->out_queue),
+				"max-level", G_TYPE_UINT, filter->out_max_level,
+				"pushed", G_TYPE_UINT64, filter->out_pushed,
+				"dropped", G_TYPE_UINT64, filter->out_dropped, NULL));
+		g_mutex_unlock (&filter->out_lock);
+		break;
 	case PROP_INVERSE:
 		g_value_set_enum(value, filter->inverse);
 		break;
@@ -355,12 +830,112 @@ gst_dwt_filter_get_property (GObject * object, guint prop_id,
 	case PROP_PHOF_H:
 		g_value_set_uint (value, filter->phof_window.h);
 		break;
+	case PROP_PHOF_WINDOWS:
+		GST_OBJECT_LOCK (filter);
+		g_value_set_string (value, filter->phof_windows_str);
+		GST_OBJECT_UNLOCK (filter);
+		break;
+	case PROP_PHOF_OUTLINE:
+		g_value_set_boolean (value, filter->phof_outline);
+		break;
+	case PROP_ROI_META:
+		g_value_set_boolean (value, filter->roi_meta);
+		break;
+	case PROP_ROI_TYPE:
+		GST_OBJECT_LOCK (filter);
+		g_value_set_string (value, filter->roi_type);
+		GST_OBJECT_UNLOCK (filter);
+		break;
+	case PROP_SUBBANDS:
+		GST_OBJECT_LOCK (filter);
+		g_value_set_string (value, filter->subbands_str);
+		GST_OBJECT_UNLOCK (filter);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
 	}
 }
 
+static void
+gst_dwt_filter_finalize (GObject * object)
+{
+	GstDwtFilter *filter = GST_DWTFILTER (object);
+
+	g_free (filter->phof_windows_str);
+	g_free (filter->roi_type);
+	g_free (filter->subbands_str);
+	g_array_free (filter->subbands, TRUE);
+	g_array_free (filter->phof_windows, TRUE);
+	g_array_free (filter->windows, TRUE);
+	g_array_free (filter->tile_windows, TRUE);
+	dwt_plan_cache_free (filter->plans);
+	dwt_lines_free (filter->lines);
+	dwt_stats_free (filter->stats);
+	dwt_codec_free (filter->codec);
+	g_free (filter->wavelet_name);
+	g_free (filter->preview_plane);
+	g_free (filter->dump_location);
+	g_free (filter->dump_opened);
+	dwt_dump_close (filter->dump);
+	g_queue_clear_full (&filter->out_queue, (GDestroyNotify) gst_mini_object_unref);
+	g_mutex_clear (&filter->out_lock);
+	g_cond_clear (&filter->out_cond);
+
+	G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static GstStateChangeReturn
+gst_dwt_filter_change_state (GstElement * element, GstStateChange transition)
+{
+	GstDwtFilter *filter = GST_DWTFILTER (element);
+	GstStateChangeReturn ret;
+
+	switch (transition) {
+	case GST_STATE_CHANGE_NULL_TO_READY:
+		dwt_arena_ref ();
+		break;
+	default:
+		break;
+	}
+
+	ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+	switch (transition) {
+	case GST_STATE_CHANGE_NULL_TO_READY:
+		if (ret == GST_STATE_CHANGE_FAILURE)
+			dwt_arena_unref ();
+		break;
+	case GST_STATE_CHANGE_PAUSED_TO_READY:
+		if(!filter->silent)
+			GST_INFO_OBJECT (filter, "%" G_GUINT64_FORMAT " QOS events, %" G_GUINT64_FORMAT
+					" latency queries", filter->qos_events, filter->latency_queries);
+		filter->qos_events = filter->latency_queries = 0;
+		break;
+	case GST_STATE_CHANGE_READY_TO_NULL:
+		dwt_plan_cache_free (filter->plans);
+		filter->plans = dwt_plan_cache_new (PLAN_CACHE_SIZE);
+		filter->plan = NULL;
+		dwt_lines_free (filter->lines);
+		filter->lines = NULL;
+		dwt_stats_free (filter->stats);
+		filter->stats = NULL;
+		dwt_dump_close (filter->dump);
+		filter->dump = NULL;
+		dwt_codec_free (filter->codec);
+		filter->codec = NULL;
+		g_free (filter->preview_plane);
+		filter->preview_plane = NULL;
+		filter->preview_alloc = 0;
+		dwt_arena_unref ();
+		break;
+	default:
+		break;
+	}
+
+	return ret;
+}
+
 /* GstElement vmethod implementations */
 
 /* this function handles sink events */
@@ -370,8 +945,7 @@ gst_dwt_filter_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 	gboolean ret;
 	GstDwtFilter *filter;
 	GstStructure *structure;
-	gchar *format;
-	int i;
+	const gchar *format;
 
 	filter = GST_DWTFILTER (parent);
 
@@ -379,53 +953,76 @@ gst_dwt_filter_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 	case GST_EVENT_CAPS:
 	{
 		GstCaps *caps;
+		GstPad *preview;
+		gint width, height;
 
 		gst_event_parse_caps (event, &caps);
-		/* do something with the caps */
 
-		for (i = 0; i < gst_caps_get_size (caps); i++)
+		/* caps events carry fixed caps, a single structure; the size only
+		 * changes once it is known to be usable */
+		structure = gst_caps_get_structure (caps, 0);
+		format = gst_structure_get_string(structure, "format");
+		if(!gst_structure_get_int(structure, "width", &width) ||
+				!gst_structure_get_int(structure, "height", &height) ||
+				width <= 0 || height <= 0)
 		{
-			structure = gst_caps_get_structure (caps, i);
-			if(structure)
-			{
-				gst_structure_get_int(structure, "width", &filter->width);
-				gst_structure_get_int(structure, "height", &filter->height);
-				format = gst_structure_get_string(structure, "format");
-				g_print("width = %d height = %d format = %s\n", filter->width, filter->height, format);
-				//pAccum = malloc(4 * width * height * sizeof(long int));
-				//memset(pAccum, 0, 4 * width * height * sizeof(long int));
-				filter->pDWTBuffer = (double*) malloc(filter->width * filter->height * sizeof(double));
-				filter->pTmpBuffer = (double*) malloc(filter->width * filter->height * sizeof(double));
-				filter->pTmpBuffer2 = (double*) malloc(filter->width * filter->height * sizeof(double));
-
-				memset(filter->pDWTBuffer, 0, filter->width * filter->height * sizeof(double));
-
-				filter->work = gsl_wavelet_workspace_alloc (filter->width);
-			}
-			else
-			{
-				//				g_print("structure = 0\n");
-			}
+			GST_WARNING_OBJECT (filter, "unusable caps %" GST_PTR_FORMAT, caps);
+			gst_event_unref (event);
+			ret = FALSE;
+			break;
 		}
+		if(!filter->silent)
+			GST_INFO_OBJECT (filter, "caps %dx%d %s", width, height, GST_STR_NULL (format));
 
-		/* and forward */
-		ret = gst_pad_event_default (pad, parent, event);
-		break;
-	}
-	case GST_EVENT_QOS:
-		g_print("GST_EVENT_QOS\n");
+		/* the coefficient plane is borrowed from the arena for each frame
+		 * and plans of recent sizes are kept, so renegotiating allocates
+		 * at most a plan for a size not seen lately */
+		if(width != filter->width || height != filter->height || filter->plan == NULL)
+		{
+			filter->width = width;
+			filter->height = height;
+			update_frame_layout(filter);
+		}
 
-		GstQOSType type;
-		gdouble proportion;
-		GstClockTimeDiff diff;
-		GstClockTime timestamp;
+		/* the preview gets caps of its own size */
+		preview = get_preview_pad(filter);
+		if(preview)
+		{
+			gst_pad_push_event (preview, preview_caps_event(filter, caps));
+			gst_object_unref (preview);
+		}
 
-		gst_event_parse_qos (event, &type, &proportion, &diff, &timestamp);
+		/* and forward, or announce the coded stream instead */
+		if(filter->encode)
+		{
+			GstCaps *out = coded_caps(filter, caps);
 
+			ret = push_output_event(filter, gst_event_new_caps (out));
+			gst_caps_unref (out);
+			gst_event_unref (event);
+		}
+		else
+			ret = push_output_event(filter, event);
+		break;
+	}
+	case GST_EVENT_FLUSH_START:
 		ret = gst_pad_event_default (pad, parent, event);
+		if(filter->out_size > 0)
+		{
+			set_output_flushing(filter, TRUE);
+			gst_pad_pause_task (filter->srcpad);
+		}
 		break;
-	default:
+	case GST_EVENT_FLUSH_STOP:
 		ret = gst_pad_event_default (pad, parent, event);
+		if(filter->out_size > 0)
+		{
+			set_output_flushing(filter, FALSE);
+			gst_pad_start_task (filter->srcpad, output_loop, filter, NULL);
+		}
+		break;
+	default:
+		ret = forward_event(filter, pad, event);
 		break;
 	}
 	return ret;
@@ -443,6 +1040,19 @@ gst_dwt_filter_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
 	switch (GST_EVENT_TYPE (event))
 	{
 	case GST_EVENT_QOS:
+		/* one per frame downstream, the details every LOG_EVERY-th */
+		GST_LOG_OBJECT (filter, "QOS event %" G_GUINT64_FORMAT, filter->qos_events);
+		if(filter->qos_events++ % LOG_EVERY == 0)
+		{
+			GstQOSType type;
+			gdouble proportion;
+			GstClockTimeDiff diff;
+			GstClockTime timestamp;
+
+			gst_event_parse_qos (event, &type, &proportion, &diff, &timestamp);
+			GST_DEBUG_OBJECT (filter, "QOS event %" G_GUINT64_FORMAT ": proportion %g, "
+					"jitter %" G_GINT64_FORMAT, filter->qos_events, proportion, diff);
+		}
 		ret = gst_pad_event_default (pad, parent, event);
 		break;
 	default:
@@ -461,144 +1071,100 @@ static GstFlowReturn
 gst_dwt_filter_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
 	GstDwtFilter *filter;
-	GstMapInfo info;
-	int i, j;
-	struct timespec t1, t2, diff;
+	DwtArenaBlock *block;
+	GstFlowReturn ret;
+	GstPad *preview;
+	GstBuffer *preview_buf = NULL;
 
 	filter = GST_DWTFILTER (parent);
 
-	gst_buffer_map (buf, &info, GST_MAP_WRITE);
-	guint8_to_gdouble(info.data, filter->pDWTBuffer, filter->height * filter->width);
+	ret = acquire_block(filter, &block);
+	if(ret != GST_FLOW_OK)
+	{
+		gst_buffer_unref (buf);
+		return ret;
+	}
 
-	clock_gettime(CLOCK_REALTIME, &t1);
+	preview = prepare_preview(filter);
+	buf = process_frame(filter, buf, preview ? &preview_buf : NULL);
 
-	gsl_wavelet2d_transform_forward(filter->w,
-									filter->pDWTBuffer,
-									filter->width,
-									filter->width,
-									filter->height,
-									filter->work);
-	
-	memcpy(filter->pTmpBuffer, filter->pDWTBuffer, filter->width * filter->height * sizeof(double));
+	dwt_arena_release(block);
+	filter->pDWTBuffer = NULL;
 
-	if(filter->band == GST_DWTFILTER_HIGHPASS)
+	if(buf == NULL)
 	{
-		for(j = 0; j < filter->cutoff; j++)
-		{
-			memset(filter->pDWTBuffer + j * filter->width, 0, sizeof(gdouble) * filter->cutoff);
-		}
-	}
-	else
-	{
-		for(j = 0; j < filter->cutoff; j++)
-		{
-			memset(filter->pDWTBuffer + j * filter->width + filter->cutoff, 0,
-				sizeof(gdouble) * (filter->width - filter->cutoff));
-		}
-		for(; j < filter->height; j++)
-		{
-			memset(filter->pDWTBuffer + j * filter->width, 0, sizeof(gdouble) * filter->width);
-		}
+		if(preview)
+			gst_object_unref (preview);
+		return GST_FLOW_ERROR;
 	}
-	
-	if(filter->phof)
+
+	ret = push_output(filter, GST_MINI_OBJECT_CAST (buf));
+
+	if(preview)
 	{
-		memcpy(filter->pTmpBuffer2, filter->pDWTBuffer, filter->width * filter->height * sizeof(double));
-
-//		higher_detail_window.x = higher_detail_window.y = 100;
-//		higher_detail_window.width = higher_detail_window.height = 100;
-
-		copy_higher_details(filter->pTmpBuffer2,
-				filter->pTmpBuffer,
-				filter->width,
-				filter->height,
-				filter->phof_window.x,
-				filter->phof_window.y,
-				filter->phof_window.w,
-				filter->phof_window.h);
-	}
-
-	if(filter->inverse == TRUE)
-	{
-//		memset(filter->pDWTBuffer, 0, filter->width * filter->height * sizeof(double));
-//		filter->pDWTBuffer[0] = 23763.375000;
-////		filter->pDWTBuffer[1] = -215.941406;
-////		filter->pDWTBuffer[2 * filter->width + 0] = -2202.557521;
-//		filter->pDWTBuffer[filter->width] = 2489.681545;
-//		for(i = filter->width + 0; i <= filter->width + 0; i++)
-//		{
-//			g_print("filter->pDWTBuffer[%d] = %lf\n", i, filter->pDWTBuffer[i]);
-//		}
-//		g_print("filter->pDWTBuffer[1] = %lf\n", filter->pDWTBuffer[1]);
-
-		gsl_wavelet2d_transform_inverse(filter->w,
-										filter->pDWTBuffer,
-										filter->width,
-										filter->width,
-										filter->height,
-										filter->work);
-
-		if(filter->phof)
-		{
-			gsl_wavelet2d_transform_inverse(filter->w,
-											filter->pTmpBuffer2,
-											filter->width,
-											filter->width,
-											filter->height,
-											filter->work);
-
-			for(i = filter->phof_window.x; i < filter->phof_window.x + filter->phof_window.w; i++)
-			{
-				for(j = filter->phof_window.y; j < filter->phof_window.y + filter->phof_window.h; j++)
-				{
-					int ix = i + j * filter->width;
-					filter->pDWTBuffer[ix] = filter->pTmpBuffer2[ix];
-				}
-			}
-		}
+		if(preview_buf)
+			ret = combine_preview_flow(ret, gst_pad_push (preview, preview_buf));
+		gst_object_unref (preview);
 	}
-	else
+
+	return ret;
+}
+
+/* chain list function
+ * a whole list shares one coefficient plane, one mask compilation and
+ * one push, which dominates the cost for small frames and tiles
+ */
+static GstFlowReturn
+gst_dwt_filter_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+	GstDwtFilter *filter;
+	DwtArenaBlock *block;
+	GstFlowReturn ret;
+
+	filter = GST_DWTFILTER (parent);
+
+	ret = acquire_block(filter, &block);
+	if(ret != GST_FLOW_OK)
 	{
-		if(filter->phof)
-		{
-			memcpy(filter->pDWTBuffer, filter->pTmpBuffer2, filter->width * filter->height * sizeof(double));
-		}
+		gst_buffer_list_unref (list);
+		return ret;
 	}
 
-	clock_gettime(CLOCK_REALTIME, &t2);
+	list = gst_buffer_list_make_writable (list);
+	filter->list_preview = prepare_preview(filter);
+	if(filter->list_preview)
+		filter->list_previews = gst_buffer_list_new_sized (gst_buffer_list_length (list));
+	filter->list_failed = FALSE;
+	gst_buffer_list_foreach (list, process_list_item, filter);
 
-	gdouble_to_guint8(filter->pDWTBuffer, info.data, filter->height * filter->width);
+	dwt_arena_release(block);
+	filter->pDWTBuffer = NULL;
 
-	if(filter->phof)
+	if(filter->list_failed)
 	{
-		memset(info.data + filter->phof_window.x + filter->phof_window.y * filter->width,
-				255,
-				filter->phof_window.w);
-		memset(info.data + filter->phof_window.x + (filter->phof_window.y + filter->phof_window.w )* filter->width,
-				255,
-				filter->phof_window.w);
-
-		for(i = filter->phof_window.y; i < filter->phof_window.y + filter->phof_window.h; i++)
+		gst_buffer_list_unref (list);
+		if(filter->list_preview)
 		{
-			info.data[filter->phof_window.x + i * filter->width] = 255;
-			info.data[filter->phof_window.x + filter->phof_window.w + i * filter->width] = 255;
+			gst_buffer_list_unref (filter->list_previews);
+			gst_object_unref (filter->list_preview);
+			filter->list_preview = NULL;
+			filter->list_previews = NULL;
 		}
+		return GST_FLOW_ERROR;
 	}
 
-	gst_buffer_unmap (buf, &info);
+	ret = push_output(filter, GST_MINI_OBJECT_CAST (list));
 
-	if(t2.tv_nsec >= t1.tv_nsec)
-	{
-		diff.tv_sec = t2.tv_sec - t1.tv_sec;
-		diff.tv_nsec = t2.tv_nsec - t1.tv_nsec;
-	}
-	else
+	if(filter->list_preview)
 	{
-		diff.tv_sec = t2.tv_sec - t1.tv_sec - 1;
-		diff.tv_nsec = 1000000000 + t2.tv_nsec - t1.tv_nsec;
+		ret = combine_preview_flow(ret,
+				gst_pad_push_list (filter->list_preview, filter->list_previews));
+		gst_object_unref (filter->list_preview);
+		filter->list_preview = NULL;
+		filter->list_previews = NULL;
 	}
 
-	return gst_pad_push (filter->srcpad, buf);
+	return ret;
 }
 
 
@@ -616,8 +1182,19 @@ dwtfilter_init (GstPlugin * dwtfilter)
 	GST_DEBUG_CATEGORY_INIT (gst_dwt_filter_debug, "dwtfilter",
 			0, "Template dwtfilter");
 
+	/* the wavelet properties look their values up in this table */
+	dwt_wavelets_init ();
+
 	return gst_element_register (dwtfilter, "dwtfilter", GST_RANK_NONE,
-			GST_TYPE_DWTFILTER);
+			GST_TYPE_DWTFILTER) &&
+		gst_element_register (dwtfilter, "dwtdecoder", GST_RANK_NONE,
+			GST_TYPE_DWTDECODER) &&
+		gst_element_register (dwtfilter, "dwtmultifilter", GST_RANK_NONE,
+			GST_TYPE_DWTMULTIFILTER) &&
+		gst_element_register (dwtfilter, "dwtsplitfilter", GST_RANK_NONE,
+			GST_TYPE_DWTSPLITFILTER) &&
+		gst_element_register (dwtfilter, "dwtreplaysrc", GST_RANK_NONE,
+			GST_TYPE_DWTREPLAYSRC);
 }
 
 static gboolean
@@ -637,14 +1214,19 @@ gst_dwt_filter_query (GstPad    *pad,
 //		/* we should report the duration here */
 //		[...]
 //		 break;
-//	case GST_QUERY_CAPS:
-//		/* we should report the supported caps here */
-//		[...]
-//		 break;
+	case GST_QUERY_CAPS:
+		/* the coded stream is not what upstream produces */
+		if(filter->encode)
+			ret = answer_caps_query(query, gst_caps_from_string (GST_DWT_CODED_CAPS));
+		else
+			ret = gst_pad_query_default (pad, parent, query);
+		break;
 	case GST_QUERY_LATENCY:
-		g_print("GST_QUERY_LATENCY arrived\n");
-//		gst_query_set_latency (query, TRUE, 10000000000, 10000000000);
-//		ret = gst_pad_query_default (pad, parent, query);
+		GST_LOG_OBJECT (filter, "latency query %" G_GUINT64_FORMAT, filter->latency_queries);
+		if(filter->latency_queries++ % LOG_EVERY == 0)
+			GST_DEBUG_OBJECT (filter, "latency query %" G_GUINT64_FORMAT, filter->latency_queries);
+		/* frames are filtered as they come, upstream's latency is ours */
+		ret = gst_pad_query_default (pad, parent, query);
 		break;
 
 	default:
@@ -655,146 +1237,999 @@ gst_dwt_filter_query (GstPad    *pad,
 	return ret;
 }
 
-static gboolean my_bus_callback (GstBus *bus, GstMessage *message, gpointer data)
+static gboolean
+gst_dwt_filter_sink_query (GstPad    *pad,
+		GstObject *parent,
+		GstQuery  *query)
 {
-	g_print ("Got %s message\n", GST_MESSAGE_TYPE_NAME (message));
+	GstDwtFilter *filter = GST_DWTFILTER (parent);
+	GstCaps *caps;
 
-	switch (GST_MESSAGE_TYPE (message)) {
-	case GST_MESSAGE_QOS:
-		g_print("GST_MESSAGE_QOS\n");
-		break;
+	/* Caps are negotiated with the main output only, the preview takes
+	 * whatever size results. */
+	switch (GST_QUERY_TYPE (query)) {
+	case GST_QUERY_CAPS:
+		gst_query_parse_caps (query, &caps);
+		gst_query_set_caps_result (query, sink_allowed_caps(filter, pad, caps));
+		return TRUE;
+	case GST_QUERY_ACCEPT_CAPS:
+	{
+		GstCaps *allowed;
+
+		gst_query_parse_accept_caps (query, &caps);
+		allowed = sink_allowed_caps(filter, pad, NULL);
+		gst_query_set_accept_caps_result (query, gst_caps_can_intersect (caps, allowed));
+		gst_caps_unref (allowed);
+		return TRUE;
+	}
 	default:
-		g_print("GST_MESSAGE_*\n");
-		break;
+		/* the allocation query among them waits for the queued frames */
+		if(GST_QUERY_IS_SERIALIZED (query))
+			drain_output(filter);
+		return gst_pad_query_default (pad, parent, query);
 	}
+}
 
-	/* we want to be notified again the next time there is a message
-	 * on the bus, so returning TRUE (FALSE means we want to stop watching
-	 * for messages on the bus and our callback should not be called again)
-	 */
-	return TRUE;
+/* Looks the name up in the prebuilt wavelet table. An unknown name
+ * leaves no wavelet, failing the next frame with an element error rather
+ * than quietly filtering with the previous one. */
+static gboolean apply_wavelet_change(GstDwtFilter *filter, const gchar *wavelet_name)
+{
+	const DwtWavelet *w = dwt_wavelet_lookup(wavelet_name);
+
+	if(w == NULL)
+		GST_WARNING_OBJECT (filter, "unknown wavelet \"%s\"", GST_STR_NULL (wavelet_name));
+
+	GST_OBJECT_LOCK (filter);
+	g_free (filter->wavelet_name);
+	filter->wavelet_name = g_strdup (wavelet_name);
+	filter->wavelet = w;
+	GST_OBJECT_UNLOCK (filter);
+
+	return w != NULL;
 }
 
-static void guint8_to_gdouble(guint8* src, gdouble *dst, gsize sz)
+/* Sizes the plan for the frame: the whole frame, or a single tile when
+ * the frame is a stack of packed tiles. Returns FALSE when the frame does
+ * not split into square tiles. Line buffered frames get the line
+ * transform instead, which never holds a whole plane. Plans of earlier
+ * sizes stay in the cache, a switch back to them allocates nothing. */
+static gboolean update_frame_layout(GstDwtFilter *filter)
 {
-	int i;
+	guint tile_height = filter->packed_tiles ? filter->width : filter->height;
+
+	if(filter->width <= 0 || filter->height <= 0 || filter->height % tile_height != 0)
+	{
+		filter->plan = NULL;
+		dwt_lines_free (filter->lines);
+		filter->lines = NULL;
+		return FALSE;
+	}
 
-	for(i = 0; i < sz; i++)
+	filter->tile_height = tile_height;
+	filter->n_tiles = filter->height / tile_height;
+
+	/* the decimated transform has no line buffered form: its levels wrap
+	 * around the whole tile, so the first rows of a level are only known
+	 * once the last ones are */
+	if(filter->line_buffered && (filter->stationary_levels == 0 || filter->encode))
 	{
-		dst[i] = src[i];
+		if(!filter->line_buffered_ignored)
+			GST_ELEMENT_WARNING (filter, LIBRARY, SETTINGS, (NULL),
+					("line-buffered needs stationary-levels > 0 and no encode, "
+					"transforming whole %dx%u planes", filter->width, tile_height));
+		filter->line_buffered_ignored = TRUE;
 	}
+	else
+		filter->line_buffered_ignored = FALSE;
+	filter->list_failed = FALSE;
+
+	if(filter->line_buffered && filter->stationary_levels > 0 && !filter->encode)
+	{
+		filter->plan = NULL;
+		if(filter->lines == NULL || filter->lines->width != filter->width ||
+				filter->lines->height != tile_height ||
+				filter->lines->levels != filter->stationary_levels)
+		{
+			dwt_lines_free (filter->lines);
+			filter->lines = dwt_lines_new (filter->width, tile_height, filter->stationary_levels);
+		}
+		return TRUE;
+	}
+
+	dwt_lines_free (filter->lines);
+	filter->lines = NULL;
+
+	filter->plan = dwt_plan_cache_get(filter->plans, filter->width, tile_height);
+
+	return TRUE;
 }
 
-static void gdouble_to_guint8(gdouble* src, guint8 *dst, gsize sz)
+/* Borrows the coefficient plane and line scratch for the current frame
+ * size from the arena, a single row for the line transform, and takes
+ * the wavelet for the frame. Posts an element error on failure. */
+static GstFlowReturn acquire_block(GstDwtFilter *filter, DwtArenaBlock **block)
 {
-	int i;
+	gchar *name = NULL;
+
+	GST_OBJECT_LOCK (filter);
+	filter->active_wavelet = filter->wavelet;
+	if(filter->wavelet == NULL)
+		name = g_strdup (filter->wavelet_name);
+	GST_OBJECT_UNLOCK (filter);
+	if(filter->active_wavelet == NULL)
+	{
+		GST_ELEMENT_ERROR (filter, LIBRARY, SETTINGS, (NULL),
+				("unknown wavelet \"%s\"", GST_STR_NULL (name)));
+		g_free (name);
+		return GST_FLOW_ERROR;
+	}
+
+	if(filter->width <= 0 || !update_frame_layout(filter))
+	{
+		GST_ELEMENT_ERROR (filter, CORE, NEGOTIATION, (NULL),
+				("received a buffer before usable caps (%dx%d, packed tiles %d)",
+				filter->width, filter->height, filter->packed_tiles));
+		return GST_FLOW_NOT_NEGOTIATED;
+	}
 
-	for(i = 0; i < sz; i++)
+	/* the stationary planes are set up here, where a frame can still fail */
+	if(filter->lines == NULL && !dwt_plan_set_stationary(filter->plan,
+				filter->encode ? 0 : filter->stationary_levels))
+	{
+		GST_ELEMENT_ERROR (filter, RESOURCE, NO_SPACE_LEFT, (NULL),
+				("could not allocate the planes of %u stationary levels",
+				filter->stationary_levels));
+		return GST_FLOW_ERROR;
+	}
+
+	if(filter->lines)
+		*block = dwt_arena_acquire(filter->width, filter->width, filter->hugepages);
+	else
+		*block = dwt_arena_acquire(filter->width * filter->height, MAX(filter->width, filter->height),
+				filter->hugepages);
+	if(*block == NULL)
 	{
-		dst[i] = src[i];
+		GST_ELEMENT_ERROR (filter, RESOURCE, NO_SPACE_LEFT, (NULL),
+				("could not allocate the coefficient plane"));
+		return GST_FLOW_ERROR;
 	}
+	filter->pDWTBuffer = (*block)->plane;
+	filter->pScratch = (*block)->line;
+
+	return GST_FLOW_OK;
 }
 
-static gboolean apply_wavelet_change(GstDwtFilter *filter, gchar *wavelet_name)
+/* Filters one frame in place through the plane acquired by acquire_block(),
+ * or with encode replaces it by a buffer of its coded coefficients.
+ * Returns the buffer to push, or NULL with an error posted and buf
+ * dropped when buf is shorter than the frame. */
+static GstBuffer *process_frame(GstDwtFilter *filter, GstBuffer *buf, GstBuffer **preview)
 {
-	guint order;
-	if(wavelet_name[1] == 'c' || wavelet_name[1] == 'C')
+	GstMapInfo info;
+	DwtLines *lines = filter->lines;
+	DwtMask *mask = lines ? lines->mask : filter->plan->mask;
+	gboolean encode = filter->encode && lines == NULL;
+	gboolean gather, adaptive, dump, mapped;
+	/* the timing costs two system calls a frame, only when it is logged */
+	gboolean timed = gst_debug_category_get_threshold (gst_dwt_filter_debug) >= GST_LEVEL_LOG;
+	gdouble *dump_frame = NULL;
+	GByteArray *coded = NULL;
+	guint preview_level = 0, preview_width = 0, preview_height = 0;
+	gsize preview_tile = 0;
+	gsize tile_size = filter->width * filter->tile_height;
+	guint t;
+	int i;
+	struct timespec t1 = { 0 }, t2 = { 0 }, diff;
+
+	if(encode)
 	{
-		order = atoi(wavelet_name + 2);
-		switch(wavelet_name[0])
+		if(filter->codec == NULL || filter->codec->width != filter->width ||
+				filter->codec->height != filter->tile_height)
 		{
-		case 'h':
-		case 'H':
-			filter->w = gsl_wavelet_alloc(gsl_wavelet_haar_centered, order);
-			return filter->w != NULL;
-		case 'd':
-		case 'D':
-			filter->w = gsl_wavelet_alloc(gsl_wavelet_daubechies_centered, order);
-			return filter->w != NULL;
-		case 'b':
-		case 'B':
-			filter->w = gsl_wavelet_alloc(gsl_wavelet_bspline_centered, order);
-			return filter->w != NULL;
-		default:
-			return FALSE;
+			dwt_codec_free (filter->codec);
+			filter->codec = dwt_codec_new (filter->width, filter->tile_height);
 		}
+		coded = g_byte_array_new ();
+		dwt_codec_write_header(coded, filter->width, filter->tile_height,
+				filter->n_tiles, filter->quant_step);
+	}
+	if(!encode || filter->stats_meta)
+		buf = gst_buffer_make_writable (buf);
+
+	mapped = gst_buffer_map (buf, &info, encode ? GST_MAP_READ : GST_MAP_WRITE);
+	if(!mapped || info.size < (gsize) filter->width * filter->height)
+	{
+		if(mapped)
+			gst_buffer_unmap (buf, &info);
+		GST_ELEMENT_ERROR (filter, STREAM, FORMAT, (NULL),
+				("frame of %" G_GSIZE_FORMAT " bytes for %dx%d",
+				gst_buffer_get_size (buf), filter->width, filter->height));
+		if(coded)
+			g_byte_array_free (coded, TRUE);
+		gst_buffer_unref (buf);
+		return NULL;
+	}
+	if(lines == NULL)
+		dwt_plane_from_u8(info.data, filter->pDWTBuffer, filter->height * filter->width);
+
+	if(timed)
+		clock_gettime(CLOCK_REALTIME, &t1);
+
+	/* The band selection, the subband gains and the windows are compiled
+	 * into the mask only when they change, the windows incrementally so
+	 * moving boxes only rebuild the rows they touch. Packed tiles share
+	 * the mask, so tiles without windows of their own cost nothing. */
+	collect_windows(filter, buf);
+	if(lines)
+	{
+		dwt_lines_set_kernel(lines, &filter->active_wavelet->kernel);
+		dwt_lines_set_inverse(lines, filter->inverse);
 	}
 	else
 	{
-		order = atoi(wavelet_name + 1);
-		switch(wavelet_name[0])
+		dwt_plan_set_kernel(filter->plan, &filter->active_wavelet->kernel);
+		dwt_plan_set_inverse(filter->plan, filter->inverse && !encode);
+		/* the coded stream has no room for the tree, and the adaptive
+		 * cutoff is worked out on the dyadic layout */
+		dwt_plan_set_packets(filter->plan, encode || filter->cutoff_energy > 0 ||
+				filter->plan->stationary_levels > 0 ? 0 : filter->packet_levels);
+		/* dwtdecoder undoes the separable transform only */
+		dwt_plan_set_lifting(filter->plan, encode ? NULL : filter->active_wavelet->lifting);
+	}
+
+	/* the statistics come from the decimated forward transform, gathered
+	 * on the rows as the mask is applied; only the adaptive cutoff, known
+	 * once the whole tile is transformed, masks on a pass of its own */
+	gather = lines == NULL && filter->plan->stationary_levels == 0 &&
+		filter->plan->packet_levels == 0 && (filter->cutoff_energy > 0 || filter->stats_meta);
+	adaptive = gather && filter->cutoff_energy > 0;
+	if(gather && (filter->stats == NULL || filter->stats->width != filter->width ||
+			filter->stats->height != filter->tile_height))
+	{
+		dwt_stats_free (filter->stats);
+		filter->stats = dwt_stats_new (filter->width, filter->tile_height);
+	}
+	if(gather)
+		filter->stats->small_threshold = filter->stats_threshold;
+	if(lines == NULL)
+		dwt_plan_set_stats(filter->plan, gather ? filter->stats : NULL);
+
+	/* the coefficients are dumped between the forward transform and the
+	 * mask, which then runs as a pass of its own; dwtreplaysrc has no
+	 * directions to undo the lifting with */
+	dump = lines == NULL && filter->plan->stationary_levels == 0 &&
+		filter->plan->packet_levels == 0 && filter->plan->lifting == NULL && open_dump(filter);
+	if(dump)
+		dump_frame = dwt_dump_begin(filter->dump);
+
+	if(!adaptive)
+		dwt_mask_set_band(mask, filter->band == GST_DWTFILTER_HIGHPASS, filter->cutoff);
+	GST_OBJECT_LOCK (filter);
+	dwt_mask_set_subbands(mask,
+			(DwtSubbandRule *) filter->subbands->data, filter->subbands->len);
+	GST_OBJECT_UNLOCK (filter);
+
+	/* the LL band is picked up while the rows are transformed, each tile
+	 * giving its own part of the preview */
+	if(preview)
+	{
+		preview_size(filter, &preview_level, &preview_width, &preview_height);
+		preview_tile = preview_width * (preview_height / filter->n_tiles);
+		if(filter->preview_alloc < preview_width * preview_height)
 		{
-		case 'h':
-		case 'H':
-			filter->w = gsl_wavelet_alloc(gsl_wavelet_haar, order);
-			return filter->w != NULL;
-		case 'd':
-		case 'D':
-			filter->w = gsl_wavelet_alloc(gsl_wavelet_daubechies, order);
-			return filter->w != NULL;
-		case 'b':
-		case 'B':
-			filter->w = gsl_wavelet_alloc(gsl_wavelet_bspline, order);
-			return filter->w != NULL;
-		default:
-			return FALSE;
+			g_free (filter->preview_plane);
+			filter->preview_alloc = preview_width * preview_height;
+			filter->preview_plane = g_new (gdouble, filter->preview_alloc);
 		}
 	}
-	return FALSE;
-}
 
-static void copy_higher_details(gdouble* dest, gdouble* src,
-	guint width, guint height, guint x, guint y, guint block_width, guint block_height)
-{
-	guint scale;
-	guint x_scaled;
-	guint y_scaled;
-	guint block_width_scaled;
-	guint block_height_scaled;
-	int i, j;
+	for(t = 0; t < filter->n_tiles; t++)
+	{
+		GArray *windows = filter->windows;
+		guint cutoff = filter->cutoff;
+
+		if(filter->n_tiles > 1)
+		{
+			tile_windows(filter, t, filter->tile_windows);
+			windows = filter->tile_windows;
+		}
+		dwt_mask_set_windows(mask, (DwtWindow *) windows->data, windows->len);
 
-//	g_print ("copy_higher_details x=%u y=%u w=%u h=%u\n", x, y, width, height);
+		/* every output row lags the input rows it depends on, so it is
+		 * written back over the frame in place */
+		if(lines)
+		{
+			guint r;
 
-//	for(scale = 64; scale <= 64; scale *= 2)
-//	for(scale = 16; scale <= 128; scale *= 2)
-	for(scale = 2; scale <= height / 2; scale *= 2)
+			filter->line_tile = info.data + t * tile_size;
+			dwt_lines_set_preview(lines, preview_level,
+					preview ? filter->preview_plane + t * preview_tile : NULL);
+			dwt_lines_begin(lines, write_line, filter);
+			for(r = 0; r < filter->tile_height; r++)
+			{
+				dwt_plane_from_u8(filter->line_tile + r * filter->width, filter->pDWTBuffer,
+						filter->width);
+				dwt_lines_push(lines, filter->pDWTBuffer);
+			}
+			continue;
+		}
+
+		dwt_plan_set_preview(filter->plan, preview_level,
+				preview ? filter->preview_plane + t * preview_tile : NULL);
+		if(gather)
+			dwt_stats_reset(filter->stats);
+		if(adaptive || dump)
+		{
+			gdouble *data = filter->pDWTBuffer + t * tile_size;
+
+			dwt_plan_forward(filter->plan, data, filter->pScratch);
+			if(dump)
+				memcpy(dump_frame + t * tile_size, data, tile_size * sizeof (gdouble));
+			if(adaptive)
+			{
+				cutoff = dwt_stats_energy_cutoff(filter->stats, filter->cutoff_energy);
+				dwt_mask_set_band(mask, filter->band == GST_DWTFILTER_HIGHPASS, cutoff);
+			}
+			dwt_plan_synthesize(filter->plan, data, data, filter->pScratch);
+		}
+		else
+			dwt_plan_execute(filter->plan, filter->pDWTBuffer + t * tile_size, filter->pScratch);
+		if(gather && filter->stats_meta)
+			gst_buffer_add_dwt_stats_meta(buf, filter->stats, t, cutoff);
+
+		/* the coefficients are still in cache, code them right away */
+		if(encode)
+			dwt_codec_encode(filter->codec, filter->pDWTBuffer + t * tile_size,
+					filter->quant_step, coded);
+	}
+	if(dump)
+		dwt_dump_commit(filter->dump, GST_BUFFER_PTS (buf));
+
+	if(timed)
+		clock_gettime(CLOCK_REALTIME, &t2);
+
+	if(preview && preview_level > 0)
 	{
-		x_scaled = 1.* x * scale / width;
-		y_scaled = 1.* y * scale / height;
-		block_width_scaled  = 1. * block_width * scale / width;
-		block_height_scaled  = 1. * block_height * scale / height;
+		GstMapInfo pinfo;
+
+		*preview = gst_buffer_new_allocate (NULL, preview_width * preview_height, NULL);
+		gst_buffer_copy_into (*preview, buf,
+				GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+		gst_buffer_map (*preview, &pinfo, GST_MAP_WRITE);
+		dwt_plane_to_u8(filter->preview_plane, pinfo.data, preview_width * preview_height);
+		gst_buffer_unmap (*preview, &pinfo);
+	}
 
-		for(i = 0; i < scale; i++)
+	if(encode)
+	{
+		GstBuffer *out;
+		gsize size = coded->len;
+
+		gst_buffer_unmap (buf, &info);
+
+		out = gst_buffer_new_wrapped (g_byte_array_free (coded, FALSE), size);
+		gst_buffer_copy_into (out, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+		gst_buffer_unref (buf);
+		return out;
+	}
+
+	if(lines == NULL)
+		dwt_plane_to_u8(filter->pDWTBuffer, info.data, filter->height * filter->width);
+
+	if(filter->phof && filter->phof_outline)
+	{
+		for(t = 0; t < filter->n_tiles; t++)
 		{
-			for(j = 0; j < block_width_scaled; j++)
+			for(i = 0; i < filter->n_phof_windows; i++)
 			{
-				dest[(i) + (j + y_scaled + scale) * width] =
-					src[(i) + (j + y_scaled + scale) * width];
+				dwt_draw_window_outline(info.data + t * tile_size, filter->width, filter->tile_height,
+						&g_array_index(filter->windows, DwtWindow, i));
 			}
 		}
+	}
 
-		for(i = 0; i < block_width_scaled; i++)
+	gst_buffer_unmap (buf, &info);
+
+	if(timed)
+	{
+		if(t2.tv_nsec >= t1.tv_nsec)
 		{
-			for(j = 0; j < scale; j++)
+			diff.tv_sec = t2.tv_sec - t1.tv_sec;
+			diff.tv_nsec = t2.tv_nsec - t1.tv_nsec;
+		}
+		else
+		{
+			diff.tv_sec = t2.tv_sec - t1.tv_sec - 1;
+			diff.tv_nsec = 1000000000 + t2.tv_nsec - t1.tv_nsec;
+		}
+		GST_LOG_OBJECT (filter, "transform took %ld.%09ld s", (glong) diff.tv_sec, diff.tv_nsec);
+	}
+
+	return buf;
+}
+
+static gboolean process_list_item(GstBuffer **buf, guint idx, gpointer user_data)
+{
+	GstDwtFilter *filter = user_data;
+	GstBuffer *preview = NULL;
+
+	*buf = process_frame(filter, *buf, filter->list_preview ? &preview : NULL);
+	if(*buf == NULL)
+	{
+		filter->list_failed = TRUE;
+		return FALSE;
+	}
+	if(preview)
+		gst_buffer_list_add (filter->list_previews, preview);
+
+	return TRUE;
+}
+
+/* Keeps the dump file matching the location, the frame layout and the
+ * wavelet, starting it over when they change. Only the location is read
+ * under the lock, dump_opened belongs to the streaming thread. A file
+ * that cannot be written ends the dumping with a warning. */
+static gboolean open_dump(GstDwtFilter *filter)
+{
+	const DwtWavelet *w = filter->active_wavelet;
+	DwtDumpHeader *h;
+	gboolean moved;
+	gchar wavelet[8];
+
+	GST_OBJECT_LOCK (filter);
+	if(filter->dump_location == NULL)
+	{
+		GST_OBJECT_UNLOCK (filter);
+		dwt_dump_close (filter->dump);
+		filter->dump = NULL;
+		return FALSE;
+	}
+	moved = g_strcmp0 (filter->dump_location, filter->dump_opened) != 0;
+	if(moved)
+	{
+		g_free (filter->dump_opened);
+		filter->dump_opened = g_strdup (filter->dump_location);
+	}
+	GST_OBJECT_UNLOCK (filter);
+
+	g_snprintf (wavelet, sizeof (wavelet), "%c%s%u", w->family, w->centered ? "c" : "", w->order);
+	h = filter->dump ? filter->dump->header : NULL;
+	if(moved || h == NULL || h->width != filter->width || h->height != filter->height ||
+			h->tile_height != filter->tile_height || h->slots != filter->dump_frames ||
+			strcmp (h->wavelet, wavelet) != 0)
+	{
+		dwt_dump_close (filter->dump);
+		filter->dump = dwt_dump_create (filter->dump_opened, filter->width, filter->height,
+				filter->tile_height, wavelet, filter->dump_frames);
+		if(filter->dump == NULL)
+		{
+			GST_ELEMENT_WARNING (filter, RESOURCE, OPEN_WRITE, (NULL),
+					("cannot map the dump file \"%s\", not dumping", filter->dump_opened));
+			GST_OBJECT_LOCK (filter);
+			if(g_strcmp0 (filter->dump_location, filter->dump_opened) == 0)
 			{
-				dest[(i + x_scaled + scale) + (j) * width] =
-					src[(i + x_scaled + scale) + (j) * width];
+				g_free (filter->dump_location);
+				filter->dump_location = NULL;
 			}
+			GST_OBJECT_UNLOCK (filter);
+		}
+	}
+
+	return filter->dump != NULL;
+}
+
+/* the windows of one packed tile in tile coordinates: the phof windows
+ * as they are, the others clipped to the tile and moved up to it */
+static void tile_windows(GstDwtFilter *filter, guint tile, GArray *out)
+{
+	guint top = tile * filter->tile_height;
+	guint bottom = top + filter->tile_height;
+	guint i;
+
+	g_array_set_size(out, 0);
+	g_array_append_vals(out, filter->windows->data, filter->n_phof_windows);
+
+	for(i = filter->n_phof_windows; i < filter->windows->len; i++)
+	{
+		DwtWindow win = g_array_index(filter->windows, DwtWindow, i);
+		guint y0 = MAX(win.y, top);
+		guint y1 = MIN(win.y + win.h, bottom);
+
+		if(y0 >= y1)
+			continue;
+
+		win.y = y0 - top;
+		win.h = y1 - y0;
+		g_array_append_val(out, win);
+	}
+}
+
+/* gathers the windows of the current frame: with phof the phofx/phofy/phofw/phofh
+ * rectangle and the phof-windows list, followed by the region of interest metas.
+ * The phof ones are counted in n_phof_windows. */
+static void collect_windows(GstDwtFilter *filter, GstBuffer *buf)
+{
+	GstMeta *meta;
+	gpointer state = NULL;
+	GQuark roi_type;
+
+	g_array_set_size(filter->windows, 0);
+
+	GST_OBJECT_LOCK (filter);
+	if(filter->phof)
+	{
+		if(filter->phof_window.w > 0 && filter->phof_window.h > 0)
+		{
+			DwtWindow win = { filter->phof_window.x, filter->phof_window.y,
+					filter->phof_window.w, filter->phof_window.h };
+			g_array_append_val(filter->windows, win);
+		}
+		g_array_append_vals(filter->windows, filter->phof_windows->data, filter->phof_windows->len);
+	}
+	roi_type = filter->roi_type_quark;
+	GST_OBJECT_UNLOCK (filter);
+
+	filter->n_phof_windows = filter->windows->len;
+
+	if(!filter->roi_meta)
+		return;
+
+	while((meta = gst_buffer_iterate_meta(buf, &state)) != NULL)
+	{
+		GstVideoRegionOfInterestMeta *roi;
+		DwtWindow win;
+
+		if(meta->info->api != GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE)
+			continue;
+
+		roi = (GstVideoRegionOfInterestMeta *) meta;
+		if(roi_type != 0 && roi->roi_type != roi_type)
+			continue;
+
+		win.x = roi->x;
+		win.y = roi->y;
+		win.w = roi->w;
+		win.h = roi->h;
+		g_array_append_val(filter->windows, win);
+	}
+}
+
+static GstPad *
+gst_dwt_filter_request_new_pad (GstElement * element, GstPadTemplate * templ,
+		const gchar * name, const GstCaps * caps)
+{
+	GstDwtFilter *filter = GST_DWTFILTER (element);
+	GstPad *pad;
+
+	GST_OBJECT_LOCK (filter);
+	if(filter->previewpad)
+	{
+		GST_OBJECT_UNLOCK (filter);
+		GST_WARNING_OBJECT (filter, "there is only one preview pad");
+		return NULL;
+	}
+	pad = gst_pad_new_from_template (templ, "preview");
+	gst_pad_use_fixed_caps (pad);
+	filter->previewpad = pad;
+	GST_OBJECT_UNLOCK (filter);
+
+	gst_element_add_pad (element, pad);
+
+	/* catch up with the stream that is already flowing */
+	gst_pad_sticky_events_foreach (filter->srcpad, copy_sticky_event, filter);
+
+	return pad;
+}
+
+static void
+gst_dwt_filter_release_pad (GstElement * element, GstPad * pad)
+{
+	GstDwtFilter *filter = GST_DWTFILTER (element);
+
+	GST_OBJECT_LOCK (filter);
+	if(pad == filter->previewpad)
+		filter->previewpad = NULL;
+	GST_OBJECT_UNLOCK (filter);
+
+	gst_element_remove_pad (element, pad);
+}
+
+/* an unlinked or finished preview does not stop the main output */
+static GstFlowReturn combine_preview_flow(GstFlowReturn ret, GstFlowReturn preview_ret)
+{
+	if(ret != GST_FLOW_OK || preview_ret == GST_FLOW_NOT_LINKED || preview_ret == GST_FLOW_EOS)
+		return ret;
+
+	return preview_ret;
+}
+
+/* the preview pad with a reference, NULL when none was requested */
+static GstPad *get_preview_pad(GstDwtFilter *filter)
+{
+	GstPad *pad = NULL;
+
+	GST_OBJECT_LOCK (filter);
+	if(filter->previewpad)
+		pad = gst_object_ref (filter->previewpad);
+	GST_OBJECT_UNLOCK (filter);
+
+	return pad;
+}
+
+/* The preview pad with a reference, its caps updated when preview-level
+ * changed the size since they were sent. */
+static GstPad *prepare_preview(GstDwtFilter *filter)
+{
+	GstPad *pad = get_preview_pad(filter);
+	guint level, width, height;
+	GstCaps *caps;
+
+	if(pad == NULL)
+		return NULL;
+
+	preview_size(filter, &level, &width, &height);
+	if(width != filter->preview_caps_width || height != filter->preview_caps_height)
+	{
+		caps = gst_pad_get_current_caps (filter->sinkpad);
+		if(caps)
+		{
+			gst_pad_push_event (pad, preview_caps_event(filter, caps));
+			gst_caps_unref (caps);
 		}
+	}
+
+	return pad;
+}
+
+/* output row r of the line transform */
+static void write_line(guint r, const gdouble *row, gpointer user_data)
+{
+	GstDwtFilter *filter = user_data;
+
+	dwt_plane_to_u8(row, filter->line_tile + r * filter->width, filter->width);
+}
+
+/* preview-level clipped to the tiles and to the stationary levels, and the
+ * size of the preview frame */
+static void preview_size(GstDwtFilter *filter, guint *level, guint *width, guint *height)
+{
+	*level = MIN(filter->preview_level, dwt_max_level(filter->width, filter->tile_height));
+	if(filter->stationary_levels > 0 && !filter->encode)
+		*level = MIN(*level, filter->stationary_levels);
+	*width = filter->width >> *level;
+	*height = (filter->tile_height >> *level) * filter->n_tiles;
+}
 
-		for(i = 0; i < block_width_scaled; i++)
+/* the caps of the sink scaled down to the preview */
+static GstEvent *preview_caps_event(GstDwtFilter *filter, GstCaps *caps)
+{
+	guint level, width, height;
+
+	caps = gst_caps_copy (caps);
+	preview_size(filter, &level, &width, &height);
+	filter->preview_caps_width = width;
+	filter->preview_caps_height = height;
+	gst_caps_set_simple (caps,
+			"width", G_TYPE_INT, width,
+			"height", G_TYPE_INT, height, NULL);
+
+	return gst_event_new_caps (caps);
+}
+
+/* Replays the sticky events of the main output on a new preview pad.
+ * Coded caps are replaced with preview caps from the sink. */
+static gboolean copy_sticky_event(GstPad *pad, GstEvent **event, gpointer user_data)
+{
+	GstDwtFilter *filter = user_data;
+	GstPad *preview = get_preview_pad(filter);
+	GstEvent *copy = gst_event_ref (*event);
+
+	if(preview == NULL)
+	{
+		gst_event_unref (copy);
+		return FALSE;
+	}
+
+	if(GST_EVENT_TYPE (*event) == GST_EVENT_CAPS)
+	{
+		GstCaps *caps = gst_pad_get_current_caps (filter->sinkpad);
+
+		gst_event_unref (copy);
+		copy = caps ? preview_caps_event(filter, caps) : NULL;
+		if(caps)
+			gst_caps_unref (caps);
+	}
+
+	if(copy)
+		gst_pad_push_event (preview, copy);
+	gst_object_unref (preview);
+
+	return TRUE;
+}
+
+/* What the sink takes: any GRAY8 frame while encoding, since downstream
+ * takes the coded stream, else what the main output's peer accepts. */
+static GstCaps *sink_allowed_caps(GstDwtFilter *filter, GstPad *pad, GstCaps *filt)
+{
+	GstCaps *templ = gst_pad_get_pad_template_caps (pad);
+	GstCaps *caps;
+
+	if(filter->encode)
+		caps = gst_caps_ref (templ);
+	else
+	{
+		GstCaps *peer = gst_pad_peer_query_caps (filter->srcpad, filt);
+
+		caps = gst_caps_intersect_full (peer, templ, GST_CAPS_INTERSECT_FIRST);
+		gst_caps_unref (peer);
+	}
+	gst_caps_unref (templ);
+
+	if(filt)
+	{
+		GstCaps *tmp = gst_caps_intersect_full (filt, caps, GST_CAPS_INTERSECT_FIRST);
+
+		gst_caps_unref (caps);
+		caps = tmp;
+	}
+
+	return caps;
+}
+
+/* caps of the coded stream for the raw caps of the sink */
+static GstCaps *coded_caps(GstDwtFilter *filter, GstCaps *caps)
+{
+	GstStructure *s = gst_caps_get_structure (caps, 0);
+	GstCaps *out;
+	gint num, den;
+
+	out = gst_caps_new_simple ("video/x-dwt",
+			"width", G_TYPE_INT, filter->width,
+			"height", G_TYPE_INT, filter->height,
+			"wavelet", G_TYPE_STRING, filter->wavelet_name, NULL);
+	if(gst_structure_get_fraction (s, "framerate", &num, &den))
+		gst_caps_set_simple (out, "framerate", GST_TYPE_FRACTION, num, den, NULL);
+
+	return out;
+}
+
+/* answers a caps query with caps, narrowed by its filter; takes caps */
+static gboolean answer_caps_query(GstQuery *query, GstCaps *caps)
+{
+	GstCaps *filt;
+
+	gst_query_parse_caps (query, &filt);
+	if(filt)
+	{
+		GstCaps *tmp = gst_caps_intersect_full (filt, caps, GST_CAPS_INTERSECT_FIRST);
+
+		gst_caps_unref (caps);
+		caps = tmp;
+	}
+	gst_query_set_caps_result (query, caps);
+	gst_caps_unref (caps);
+
+	return TRUE;
+}
+
+/* With output-queue the src pad gets a task pushing the queued frames
+ * while it is active. */
+static gboolean gst_dwt_filter_src_activate_mode(GstPad *pad, GstObject *parent,
+		GstPadMode mode, gboolean active)
+{
+	GstDwtFilter *filter = GST_DWTFILTER (parent);
+	gboolean ret;
+
+	if(mode != GST_PAD_MODE_PUSH)
+		return FALSE;
+
+	if(active)
+	{
+		filter->out_size = filter->output_queue;
+		g_mutex_lock (&filter->out_lock);
+		filter->out_max_level = 0;
+		filter->out_pushed = 0;
+		filter->out_dropped = 0;
+		g_mutex_unlock (&filter->out_lock);
+		set_output_flushing(filter, FALSE);
+
+		return filter->out_size == 0 || gst_pad_start_task (pad, output_loop, filter, NULL);
+	}
+
+	set_output_flushing(filter, TRUE);
+	ret = gst_pad_stop_task (pad);
+	filter->out_size = 0;
+
+	return ret;
+}
+
+/* a frame or a buffer list for the src pad, through the queue if any */
+static GstFlowReturn push_output(GstDwtFilter *filter, GstMiniObject *item)
+{
+	if(filter->out_size > 0)
+		return queue_output(filter, item);
+
+	if(GST_IS_BUFFER_LIST (item))
+		return gst_pad_push_list (filter->srcpad, GST_BUFFER_LIST (item));
+
+	return gst_pad_push (filter->srcpad, GST_BUFFER (item));
+}
+
+/* serialized events stay behind the frames queued before them */
+static gboolean push_output_event(GstDwtFilter *filter, GstEvent *event)
+{
+	if(filter->out_size == 0 || !GST_EVENT_IS_SERIALIZED (event))
+		return gst_pad_push_event (filter->srcpad, event);
+
+	return queue_output(filter, GST_MINI_OBJECT_CAST (event)) != GST_FLOW_FLUSHING;
+}
+
+/* the default forwarding, with the src pad going through the queue */
+static gboolean forward_event(GstDwtFilter *filter, GstPad *pad, GstEvent *event)
+{
+	GstPad *preview;
+
+	if(filter->out_size == 0 || !GST_EVENT_IS_SERIALIZED (event))
+		return gst_pad_event_default (pad, GST_OBJECT (filter), event);
+
+	preview = get_preview_pad(filter);
+	if(preview)
+	{
+		gst_pad_push_event (preview, gst_event_ref (event));
+		gst_object_unref (preview);
+	}
+
+	return push_output_event(filter, event);
+}
+
+/* Hands an item to the task. A full queue blocks, or with leaky drops the
+ * new frame or the oldest queued one; events are never dropped and do not
+ * wait. Frames are refused with the result of the last push once it
+ * failed, until a flush; not linked is only passed on. */
+static GstFlowReturn queue_output(GstDwtFilter *filter, GstMiniObject *item)
+{
+	gboolean event = GST_IS_EVENT (item);
+	GstMiniObject *dropped = NULL;
+	GstFlowReturn ret = GST_FLOW_OK;
+
+	g_mutex_lock (&filter->out_lock);
+	for(;;)
+	{
+		GList *l;
+
+		if(filter->out_flushing)
+		{
+			ret = GST_FLOW_FLUSHING;
+			break;
+		}
+		if(!event && filter->out_flow != GST_FLOW_OK && filter->out_flow != GST_FLOW_NOT_LINKED)
+		{
+			ret = filter->out_flow;
+			break;
+		}
+		if(event || g_queue_get_length (&filter->out_queue) < filter->out_size)
+			break;
+
+		if(filter->output_leaky == GST_DWTFILTER_LEAKY_UPSTREAM)
+		{
+			filter->out_dropped++;
+			break;
+		}
+		if(filter->output_leaky == GST_DWTFILTER_LEAKY_DOWNSTREAM)
 		{
-			for(j = 0; j < block_width_scaled; j++)
+			for(l = filter->out_queue.head; l != NULL && GST_IS_EVENT (l->data); l = l->next);
+			if(l != NULL)
 			{
-//				dest[(i + x_scaled + scale) + (j + y_scaled) * width] =
-//					src[(i + x_scaled + scale) + (j + y_scaled) * width];
-//				dest[(i + x_scaled) + (j + y_scaled + scale) * width] =
-//					src[(i + x_scaled) + (j + y_scaled + scale) * width];
-				dest[(i + x_scaled + scale) + (j + y_scaled + scale) * width] =
-					src[(i + x_scaled + scale) + (j + y_scaled + scale) * width];
+				dropped = l->data;
+				g_queue_delete_link (&filter->out_queue, l);
+				filter->out_dropped++;
+				continue;
 			}
 		}
 
+		g_cond_wait (&filter->out_cond, &filter->out_lock);
+	}
+
+	if(ret == GST_FLOW_OK && (event || g_queue_get_length (&filter->out_queue) < filter->out_size))
+	{
+		g_queue_push_tail (&filter->out_queue, item);
+		filter->out_max_level = MAX(filter->out_max_level, g_queue_get_length (&filter->out_queue));
+		g_cond_broadcast (&filter->out_cond);
+		if(!event)
+			ret = filter->out_flow;
+		item = NULL;
+	}
+	g_mutex_unlock (&filter->out_lock);
+
+	if(item)
+		gst_mini_object_unref (item);
+	if(dropped)
+		gst_mini_object_unref (dropped);
+
+	return ret;
+}
+
+/* Flushing drops what is queued and wakes up the task and the streaming
+ * thread; leaving it restarts with a clean flow. */
+static void set_output_flushing(GstDwtFilter *filter, gboolean flushing)
+{
+	g_mutex_lock (&filter->out_lock);
+	filter->out_flushing = flushing;
+	if(flushing)
+		g_queue_clear_full (&filter->out_queue, (GDestroyNotify) gst_mini_object_unref);
+	else
+		filter->out_flow = GST_FLOW_OK;
+	g_cond_broadcast (&filter->out_cond);
+	g_mutex_unlock (&filter->out_lock);
+}
+
+/* waits until the task pushed everything queued so far, or paused on a
+ * flush or an error and will not push it */
+static void drain_output(GstDwtFilter *filter)
+{
+	if(filter->out_size == 0)
+		return;
+
+	g_mutex_lock (&filter->out_lock);
+	while(!filter->out_flushing &&
+			(filter->out_flow == GST_FLOW_OK || filter->out_flow == GST_FLOW_NOT_LINKED) &&
+			(!g_queue_is_empty (&filter->out_queue) || filter->out_busy))
+		g_cond_wait (&filter->out_cond, &filter->out_lock);
+	g_mutex_unlock (&filter->out_lock);
+}
+
+/* the task of the src pad: pushes one queued item per iteration and
+ * pauses at EOS, on errors and when flushing */
+static void output_loop(gpointer user_data)
+{
+	GstDwtFilter *filter = user_data;
+	GstMiniObject *item;
+	GstFlowReturn ret = GST_FLOW_OK;
+	gboolean frame;
+
+	g_mutex_lock (&filter->out_lock);
+	while(g_queue_is_empty (&filter->out_queue) && !filter->out_flushing)
+		g_cond_wait (&filter->out_cond, &filter->out_lock);
+	if(filter->out_flushing)
+	{
+		g_mutex_unlock (&filter->out_lock);
+		gst_pad_pause_task (filter->srcpad);
+		return;
+	}
+	item = g_queue_pop_head (&filter->out_queue);
+	frame = !GST_IS_EVENT (item);
+	filter->out_busy = TRUE;
+	g_cond_broadcast (&filter->out_cond);
+	g_mutex_unlock (&filter->out_lock);
+
+	if(GST_IS_BUFFER (item))
+		ret = gst_pad_push (filter->srcpad, GST_BUFFER (item));
+	else if(GST_IS_BUFFER_LIST (item))
+		ret = gst_pad_push_list (filter->srcpad, GST_BUFFER_LIST (item));
+	else
+	{
+		GstEvent *event = GST_EVENT (item);
+		gboolean eos = GST_EVENT_TYPE (event) == GST_EVENT_EOS;
+
+		gst_pad_push_event (filter->srcpad, event);
+		if(eos)
+			ret = GST_FLOW_EOS;
+	}
+
+	g_mutex_lock (&filter->out_lock);
+	filter->out_busy = FALSE;
+	if(frame)
+		filter->out_pushed++;
+	if(!filter->out_flushing)
+		filter->out_flow = ret;
+	g_cond_broadcast (&filter->out_cond);
+	g_mutex_unlock (&filter->out_lock);
+
+	if(ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED)
+	{
+		GST_DEBUG_OBJECT (filter, "output task pausing: %s", gst_flow_get_name (ret));
+		gst_pad_pause_task (filter->srcpad);
 	}
 }
 
@@ -48,6 +48,13 @@
 
 #include <gst/gst.h>
 
+#include "dwtfilter.h"
+#include "dwtlines.h"
+#include "dwtarena.h"
+#include "dwtcodec.h"
+#include "dwtdump.h"
+#include "gstdwtmeta.h"
+
 G_BEGIN_DECLS
 
 typedef enum {
@@ -55,6 +62,16 @@ typedef enum {
   GST_DWTFILTER_HIGHPASS
 } GstDwtFilterBand;
 
+#define GST_TYPE_DWTFILTER_BAND (gst_dwtfilter_band_get_type ())
+GType gst_dwtfilter_band_get_type (void);
+
+/* what a full output queue does with a new frame */
+typedef enum {
+  GST_DWTFILTER_LEAKY_NO,
+  GST_DWTFILTER_LEAKY_UPSTREAM,
+  GST_DWTFILTER_LEAKY_DOWNSTREAM
+} GstDwtFilterLeaky;
+
 /* #defines don't like whitespacey bits */
 #define GST_TYPE_DWTFILTER \
   (gst_dwt_filter_get_type())
@@ -76,25 +93,87 @@ struct _GstDwtFilter
 
 	GstPad *sinkpad, *srcpad;
 
-	gsl_wavelet *w;
-	gsl_wavelet_workspace *work;
+	const DwtWavelet *wavelet;	/* NULL for unknown names, under the object lock */
+	const DwtWavelet *active_wavelet;	/* of the frame being filtered */
 	gchar *wavelet_name;
 	GstDwtFilterBand band;
+	DwtArenaPages hugepages;
 	guint cutoff;
+	gdouble cutoff_energy;	/* 0 for the fixed cutoff */
+	gboolean stats_meta;
+	gdouble stats_threshold;	/* of the sparsity */
+	DwtStats *stats;	/* of one tile, gathered by the forward transform */
 
 	int width, height;
-	double *pDWTBuffer;
-	double *pTmpBuffer;
-	double *pTmpBuffer2;
-
-	gboolean silent;
+	gboolean packed_tiles;
+	guint tile_height;	/* rows per tile, the height unless packed_tiles */
+	guint n_tiles;
+
+	gboolean encode;
+	gdouble quant_step;
+	DwtCodec *codec;	/* tile sized, while encoding */
+	guint stationary_levels;	/* 0 for the decimated transform */
+	guint packet_levels;	/* 0 for the dyadic decimated transform */
+	gchar *dump_location;	/* under the object lock */
+	gchar *dump_opened;	/* location of dump */
+	guint dump_frames;
+	DwtDump *dump;		/* coefficients for dwtreplaysrc */
+	gboolean line_buffered;
+	gboolean line_buffered_ignored;	/* warned about, until usable again */
+	DwtLines *lines;	/* instead of the plan when line buffered */
+	guint8 *line_tile;	/* tile the line transform writes back to */
+
+	GstPad *previewpad;	/* request pad with the LL band, under the object lock */
+	guint preview_level;
+	guint preview_caps_width, preview_caps_height;	/* size last announced */
+	gdouble *preview_plane;
+	gsize preview_alloc;	/* in doubles */
+	GstPad *list_preview;	/* previews of the list in chain_list */
+	GstBufferList *list_previews;
+	gboolean list_failed;	/* an item of the list in chain_list was refused */
+
+	/* frames waiting for the task pushing on the src pad */
+	guint output_queue;	/* property, taken when the src pad activates */
+	GstDwtFilterLeaky output_leaky;
+	guint out_size;		/* 0 to push from the streaming thread */
+	GMutex out_lock;
+	GCond out_cond;
+	GQueue out_queue;	/* buffers, buffer lists and serialized events */
+	gboolean out_flushing;
+	gboolean out_busy;	/* the task is pushing an item it took */
+	GstFlowReturn out_flow;	/* of the last push of the task */
+	guint out_max_level;
+	guint64 out_pushed, out_dropped;
+
+	double *pDWTBuffer;	/* arena plane, only valid inside the chain function */
+	double *pScratch;	/* arena line, likewise */
+
+	gboolean silent;	/* no info level messages */
+	guint64 qos_events, latency_queries;	/* since the last stop */
 	gboolean inverse;
 	gboolean phof;
 
+	gboolean phof_outline;
+
 	struct
 	{
 		guint x, y, w, h;
 	}phof_window;
+
+	gchar *phof_windows_str;
+	GArray *phof_windows;	/* DwtWindow, set through the phof-windows property */
+	GArray *windows;	/* DwtWindow, every window applied to the current frame */
+	guint n_phof_windows;	/* leading entries of windows coming from phof */
+	GArray *tile_windows;	/* DwtWindow, windows of one packed tile */
+	DwtPlan *plan;		/* transform and mask of one frame or tile, in plans */
+	DwtPlanCache *plans;	/* of the last frame sizes, kept across caps */
+
+	gboolean roi_meta;
+	gchar *roi_type;
+	GQuark roi_type_quark;
+
+	gchar *subbands_str;
+	GArray *subbands;	/* DwtSubbandRule, set through the subbands property */
 };
 
 struct _GstDwtFilterClass 
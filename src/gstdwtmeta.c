@@ -0,0 +1,169 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include "gstdwtmeta.h"
+
+static gboolean gst_dwt_stats_meta_init (GstMeta *meta, gpointer params, GstBuffer *buffer);
+static void gst_dwt_stats_meta_free (GstMeta *meta, GstBuffer *buffer);
+static gboolean gst_dwt_stats_meta_transform (GstBuffer *dest, GstMeta *meta,
+		GstBuffer *buffer, GQuark type, gpointer data);
+
+GType
+gst_dwt_stats_meta_api_get_type (void)
+{
+	static volatile GType type = 0;
+	static const gchar *tags[] = { NULL };
+
+	if (g_once_init_enter (&type)) {
+		GType _type = gst_meta_api_type_register ("GstDwtStatsMetaAPI", tags);
+		g_once_init_leave (&type, _type);
+	}
+	return type;
+}
+
+const GstMetaInfo *
+gst_dwt_stats_meta_get_info (void)
+{
+	static const GstMetaInfo *meta_info = NULL;
+
+	if (g_once_init_enter ((GstMetaInfo **) &meta_info)) {
+		const GstMetaInfo *mi = gst_meta_register (GST_DWT_STATS_META_API_TYPE,
+				"GstDwtStatsMeta", sizeof (GstDwtStatsMeta),
+				gst_dwt_stats_meta_init, gst_dwt_stats_meta_free,
+				gst_dwt_stats_meta_transform);
+		g_once_init_leave ((GstMetaInfo **) &meta_info, (GstMetaInfo *) mi);
+	}
+	return meta_info;
+}
+
+/* the statistics of one frame or tile, as gathered by the plan */
+GstDwtStatsMeta *
+gst_buffer_add_dwt_stats_meta (GstBuffer *buffer, const DwtStats *stats,
+	guint tile, guint cutoff)
+{
+	GstDwtStatsMeta *meta;
+	guint i;
+
+	meta = (GstDwtStatsMeta *) gst_buffer_add_meta (buffer, GST_DWT_STATS_META_INFO, NULL);
+	if (meta == NULL)
+		return NULL;
+
+	meta->tile = tile;
+	meta->width = stats->width;
+	meta->height = stats->height;
+	meta->cutoff = cutoff;
+	meta->total_energy = stats->total;
+	meta->threshold = stats->small_threshold;
+	meta->levels = stats->levels;
+	meta->subbands = g_new0 (GstDwtSubbandStats, 3 * stats->levels + 1);
+	for (i = 0; i < 3 * stats->levels + 1; i++)
+	{
+		const DwtBandStats *band = &stats->bands[i];
+		GstDwtSubbandStats *sub = &meta->subbands[i];
+
+		if (band->count == 0)
+			continue;
+		sub->energy = band->energy;
+		sub->mean = band->sum / band->count;
+		sub->variance = MAX (band->energy / band->count - sub->mean * sub->mean, 0.);
+		sub->sparsity = (gdouble) band->small / band->count;
+	}
+
+	return meta;
+}
+
+static gboolean
+gst_dwt_stats_meta_init (GstMeta *meta, gpointer params, GstBuffer *buffer)
+{
+	GstDwtStatsMeta *smeta = (GstDwtStatsMeta *) meta;
+
+	smeta->tile = 0;
+	smeta->width = smeta->height = 0;
+	smeta->cutoff = 0;
+	smeta->total_energy = 0;
+	smeta->threshold = 0;
+	smeta->levels = 0;
+	smeta->subbands = NULL;
+
+	return TRUE;
+}
+
+static void
+gst_dwt_stats_meta_free (GstMeta *meta, GstBuffer *buffer)
+{
+	g_free (((GstDwtStatsMeta *) meta)->subbands);
+}
+
+/* copies follow the buffer, anything changing the pixels drops them */
+static gboolean
+gst_dwt_stats_meta_transform (GstBuffer *dest, GstMeta *meta,
+		GstBuffer *buffer, GQuark type, gpointer data)
+{
+	GstDwtStatsMeta *smeta = (GstDwtStatsMeta *) meta, *dmeta;
+
+	if (!GST_META_TRANSFORM_IS_COPY (type))
+		return FALSE;
+
+	dmeta = (GstDwtStatsMeta *) gst_buffer_add_meta (dest, GST_DWT_STATS_META_INFO, NULL);
+	if (dmeta == NULL)
+		return FALSE;
+
+	dmeta->tile = smeta->tile;
+	dmeta->width = smeta->width;
+	dmeta->height = smeta->height;
+	dmeta->cutoff = smeta->cutoff;
+	dmeta->total_energy = smeta->total_energy;
+	dmeta->threshold = smeta->threshold;
+	dmeta->levels = smeta->levels;
+	dmeta->subbands = g_new (GstDwtSubbandStats, 3 * smeta->levels + 1);
+	memcpy (dmeta->subbands, smeta->subbands,
+		(3 * smeta->levels + 1) * sizeof (GstDwtSubbandStats));
+
+	return TRUE;
+}
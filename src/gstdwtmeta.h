@@ -0,0 +1,92 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_DWT_META_H__
+#define __GST_DWT_META_H__
+
+#include <gst/gst.h>
+
+#include "dwtstats.h"
+
+G_BEGIN_DECLS
+
+#define GST_DWT_STATS_META_API_TYPE (gst_dwt_stats_meta_api_get_type())
+#define GST_DWT_STATS_META_INFO (gst_dwt_stats_meta_get_info())
+
+typedef struct _GstDwtSubbandStats GstDwtSubbandStats;
+typedef struct _GstDwtStatsMeta GstDwtStatsMeta;
+
+struct _GstDwtSubbandStats
+{
+	gdouble energy;		/* sum of the squares */
+	gdouble mean;
+	gdouble variance;
+	gdouble sparsity;	/* fraction of coefficients below the threshold */
+};
+
+/* Statistics of the DWT coefficients of one frame, or of one tile of a
+ * frame of packed tiles, before the mask. Code outside the plugin links
+ * libgstdwtmeta and includes <dwtfilter/gstdwtmeta.h>. */
+struct _GstDwtStatsMeta
+{
+	GstMeta meta;
+
+	guint tile;		/* index of the tile, 0 for whole frames */
+	guint width, height;	/* of the tile */
+	guint cutoff;		/* applied to the tile */
+	gdouble total_energy;
+	gdouble threshold;	/* of the sparsity */
+	guint levels;
+	GstDwtSubbandStats *subbands;	/* levels x (HL, LH, HH), level 1 first,
+					 * then LL */
+};
+
+GType gst_dwt_stats_meta_api_get_type (void);
+const GstMetaInfo *gst_dwt_stats_meta_get_info (void);
+
+GstDwtStatsMeta *gst_buffer_add_dwt_stats_meta (GstBuffer *buffer,
+	const DwtStats *stats, guint tile, guint cutoff);
+
+G_END_DECLS
+
+#endif /* __GST_DWT_META_H__ */
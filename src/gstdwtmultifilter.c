@@ -0,0 +1,991 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:element-dwtmultifilter
+ *
+ * Filters several GRAY8 streams in one element. Every requested sink_%u
+ * pad gets a src_%u pad with the same number and settings of its own,
+ * given as properties of the sink pad. The frames of all streams are
+ * transformed by one process wide pool of workers, one per processor,
+ * instead of a thread per stream; a stream keeps running on the same
+ * worker while it has frames queued, and idle workers take over the
+ * streams of busy ones. The workers only transform; every src_%u pad has
+ * a task pushing the results, so a sink waiting for preroll or for the
+ * clock holds its stream and never a worker. The streams are independent,
+ * no frames are synchronised across them.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 dwtmultifilter name=m sink_0::cutoff=64 sink_1::band=high \
+ *     videotestsrc ! video/x-raw,format=GRAY8,width=256,height=256 ! m.sink_0 \
+ *     videotestsrc pattern=ball ! video/x-raw,format=GRAY8,width=512,height=512 ! m.sink_1 \
+ *     m.src_0 ! videoconvert ! autovideosink \
+ *     m.src_1 ! videoconvert ! autovideosink
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <gst/gst.h>
+
+#include <stdio.h>
+
+#include "gstdwtmultifilter.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_dwt_multi_filter_debug);
+#define GST_CAT_DEFAULT gst_dwt_multi_filter_debug
+
+enum
+{
+	PROP_0,
+	PROP_MAX_PENDING,
+};
+
+enum
+{
+	PROP_PAD_0,
+	PROP_PAD_WAVELET,
+	PROP_PAD_BAND,
+	PROP_PAD_INVERSE,
+	PROP_PAD_CUTOFF,
+	PROP_PAD_SUBBANDS,
+};
+
+static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink_%u",
+		GST_PAD_SINK,
+		GST_PAD_REQUEST,
+		GST_STATIC_CAPS ("video/x-raw,format=GRAY8")
+);
+
+static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src_%u",
+		GST_PAD_SRC,
+		GST_PAD_SOMETIMES,
+		GST_STATIC_CAPS ("video/x-raw,format=GRAY8")
+);
+
+G_DEFINE_TYPE (GstDwtMultiFilterPad, gst_dwt_multi_filter_pad, GST_TYPE_PAD);
+
+#define gst_dwt_multi_filter_parent_class parent_class
+G_DEFINE_TYPE (GstDwtMultiFilter, gst_dwt_multi_filter, GST_TYPE_ELEMENT);
+
+static void gst_dwt_multi_filter_pad_set_property (GObject * object, guint prop_id,
+		const GValue * value, GParamSpec * pspec);
+static void gst_dwt_multi_filter_pad_get_property (GObject * object, guint prop_id,
+		GValue * value, GParamSpec * pspec);
+static void gst_dwt_multi_filter_pad_finalize (GObject * object);
+
+static void gst_dwt_multi_filter_set_property (GObject * object, guint prop_id,
+		const GValue * value, GParamSpec * pspec);
+static void gst_dwt_multi_filter_get_property (GObject * object, guint prop_id,
+		GValue * value, GParamSpec * pspec);
+
+static GstStateChangeReturn gst_dwt_multi_filter_change_state (GstElement * element,
+		GstStateChange transition);
+static GstPad *gst_dwt_multi_filter_request_new_pad (GstElement * element,
+		GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
+static void gst_dwt_multi_filter_release_pad (GstElement * element, GstPad * pad);
+
+static gboolean gst_dwt_multi_filter_sink_event (GstPad * pad, GstObject * parent, GstEvent * event);
+static gboolean gst_dwt_multi_filter_sink_query (GstPad * pad, GstObject * parent, GstQuery * query);
+static gboolean gst_dwt_multi_filter_src_activate_mode (GstPad * pad, GstObject * parent,
+		GstPadMode mode, gboolean active);
+static GstFlowReturn gst_dwt_multi_filter_chain (GstPad * pad, GstObject * parent, GstBuffer * buf);
+static GstIterator *gst_dwt_multi_filter_iterate_internal_links (GstPad * pad, GstObject * parent);
+
+static gboolean set_wavelet(GstDwtMultiFilterPad *spad, const gchar *name);
+static GList *ref_sink_pads(GstDwtMultiFilter *multi);
+static void start_streams(GstDwtMultiFilter *multi);
+static void stop_streams(GstDwtMultiFilter *multi);
+static void set_streams_flushing(GstDwtMultiFilter *multi, gboolean flushing);
+static void run_item(gpointer item, gpointer user_data);
+static void drop_item(gpointer item);
+static void set_geometry(GstDwtMultiFilterPad *spad, GstCaps *caps);
+static GstFlowReturn filter_frame(GstDwtMultiFilterPad *spad, GstBuffer **buf);
+static void queue_output(GstDwtMultiFilterPad *spad, GstMiniObject *item, GstFlowReturn ret);
+static void set_output_flushing(GstDwtMultiFilterPad *spad, gboolean flushing);
+static void drain_output(GstDwtMultiFilterPad *spad);
+static void output_loop(gpointer user_data);
+
+static void
+gst_dwt_multi_filter_pad_class_init (GstDwtMultiFilterPadClass * klass)
+{
+	GObjectClass *gobject_class = (GObjectClass *) klass;
+
+	gobject_class->set_property = gst_dwt_multi_filter_pad_set_property;
+	gobject_class->get_property = gst_dwt_multi_filter_pad_get_property;
+	gobject_class->finalize = gst_dwt_multi_filter_pad_finalize;
+
+	g_object_class_install_property (gobject_class, PROP_PAD_WAVELET,
+			g_param_spec_string("wavelet", "Wavelet", "Family and order of the wavelet",
+					"h2", G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_PAD_BAND,
+			g_param_spec_enum ("band", "Band",
+					"Determines whether the filter is low-pass or high-pass",
+					GST_TYPE_DWTFILTER_BAND, GST_DWTFILTER_LOWPASS,
+					G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (gobject_class, PROP_PAD_INVERSE,
+			g_param_spec_boolean ("inverse", "Inverse",
+					"Whether or not to perform the inverse DWT after the filter",
+					TRUE, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_PAD_CUTOFF,
+			g_param_spec_uint ("cutoff", "Cutoff",
+					"The cutoff of the filter, not bigger than the image size",
+					0, 8096, 1, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_PAD_SUBBANDS,
+			g_param_spec_string ("subbands", "Subbands",
+					"Gains of individual subbands on top of band and cutoff, "
+					"with the syntax of the dwtfilter property",
+					NULL, G_PARAM_READWRITE));
+}
+
+static void
+gst_dwt_multi_filter_pad_init (GstDwtMultiFilterPad * spad)
+{
+	spad->srcpad = NULL;
+	spad->wavelet_name = g_strdup ("h2");
+	spad->band = GST_DWTFILTER_LOWPASS;
+	spad->cutoff = 1;
+	spad->inverse = TRUE;
+	spad->subbands_str = NULL;
+	spad->subbands = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+	spad->stream = NULL;
+	spad->max_pending = 2;
+	g_mutex_init (&spad->out_lock);
+	g_cond_init (&spad->out_cond);
+	g_queue_init (&spad->out_queue);
+	spad->pending = 0;
+	spad->out_flushing = TRUE;
+	spad->last_flow = GST_FLOW_OK;
+	spad->width = 0;
+	spad->height = 0;
+	spad->plan = NULL;
+
+	set_wavelet(spad, "h2");
+	spad->active_kernel = spad->kernel;
+}
+
+static void
+gst_dwt_multi_filter_pad_set_property (GObject * object, guint prop_id,
+		const GValue * value, GParamSpec * pspec)
+{
+	GstDwtMultiFilterPad *spad = GST_DWTMULTIFILTER_PAD (object);
+
+	switch (prop_id) {
+	case PROP_PAD_WAVELET:
+		if(!set_wavelet(spad, g_value_get_string (value)))
+		{
+			GST_WARNING_OBJECT (spad, "unknown wavelet \"%s\"",
+					g_value_get_string (value));
+			break;
+		}
+		GST_OBJECT_LOCK (spad);
+		g_free (spad->wavelet_name);
+		spad->wavelet_name = g_value_dup_string (value);
+		GST_OBJECT_UNLOCK (spad);
+		break;
+	case PROP_PAD_BAND:
+		GST_OBJECT_LOCK (spad);
+		spad->band = g_value_get_enum (value);
+		GST_OBJECT_UNLOCK (spad);
+		break;
+	case PROP_PAD_INVERSE:
+		GST_OBJECT_LOCK (spad);
+		spad->inverse = g_value_get_boolean (value);
+		GST_OBJECT_UNLOCK (spad);
+		break;
+	case PROP_PAD_CUTOFF:
+		GST_OBJECT_LOCK (spad);
+		spad->cutoff = g_value_get_uint (value);
+		GST_OBJECT_UNLOCK (spad);
+		break;
+	case PROP_PAD_SUBBANDS:
+	{
+		GArray *rules = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+
+		if(!dwt_subband_rules_parse(g_value_get_string (value), rules))
+		{
+			GST_WARNING_OBJECT (spad, "invalid subbands \"%s\"",
+					g_value_get_string (value));
+			g_array_free (rules, TRUE);
+			break;
+		}
+
+		GST_OBJECT_LOCK (spad);
+		g_array_free (spad->subbands, TRUE);
+		spad->subbands = rules;
+		g_free (spad->subbands_str);
+		spad->subbands_str = g_value_dup_string (value);
+		GST_OBJECT_UNLOCK (spad);
+		break;
+	}
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+gst_dwt_multi_filter_pad_get_property (GObject * object, guint prop_id,
+		GValue * value, GParamSpec * pspec)
+{
+	GstDwtMultiFilterPad *spad = GST_DWTMULTIFILTER_PAD (object);
+
+	GST_OBJECT_LOCK (spad);
+	switch (prop_id) {
+	case PROP_PAD_WAVELET:
+		g_value_set_string (value, spad->wavelet_name);
+		break;
+	case PROP_PAD_BAND:
+		g_value_set_enum (value, spad->band);
+		break;
+	case PROP_PAD_INVERSE:
+		g_value_set_boolean (value, spad->inverse);
+		break;
+	case PROP_PAD_CUTOFF:
+		g_value_set_uint (value, spad->cutoff);
+		break;
+	case PROP_PAD_SUBBANDS:
+		g_value_set_string (value, spad->subbands_str);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+	GST_OBJECT_UNLOCK (spad);
+}
+
+static void
+gst_dwt_multi_filter_pad_finalize (GObject * object)
+{
+	GstDwtMultiFilterPad *spad = GST_DWTMULTIFILTER_PAD (object);
+
+	g_free (spad->wavelet_name);
+	g_free (spad->subbands_str);
+	g_array_free (spad->subbands, TRUE);
+	dwt_plan_free (spad->plan);
+	g_queue_clear_full (&spad->out_queue, (GDestroyNotify) gst_mini_object_unref);
+	g_mutex_clear (&spad->out_lock);
+	g_cond_clear (&spad->out_cond);
+
+	G_OBJECT_CLASS (gst_dwt_multi_filter_pad_parent_class)->finalize (object);
+}
+
+static void
+gst_dwt_multi_filter_class_init (GstDwtMultiFilterClass * klass)
+{
+	GObjectClass *gobject_class;
+	GstElementClass *gstelement_class;
+
+	gobject_class = (GObjectClass *) klass;
+	gstelement_class = (GstElementClass *) klass;
+
+	gobject_class->set_property = gst_dwt_multi_filter_set_property;
+	gobject_class->get_property = gst_dwt_multi_filter_get_property;
+
+	gstelement_class->change_state = gst_dwt_multi_filter_change_state;
+	gstelement_class->request_new_pad = gst_dwt_multi_filter_request_new_pad;
+	gstelement_class->release_pad = gst_dwt_multi_filter_release_pad;
+
+	g_object_class_install_property (gobject_class, PROP_MAX_PENDING,
+			g_param_spec_uint ("max-pending", "Max pending",
+					"Frames and events of a stream not pushed downstream yet before "
+					"its upstream blocks. Set before the streams start",
+					1, 64, 2, G_PARAM_READWRITE));
+
+	gst_element_class_set_details_simple(gstelement_class,
+			"DwtMultiFilter",
+			"Filter/Effect/Video",
+			"DWT filter for several streams sharing one pool of workers. "
+			"Every sink_%u pad has its own wavelet, band, cutoff, inverse "
+			"and subbands.",
+			"Martin Petrov Vachovski <<user@hostname.org>>");
+
+	gst_element_class_add_pad_template (gstelement_class,
+			gst_static_pad_template_get (&src_factory));
+	gst_element_class_add_pad_template (gstelement_class,
+			gst_static_pad_template_get (&sink_factory));
+
+	GST_DEBUG_CATEGORY_INIT (gst_dwt_multi_filter_debug, "dwtmultifilter",
+			0, "DWT filter for several streams");
+}
+
+static void
+gst_dwt_multi_filter_init (GstDwtMultiFilter * multi)
+{
+	multi->sched = NULL;
+	multi->max_pending = 2;
+	multi->next_index = 0;
+}
+
+static void
+gst_dwt_multi_filter_set_property (GObject * object, guint prop_id,
+		const GValue * value, GParamSpec * pspec)
+{
+	GstDwtMultiFilter *multi = GST_DWTMULTIFILTER (object);
+
+	switch (prop_id) {
+	case PROP_MAX_PENDING:
+		multi->max_pending = g_value_get_uint (value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+gst_dwt_multi_filter_get_property (GObject * object, guint prop_id,
+		GValue * value, GParamSpec * pspec)
+{
+	GstDwtMultiFilter *multi = GST_DWTMULTIFILTER (object);
+
+	switch (prop_id) {
+	case PROP_MAX_PENDING:
+		g_value_set_uint (value, multi->max_pending);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static GstStateChangeReturn
+gst_dwt_multi_filter_change_state (GstElement * element, GstStateChange transition)
+{
+	GstDwtMultiFilter *multi = GST_DWTMULTIFILTER (element);
+	GstStateChangeReturn ret;
+
+	switch (transition) {
+	case GST_STATE_CHANGE_NULL_TO_READY:
+		dwt_arena_ref ();
+		start_streams(multi);
+		break;
+	case GST_STATE_CHANGE_READY_TO_PAUSED:
+		set_streams_flushing(multi, FALSE);
+		break;
+	case GST_STATE_CHANGE_PAUSED_TO_READY:
+		set_streams_flushing(multi, TRUE);
+		break;
+	default:
+		break;
+	}
+
+	ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+	switch (transition) {
+	case GST_STATE_CHANGE_NULL_TO_READY:
+		if (ret == GST_STATE_CHANGE_FAILURE)
+		{
+			stop_streams(multi);
+			dwt_arena_unref ();
+		}
+		break;
+	case GST_STATE_CHANGE_READY_TO_NULL:
+		stop_streams(multi);
+		dwt_arena_unref ();
+		break;
+	default:
+		break;
+	}
+
+	return ret;
+}
+
+/* a sink_%u pad and the src_%u pad it feeds */
+static GstPad *
+gst_dwt_multi_filter_request_new_pad (GstElement * element,
+		GstPadTemplate * templ, const gchar * name, const GstCaps * caps)
+{
+	GstDwtMultiFilter *multi = GST_DWTMULTIFILTER (element);
+	GstDwtMultiFilterPad *spad;
+	GstPad *srcpad;
+	gchar *pad_name;
+	guint index;
+
+	GST_OBJECT_LOCK (multi);
+	if(name != NULL && sscanf (name, "sink_%u", &index) == 1)
+	{
+		if(index >= multi->next_index)
+			multi->next_index = index + 1;
+	}
+	else
+		index = multi->next_index++;
+	GST_OBJECT_UNLOCK (multi);
+
+	pad_name = g_strdup_printf ("sink_%u", index);
+	spad = g_object_new (GST_TYPE_DWTMULTIFILTER_PAD, "name", pad_name,
+			"direction", GST_PAD_SINK, "template", templ, NULL);
+	g_free (pad_name);
+	GST_PAD_SET_PROXY_CAPS (spad);
+	gst_pad_set_event_function (GST_PAD (spad),
+			GST_DEBUG_FUNCPTR(gst_dwt_multi_filter_sink_event));
+	gst_pad_set_query_function (GST_PAD (spad),
+			GST_DEBUG_FUNCPTR(gst_dwt_multi_filter_sink_query));
+	gst_pad_set_chain_function (GST_PAD (spad),
+			GST_DEBUG_FUNCPTR(gst_dwt_multi_filter_chain));
+	gst_pad_set_iterate_internal_links_function (GST_PAD (spad),
+			GST_DEBUG_FUNCPTR(gst_dwt_multi_filter_iterate_internal_links));
+
+	pad_name = g_strdup_printf ("src_%u", index);
+	srcpad = gst_pad_new_from_static_template (&src_factory, pad_name);
+	g_free (pad_name);
+	GST_PAD_SET_PROXY_CAPS (srcpad);
+	gst_pad_set_iterate_internal_links_function (srcpad,
+			GST_DEBUG_FUNCPTR(gst_dwt_multi_filter_iterate_internal_links));
+	gst_pad_set_activatemode_function (srcpad,
+			GST_DEBUG_FUNCPTR(gst_dwt_multi_filter_src_activate_mode));
+	gst_pad_set_element_private (srcpad, spad);
+	spad->srcpad = srcpad;
+
+	/* pads requested after NULL join the running streams right away */
+	GST_OBJECT_LOCK (multi);
+	spad->max_pending = multi->max_pending;
+	if(multi->sched != NULL)
+		spad->stream = dwt_stream_new (multi->sched, spad->max_pending,
+				run_item, drop_item, spad);
+	GST_OBJECT_UNLOCK (multi);
+
+	if(!gst_element_add_pad (element, srcpad))
+	{
+		GST_WARNING_OBJECT (multi, "pad src_%u exists already", index);
+		gst_object_unref (srcpad);
+		dwt_stream_free (spad->stream);
+		gst_object_unref (spad);
+		return NULL;
+	}
+	if(!gst_element_add_pad (element, GST_PAD (spad)))
+	{
+		GST_WARNING_OBJECT (multi, "pad sink_%u exists already", index);
+		gst_element_remove_pad (element, srcpad);
+		dwt_stream_free (spad->stream);
+		gst_object_unref (spad);
+		return NULL;
+	}
+
+	return GST_PAD (spad);
+}
+
+static void
+gst_dwt_multi_filter_release_pad (GstElement * element, GstPad * pad)
+{
+	GstDwtMultiFilterPad *spad = GST_DWTMULTIFILTER_PAD (pad);
+	GstPad *srcpad = spad->srcpad;
+
+	gst_object_ref (spad);
+
+	/* The stream goes first, while its worker may still post on the
+	 * element: upstream and the worker are stopped, then the task. */
+	set_output_flushing(spad, TRUE);
+	if(spad->stream != NULL)
+		dwt_stream_set_flushing (spad->stream, TRUE);
+	gst_pad_set_active (pad, FALSE);
+	dwt_stream_free (spad->stream);
+	spad->stream = NULL;
+	gst_pad_set_active (srcpad, FALSE);
+
+	gst_element_remove_pad (element, pad);
+	gst_element_remove_pad (element, srcpad);
+
+	gst_object_unref (spad);
+}
+
+/* Flushes act right away. The other serialized events queue behind the
+ * frames of the stream, so the caps reach the worker and downstream in
+ * order. */
+static gboolean
+gst_dwt_multi_filter_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+	GstDwtMultiFilterPad *spad = GST_DWTMULTIFILTER_PAD (pad);
+	gboolean ret;
+
+	switch (GST_EVENT_TYPE (event)) {
+	case GST_EVENT_FLUSH_START:
+		ret = gst_pad_push_event (spad->srcpad, event);
+		set_output_flushing(spad, TRUE);
+		dwt_stream_set_flushing (spad->stream, TRUE);
+		gst_pad_pause_task (spad->srcpad);
+		break;
+	case GST_EVENT_FLUSH_STOP:
+		dwt_stream_set_flushing (spad->stream, FALSE);
+		set_output_flushing(spad, FALSE);
+		ret = gst_pad_push_event (spad->srcpad, event);
+		gst_pad_start_task (spad->srcpad, output_loop, spad, NULL);
+		break;
+	default:
+		if(!GST_EVENT_IS_SERIALIZED (event))
+		{
+			ret = gst_pad_push_event (spad->srcpad, event);
+			break;
+		}
+
+		g_mutex_lock (&spad->out_lock);
+		if((ret = !spad->out_flushing))
+			spad->pending++;
+		g_mutex_unlock (&spad->out_lock);
+
+		if(!ret || !dwt_stream_push (spad->stream, event))
+		{
+			queue_output(spad, NULL, GST_FLOW_FLUSHING);
+			gst_event_unref (event);
+			ret = FALSE;
+		}
+		break;
+	}
+	return ret;
+}
+
+/* serialized queries, the allocation query among them, wait until the
+ * frames queued before them went out */
+static gboolean
+gst_dwt_multi_filter_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+	GstDwtMultiFilterPad *spad = GST_DWTMULTIFILTER_PAD (pad);
+
+	if(GST_QUERY_IS_SERIALIZED (query))
+		drain_output(spad);
+
+	return gst_pad_query_default (pad, parent, query);
+}
+
+/* Queues the frame for the workers and returns the result of the last
+ * push of the stream, so errors downstream still stop upstream. Upstream
+ * blocks while max-pending frames and events are not pushed yet. */
+static GstFlowReturn
+gst_dwt_multi_filter_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+	GstDwtMultiFilterPad *spad = GST_DWTMULTIFILTER_PAD (pad);
+	GstFlowReturn ret;
+
+	g_mutex_lock (&spad->out_lock);
+	for(;;)
+	{
+		ret = spad->out_flushing ? GST_FLOW_FLUSHING : spad->last_flow;
+		if(ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED)
+			break;
+		if(spad->pending < spad->max_pending)
+		{
+			spad->pending++;
+			break;
+		}
+		g_cond_wait (&spad->out_cond, &spad->out_lock);
+	}
+	g_mutex_unlock (&spad->out_lock);
+
+	if(ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED)
+	{
+		gst_buffer_unref (buf);
+		return ret;
+	}
+
+	if(!dwt_stream_push (spad->stream, buf))
+	{
+		queue_output(spad, NULL, GST_FLOW_FLUSHING);
+		gst_buffer_unref (buf);
+		return GST_FLOW_FLUSHING;
+	}
+
+	return ret;
+}
+
+/* the task pushing the results of the stream runs while the src pad is
+ * active */
+static gboolean
+gst_dwt_multi_filter_src_activate_mode (GstPad * pad, GstObject * parent,
+		GstPadMode mode, gboolean active)
+{
+	GstDwtMultiFilterPad *spad = gst_pad_get_element_private (pad);
+
+	if(mode != GST_PAD_MODE_PUSH)
+		return FALSE;
+
+	if(active)
+	{
+		set_output_flushing(spad, FALSE);
+		return gst_pad_start_task (pad, output_loop, spad, NULL);
+	}
+
+	set_output_flushing(spad, TRUE);
+	return gst_pad_stop_task (pad);
+}
+
+/* the pads of a stream link to each other, for the default handlers */
+static GstIterator *
+gst_dwt_multi_filter_iterate_internal_links (GstPad * pad, GstObject * parent)
+{
+	GstPad *other;
+	GstIterator *it;
+	GValue val = G_VALUE_INIT;
+
+	if(GST_PAD_IS_SINK (pad))
+		other = GST_DWTMULTIFILTER_PAD (pad)->srcpad;
+	else
+		other = gst_pad_get_element_private (pad);
+	if(other == NULL)
+		return NULL;
+
+	g_value_init (&val, GST_TYPE_PAD);
+	g_value_set_object (&val, other);
+	it = gst_iterator_new_single (GST_TYPE_PAD, &val);
+	g_value_unset (&val);
+
+	return it;
+}
+
+/* copies the taps of the named wavelet into the pad settings */
+static gboolean set_wavelet(GstDwtMultiFilterPad *spad, const gchar *name)
+{
+	const DwtWavelet *w = dwt_wavelet_lookup(name);
+
+	if(w == NULL)
+		return FALSE;
+
+	GST_OBJECT_LOCK (spad);
+	spad->kernel = w->kernel;
+	GST_OBJECT_UNLOCK (spad);
+	return TRUE;
+}
+
+/* The streams wait for their workers, which may post messages on the
+ * element, so they are flushed and freed without the object lock. */
+static GList *ref_sink_pads(GstDwtMultiFilter *multi)
+{
+	GList *pads;
+
+	GST_OBJECT_LOCK (multi);
+	pads = g_list_copy_deep (GST_ELEMENT (multi)->sinkpads,
+			(GCopyFunc) gst_object_ref, NULL);
+	GST_OBJECT_UNLOCK (multi);
+
+	return pads;
+}
+
+/* gives every sink pad its stream on the shared workers */
+static void start_streams(GstDwtMultiFilter *multi)
+{
+	DwtScheduler *sched = dwt_scheduler_ref ();
+	GList *l;
+
+	GST_OBJECT_LOCK (multi);
+	multi->sched = sched;
+	for(l = GST_ELEMENT (multi)->sinkpads; l != NULL; l = l->next)
+	{
+		GstDwtMultiFilterPad *spad = l->data;
+
+		spad->max_pending = multi->max_pending;
+		spad->stream = dwt_stream_new (sched, spad->max_pending,
+				run_item, drop_item, spad);
+	}
+	GST_OBJECT_UNLOCK (multi);
+}
+
+static void stop_streams(GstDwtMultiFilter *multi)
+{
+	GList *pads = ref_sink_pads(multi), *l;
+	DwtScheduler *sched;
+
+	for(l = pads; l != NULL; l = l->next)
+	{
+		GstDwtMultiFilterPad *spad = l->data;
+
+		dwt_stream_free (spad->stream);
+		spad->stream = NULL;
+		dwt_plan_free (spad->plan);
+		spad->plan = NULL;
+	}
+	g_list_free_full (pads, gst_object_unref);
+
+	GST_OBJECT_LOCK (multi);
+	sched = multi->sched;
+	multi->sched = NULL;
+	GST_OBJECT_UNLOCK (multi);
+
+	if(sched != NULL)
+		dwt_scheduler_unref (sched);
+}
+
+/* Leaving PAUSED the queued frames are dropped and the streams refuse new
+ * ones until the element starts again. */
+static void set_streams_flushing(GstDwtMultiFilter *multi, gboolean flushing)
+{
+	GList *pads = ref_sink_pads(multi), *l;
+
+	for(l = pads; l != NULL; l = l->next)
+	{
+		GstDwtMultiFilterPad *spad = l->data;
+
+		if(flushing)
+			set_output_flushing(spad, TRUE);
+		dwt_stream_set_flushing (spad->stream, flushing);
+		if(!flushing)
+			set_output_flushing(spad, FALSE);
+	}
+	g_list_free_full (pads, gst_object_unref);
+}
+
+/* runs on a worker: filters a frame or takes the caps of an event, and
+ * hands it to the task of the src pad */
+static void run_item(gpointer item, gpointer user_data)
+{
+	GstDwtMultiFilterPad *spad = user_data;
+	GstFlowReturn ret = GST_FLOW_OK;
+
+	if(GST_IS_BUFFER (item))
+	{
+		GstBuffer *buf = GST_BUFFER (item);
+
+		ret = filter_frame(spad, &buf);
+		item = buf;
+	}
+	else if(GST_EVENT_TYPE (item) == GST_EVENT_CAPS)
+	{
+		GstCaps *caps;
+
+		gst_event_parse_caps (GST_EVENT (item), &caps);
+		set_geometry(spad, caps);
+	}
+
+	queue_output(spad, ret == GST_FLOW_OK ? GST_MINI_OBJECT_CAST (item) : NULL, ret);
+}
+
+static void drop_item(gpointer item)
+{
+	gst_mini_object_unref (GST_MINI_OBJECT_CAST (item));
+}
+
+/* resizes the plan of the stream, which is kept between frames */
+static void set_geometry(GstDwtMultiFilterPad *spad, GstCaps *caps)
+{
+	GstStructure *s = gst_caps_get_structure (caps, 0);
+
+	if(!gst_structure_get_int (s, "width", &spad->width) ||
+			!gst_structure_get_int (s, "height", &spad->height))
+		spad->width = spad->height = 0;
+
+	GST_DEBUG_OBJECT (spad, "%dx%d", spad->width, spad->height);
+
+	if(spad->plan != NULL && spad->plan->width == spad->width &&
+			spad->plan->height == spad->height)
+		return;
+
+	dwt_plan_free (spad->plan);
+	spad->plan = NULL;
+	if(spad->width > 0 && spad->height > 0)
+	{
+		spad->plan = dwt_plan_new (spad->width, spad->height);
+		dwt_plan_set_kernel(spad->plan, &spad->active_kernel);
+	}
+}
+
+/* The transform of dwtfilter without windows, with the settings of the
+ * pad. Takes the frame and gives back the filtered one on success. */
+static GstFlowReturn filter_frame(GstDwtMultiFilterPad *spad, GstBuffer **bufp)
+{
+	GstBuffer *buf = *bufp;
+	GstElement *multi = GST_ELEMENT (GST_OBJECT_PARENT (spad));
+	gsize size = spad->width * spad->height;
+	DwtArenaBlock *block;
+	GstMapInfo info;
+
+	if(spad->plan == NULL)
+	{
+		GST_ELEMENT_ERROR (multi, CORE, NEGOTIATION, (NULL),
+				("%s received a buffer before usable caps", GST_PAD_NAME (spad)));
+		gst_buffer_unref (buf);
+		return GST_FLOW_NOT_NEGOTIATED;
+	}
+
+	block = dwt_arena_acquire(size, MAX(spad->width, spad->height), DWT_ARENA_PAGES_DEFAULT);
+	if(block == NULL)
+	{
+		GST_ELEMENT_ERROR (multi, RESOURCE, NO_SPACE_LEFT, (NULL),
+				("could not allocate the coefficient plane"));
+		gst_buffer_unref (buf);
+		return GST_FLOW_ERROR;
+	}
+
+	buf = gst_buffer_make_writable (buf);
+	gst_buffer_map (buf, &info, GST_MAP_READWRITE);
+	if(info.size < size)
+	{
+		gst_buffer_unmap (buf, &info);
+		dwt_arena_release(block);
+		GST_ELEMENT_ERROR (multi, STREAM, FORMAT, (NULL),
+				("%s: frame of %" G_GSIZE_FORMAT " bytes for %dx%d",
+				GST_PAD_NAME (spad), info.size, spad->width, spad->height));
+		gst_buffer_unref (buf);
+		return GST_FLOW_ERROR;
+	}
+
+	dwt_plane_from_u8(info.data, block->plane, size);
+
+	GST_OBJECT_LOCK (spad);
+	spad->active_kernel = spad->kernel;
+	dwt_plan_set_inverse(spad->plan, spad->inverse);
+	dwt_mask_set_band(spad->plan->mask, spad->band == GST_DWTFILTER_HIGHPASS, spad->cutoff);
+	dwt_mask_set_subbands(spad->plan->mask,
+			(DwtSubbandRule *) spad->subbands->data, spad->subbands->len);
+	GST_OBJECT_UNLOCK (spad);
+
+	dwt_plan_execute(spad->plan, block->plane, block->line);
+	dwt_plane_to_u8(block->plane, info.data, size);
+
+	gst_buffer_unmap (buf, &info);
+	dwt_arena_release(block);
+
+	*bufp = buf;
+	return GST_FLOW_OK;
+}
+
+/* Hands a finished item to the task, or with no item records the result
+ * of one that failed or never reached a worker. Never blocks, the
+ * workers are shared by all streams. */
+static void queue_output(GstDwtMultiFilterPad *spad, GstMiniObject *item, GstFlowReturn ret)
+{
+	g_mutex_lock (&spad->out_lock);
+	if(spad->out_flushing)
+	{
+		g_mutex_unlock (&spad->out_lock);
+		if(item)
+			gst_mini_object_unref (item);
+		return;
+	}
+
+	if(item)
+		g_queue_push_tail (&spad->out_queue, item);
+	else
+	{
+		spad->pending--;
+		if(ret != GST_FLOW_FLUSHING)
+			spad->last_flow = ret;
+	}
+	g_cond_broadcast (&spad->out_cond);
+	g_mutex_unlock (&spad->out_lock);
+}
+
+/* Flushing drops what the workers finished and wakes up upstream and the
+ * task. Leaving it, with the stream and the task stopped, restarts with
+ * nothing pending and a clean flow. */
+static void set_output_flushing(GstDwtMultiFilterPad *spad, gboolean flushing)
+{
+	g_mutex_lock (&spad->out_lock);
+	spad->out_flushing = flushing;
+	if(flushing)
+		g_queue_clear_full (&spad->out_queue, (GDestroyNotify) gst_mini_object_unref);
+	else
+	{
+		spad->pending = 0;
+		spad->last_flow = GST_FLOW_OK;
+	}
+	g_cond_broadcast (&spad->out_cond);
+	g_mutex_unlock (&spad->out_lock);
+}
+
+/* waits until everything handed to the stream went out, or the stream
+ * stopped on a flush or an error */
+static void drain_output(GstDwtMultiFilterPad *spad)
+{
+	g_mutex_lock (&spad->out_lock);
+	while(!spad->out_flushing && spad->pending > 0 &&
+			(spad->last_flow == GST_FLOW_OK || spad->last_flow == GST_FLOW_NOT_LINKED))
+		g_cond_wait (&spad->out_cond, &spad->out_lock);
+	g_mutex_unlock (&spad->out_lock);
+}
+
+/* the task of a src pad: pushes one finished item per iteration and
+ * pauses at EOS, on errors and when flushing */
+static void output_loop(gpointer user_data)
+{
+	GstDwtMultiFilterPad *spad = user_data;
+	GstMiniObject *item;
+	GstFlowReturn ret = GST_FLOW_OK;
+
+	g_mutex_lock (&spad->out_lock);
+	while(g_queue_is_empty (&spad->out_queue) && !spad->out_flushing)
+		g_cond_wait (&spad->out_cond, &spad->out_lock);
+	if(spad->out_flushing)
+	{
+		g_mutex_unlock (&spad->out_lock);
+		gst_pad_pause_task (spad->srcpad);
+		return;
+	}
+	item = g_queue_pop_head (&spad->out_queue);
+	g_mutex_unlock (&spad->out_lock);
+
+	if(GST_IS_BUFFER (item))
+		ret = gst_pad_push (spad->srcpad, GST_BUFFER (item));
+	else
+	{
+		GstEvent *event = GST_EVENT (item);
+		gboolean eos = GST_EVENT_TYPE (event) == GST_EVENT_EOS;
+
+		if(!gst_pad_push_event (spad->srcpad, event))
+			GST_DEBUG_OBJECT (spad, "event not handled downstream");
+		if(eos)
+			ret = GST_FLOW_EOS;
+	}
+
+	g_mutex_lock (&spad->out_lock);
+	if(!spad->out_flushing)
+	{
+		spad->pending--;
+		if(spad->last_flow == GST_FLOW_OK || spad->last_flow == GST_FLOW_NOT_LINKED)
+			spad->last_flow = ret;
+	}
+	g_cond_broadcast (&spad->out_cond);
+	g_mutex_unlock (&spad->out_lock);
+
+	if(ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED)
+	{
+		GST_DEBUG_OBJECT (spad, "output task pausing: %s", gst_flow_get_name (ret));
+		gst_pad_pause_task (spad->srcpad);
+	}
+}
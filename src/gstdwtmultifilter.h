@@ -0,0 +1,138 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_DWTMULTIFILTER_H__
+#define __GST_DWTMULTIFILTER_H__
+
+#include <gst/gst.h>
+
+#include "gstdwtfilter.h"
+#include "dwtsched.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_DWTMULTIFILTER \
+  (gst_dwt_multi_filter_get_type())
+#define GST_DWTMULTIFILTER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_DWTMULTIFILTER,GstDwtMultiFilter))
+#define GST_DWTMULTIFILTER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_DWTMULTIFILTER,GstDwtMultiFilterClass))
+#define GST_IS_DWTMULTIFILTER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_DWTMULTIFILTER))
+#define GST_IS_DWTMULTIFILTER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_DWTMULTIFILTER))
+
+#define GST_TYPE_DWTMULTIFILTER_PAD \
+  (gst_dwt_multi_filter_pad_get_type())
+#define GST_DWTMULTIFILTER_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_DWTMULTIFILTER_PAD,GstDwtMultiFilterPad))
+#define GST_IS_DWTMULTIFILTER_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_DWTMULTIFILTER_PAD))
+
+typedef struct _GstDwtMultiFilter      GstDwtMultiFilter;
+typedef struct _GstDwtMultiFilterClass GstDwtMultiFilterClass;
+typedef struct _GstDwtMultiFilterPad      GstDwtMultiFilterPad;
+typedef struct _GstDwtMultiFilterPadClass GstDwtMultiFilterPadClass;
+
+/* The sink pad of one stream. It carries the settings of the stream and
+ * the state the shared workers use to run it. */
+struct _GstDwtMultiFilterPad
+{
+	GstPad pad;
+
+	GstPad *srcpad;		/* output of the stream */
+
+	/* settings, under the object lock */
+	DwtKernel kernel;
+	gchar *wavelet_name;
+	GstDwtFilterBand band;
+	guint cutoff;
+	gboolean inverse;
+	gchar *subbands_str;
+	GArray *subbands;	/* DwtSubbandRule */
+
+	/* frames and serialized events waiting for a worker, between READY
+	 * and NULL */
+	DwtStream *stream;
+	guint max_pending;
+
+	/* what the workers finished, in stream order, for the task of srcpad;
+	 * the workers never push themselves */
+	GMutex out_lock;
+	GCond out_cond;
+	GQueue out_queue;
+	guint pending;		/* handed to the stream and not pushed yet */
+	gboolean out_flushing;
+	GstFlowReturn last_flow;	/* of the last push, under out_lock */
+
+	/* only touched by the worker running the stream */
+	int width, height;
+	DwtKernel active_kernel;
+	DwtPlan *plan;
+};
+
+struct _GstDwtMultiFilterPadClass
+{
+  GstPadClass parent_class;
+};
+
+struct _GstDwtMultiFilter
+{
+	GstElement element;
+
+	DwtScheduler *sched;	/* between READY and NULL */
+	guint max_pending;
+	guint next_index;
+};
+
+struct _GstDwtMultiFilterClass
+{
+  GstElementClass parent_class;
+};
+
+GType gst_dwt_multi_filter_get_type (void);
+GType gst_dwt_multi_filter_pad_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_DWTMULTIFILTER_H__ */
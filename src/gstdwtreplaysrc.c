@@ -0,0 +1,474 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:element-dwtreplaysrc
+ *
+ * Plays back the coefficients dwtfilter wrote with dump-location, as
+ * GRAY8 frames: every frame is masked with band, cutoff and subbands and
+ * transformed back, so other filter settings can be tried on the same
+ * coefficients without running the forward transform again. The frames
+ * keep the timestamps they had in dwtfilter.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 videotestsrc num-buffers=64 ! video/x-raw,format=GRAY8,width=512,height=512 ! dwtfilter dump-location=/tmp/coefs.dwt ! fakesink
+ * gst-launch-1.0 dwtreplaysrc location=/tmp/coefs.dwt band=high cutoff=32 ! videoconvert ! autovideosink
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <gst/gst.h>
+
+#include "gstdwtreplaysrc.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_dwt_replay_src_debug);
+#define GST_CAT_DEFAULT gst_dwt_replay_src_debug
+
+enum
+{
+	PROP_0,
+	PROP_LOCATION,
+	PROP_BAND,
+	PROP_CUTOFF,
+	PROP_SUBBANDS,
+	PROP_LOOP,
+};
+
+static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
+		GST_PAD_SRC,
+		GST_PAD_ALWAYS,
+		GST_STATIC_CAPS ("video/x-raw,format=GRAY8")
+);
+
+#define gst_dwt_replay_src_parent_class parent_class
+G_DEFINE_TYPE (GstDwtReplaySrc, gst_dwt_replay_src, GST_TYPE_ELEMENT);
+
+static void gst_dwt_replay_src_set_property (GObject * object, guint prop_id,
+		const GValue * value, GParamSpec * pspec);
+static void gst_dwt_replay_src_get_property (GObject * object, guint prop_id,
+		GValue * value, GParamSpec * pspec);
+static void gst_dwt_replay_src_finalize (GObject * object);
+
+static gboolean gst_dwt_replay_src_activate_mode (GstPad * pad, GstObject * parent,
+		GstPadMode mode, gboolean active);
+
+static gboolean open_replay(GstDwtReplaySrc *src);
+static void close_replay(GstDwtReplaySrc *src);
+static gboolean start_stream(GstDwtReplaySrc *src);
+static void replay_loop(gpointer user_data);
+
+static void
+gst_dwt_replay_src_class_init (GstDwtReplaySrcClass * klass)
+{
+	GObjectClass *gobject_class;
+	GstElementClass *gstelement_class;
+
+	gobject_class = (GObjectClass *) klass;
+	gstelement_class = (GstElementClass *) klass;
+
+	gobject_class->set_property = gst_dwt_replay_src_set_property;
+	gobject_class->get_property = gst_dwt_replay_src_get_property;
+	gobject_class->finalize = gst_dwt_replay_src_finalize;
+
+	g_object_class_install_property (gobject_class, PROP_LOCATION,
+			g_param_spec_string ("location", "Location",
+					"Dump file dwtfilter wrote with dump-location, read when the "
+					"element starts",
+					NULL, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_BAND,
+			g_param_spec_enum ("band", "Band",
+					"Determines whether the filter is low-pass or high-pass",
+					GST_TYPE_DWTFILTER_BAND, GST_DWTFILTER_LOWPASS,
+					G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (gobject_class, PROP_CUTOFF,
+			g_param_spec_uint ("cutoff", "Cutoff",
+					"The cutoff of the filter, not bigger than the image size",
+					0, 8096, 1, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_SUBBANDS,
+			g_param_spec_string ("subbands", "Subbands",
+					"Gains of individual subbands on top of band and cutoff, "
+					"with the syntax of the dwtfilter property",
+					NULL, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_LOOP,
+			g_param_spec_boolean ("loop", "Loop",
+					"Start over from the oldest frame at the end of the dump instead "
+					"of sending EOS",
+					FALSE, G_PARAM_READWRITE));
+
+	gst_element_class_set_details_simple(gstelement_class,
+			"DwtReplaySrc",
+			"Source/Video",
+			"Filters the DWT coefficients dwtfilter dumped to a file and "
+			"transforms them back to the image.",
+			"Martin Petrov Vachovski <<user@hostname.org>>");
+
+	gst_element_class_add_pad_template (gstelement_class,
+			gst_static_pad_template_get (&src_factory));
+
+	GST_DEBUG_CATEGORY_INIT (gst_dwt_replay_src_debug, "dwtreplaysrc",
+			0, "DWT coefficient dump replay");
+}
+
+static void
+gst_dwt_replay_src_init (GstDwtReplaySrc * src)
+{
+	src->srcpad = gst_pad_new_from_static_template (&src_factory, "src");
+	gst_pad_use_fixed_caps (src->srcpad);
+	gst_pad_set_activatemode_function (src->srcpad,
+			GST_DEBUG_FUNCPTR(gst_dwt_replay_src_activate_mode));
+	gst_element_add_pad (GST_ELEMENT (src), src->srcpad);
+
+	src->location = NULL;
+	src->band = GST_DWTFILTER_LOWPASS;
+	src->cutoff = 1;
+	src->subbands_str = NULL;
+	src->subbands = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+	src->loop = FALSE;
+
+	src->dump = NULL;
+	src->plan = NULL;
+	src->plane = NULL;
+	src->scratch = NULL;
+}
+
+static void
+gst_dwt_replay_src_set_property (GObject * object, guint prop_id,
+		const GValue * value, GParamSpec * pspec)
+{
+	GstDwtReplaySrc *src = GST_DWTREPLAYSRC (object);
+
+	switch (prop_id) {
+	case PROP_LOCATION:
+		GST_OBJECT_LOCK (src);
+		g_free (src->location);
+		src->location = g_value_dup_string (value);
+		GST_OBJECT_UNLOCK (src);
+		break;
+	case PROP_BAND:
+		GST_OBJECT_LOCK (src);
+		src->band = g_value_get_enum (value);
+		GST_OBJECT_UNLOCK (src);
+		break;
+	case PROP_CUTOFF:
+		GST_OBJECT_LOCK (src);
+		src->cutoff = g_value_get_uint (value);
+		GST_OBJECT_UNLOCK (src);
+		break;
+	case PROP_SUBBANDS:
+	{
+		GArray *rules = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+
+		if(!dwt_subband_rules_parse(g_value_get_string (value), rules))
+		{
+			GST_WARNING_OBJECT (src, "invalid subbands \"%s\"",
+					g_value_get_string (value));
+			g_array_free (rules, TRUE);
+			break;
+		}
+
+		GST_OBJECT_LOCK (src);
+		g_array_free (src->subbands, TRUE);
+		src->subbands = rules;
+		g_free (src->subbands_str);
+		src->subbands_str = g_value_dup_string (value);
+		GST_OBJECT_UNLOCK (src);
+		break;
+	}
+	case PROP_LOOP:
+		GST_OBJECT_LOCK (src);
+		src->loop = g_value_get_boolean (value);
+		GST_OBJECT_UNLOCK (src);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+gst_dwt_replay_src_get_property (GObject * object, guint prop_id,
+		GValue * value, GParamSpec * pspec)
+{
+	GstDwtReplaySrc *src = GST_DWTREPLAYSRC (object);
+
+	GST_OBJECT_LOCK (src);
+	switch (prop_id) {
+	case PROP_LOCATION:
+		g_value_set_string (value, src->location);
+		break;
+	case PROP_BAND:
+		g_value_set_enum (value, src->band);
+		break;
+	case PROP_CUTOFF:
+		g_value_set_uint (value, src->cutoff);
+		break;
+	case PROP_SUBBANDS:
+		g_value_set_string (value, src->subbands_str);
+		break;
+	case PROP_LOOP:
+		g_value_set_boolean (value, src->loop);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+	GST_OBJECT_UNLOCK (src);
+}
+
+static void
+gst_dwt_replay_src_finalize (GObject * object)
+{
+	GstDwtReplaySrc *src = GST_DWTREPLAYSRC (object);
+
+	close_replay(src);
+	g_free (src->location);
+	g_free (src->subbands_str);
+	g_array_free (src->subbands, TRUE);
+
+	G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+/* the dump is mapped and the task replays it while the pad is active */
+static gboolean
+gst_dwt_replay_src_activate_mode (GstPad * pad, GstObject * parent,
+		GstPadMode mode, gboolean active)
+{
+	GstDwtReplaySrc *src = GST_DWTREPLAYSRC (parent);
+	gboolean ret;
+
+	if(mode != GST_PAD_MODE_PUSH)
+		return FALSE;
+
+	if(active)
+		return open_replay(src) && gst_pad_start_task (pad, replay_loop, src, NULL);
+
+	ret = gst_pad_stop_task (pad);
+	close_replay(src);
+
+	return ret;
+}
+
+/* Maps the dump and prepares a plan for its tiles with the wavelet it was
+ * made with. */
+static gboolean open_replay(GstDwtReplaySrc *src)
+{
+	const DwtWavelet *w;
+	DwtDumpHeader *h;
+	gchar *location;
+
+	GST_OBJECT_LOCK (src);
+	location = g_strdup (src->location);
+	GST_OBJECT_UNLOCK (src);
+
+	close_replay(src);
+	if(location == NULL)
+	{
+		GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND, (NULL), ("no location set"));
+		return FALSE;
+	}
+	src->dump = dwt_dump_open (location);
+	if(src->dump == NULL)
+	{
+		GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+				("\"%s\" is not a complete dump file dwtfilter wrote", location));
+		g_free (location);
+		return FALSE;
+	}
+	g_free (location);
+
+	h = src->dump->header;
+	w = dwt_wavelet_lookup (h->wavelet);
+	if(w == NULL)
+	{
+		GST_ELEMENT_ERROR (src, STREAM, FORMAT, (NULL),
+				("dump made with unknown wavelet \"%s\"", h->wavelet));
+		close_replay(src);
+		return FALSE;
+	}
+
+	src->plan = dwt_plan_new (h->width, h->tile_height);
+	dwt_plan_set_kernel(src->plan, &w->kernel);
+	src->plane = g_new (gdouble, (gsize) h->width * h->tile_height);
+	src->scratch = g_new (gdouble, dwt_plan_scratch_size (src->plan));
+	src->frame = 0;
+	src->started = FALSE;
+	src->offset = 0;
+
+	GST_INFO_OBJECT (src, "%ux%u, tiles of %u rows, %s, %u frames", h->width, h->height,
+			h->tile_height, h->wavelet, dwt_dump_n_frames (src->dump));
+
+	return TRUE;
+}
+
+static void close_replay(GstDwtReplaySrc *src)
+{
+	dwt_dump_close (src->dump);
+	src->dump = NULL;
+	dwt_plan_free (src->plan);
+	src->plan = NULL;
+	g_free (src->plane);
+	src->plane = NULL;
+	g_free (src->scratch);
+	src->scratch = NULL;
+}
+
+/* stream-start, the caps of the dump and a time segment */
+static gboolean start_stream(GstDwtReplaySrc *src)
+{
+	DwtDumpHeader *h = src->dump->header;
+	GstSegment segment;
+	GstCaps *caps;
+	gchar *stream_id;
+	gboolean ret;
+
+	stream_id = gst_pad_create_stream_id (src->srcpad, GST_ELEMENT (src), NULL);
+	gst_pad_push_event (src->srcpad, gst_event_new_stream_start (stream_id));
+	g_free (stream_id);
+
+	caps = gst_caps_new_simple ("video/x-raw",
+			"format", G_TYPE_STRING, "GRAY8",
+			"width", G_TYPE_INT, h->width,
+			"height", G_TYPE_INT, h->height,
+			"framerate", GST_TYPE_FRACTION, 0, 1, NULL);
+	ret = gst_pad_set_caps (src->srcpad, caps);
+	gst_caps_unref (caps);
+
+	gst_segment_init (&segment, GST_FORMAT_TIME);
+	gst_pad_push_event (src->srcpad, gst_event_new_segment (&segment));
+
+	return ret;
+}
+
+/* The task of the src pad: masks and transforms back one frame of the
+ * dump per iteration, tile by tile, and pauses at the end of the dump,
+ * on errors and when flushing. */
+static void replay_loop(gpointer user_data)
+{
+	GstDwtReplaySrc *src = user_data;
+	DwtDumpHeader *h = src->dump->header;
+	gsize tile_size = (gsize) h->width * h->tile_height;
+	const gdouble *coefs;
+	GstFlowReturn ret;
+	GstBuffer *buf;
+	GstMapInfo info;
+	guint64 pts;
+	gboolean loop;
+	guint t;
+
+	if(!src->started)
+	{
+		if(!start_stream(src))
+		{
+			GST_ELEMENT_ERROR (src, CORE, NEGOTIATION, (NULL),
+					("downstream refused %ux%u GRAY8", h->width, h->height));
+			gst_pad_push_event (src->srcpad, gst_event_new_eos ());
+			gst_pad_pause_task (src->srcpad);
+			return;
+		}
+		src->started = TRUE;
+	}
+
+	GST_OBJECT_LOCK (src);
+	loop = src->loop;
+	dwt_mask_set_band(src->plan->mask, src->band == GST_DWTFILTER_HIGHPASS, src->cutoff);
+	dwt_mask_set_subbands(src->plan->mask,
+			(DwtSubbandRule *) src->subbands->data, src->subbands->len);
+	GST_OBJECT_UNLOCK (src);
+
+	coefs = dwt_dump_frame (src->dump, src->frame, &pts);
+	if(coefs == NULL && loop && src->frame > 0)
+	{
+		/* go on from one frame spacing after the last timestamp */
+		if(src->first_pts != G_MAXUINT64 && src->last_pts != G_MAXUINT64)
+			src->offset += src->last_pts - src->first_pts +
+					(src->frame > 1 ? (src->last_pts - src->first_pts) / (src->frame - 1) : 0);
+		src->frame = 0;
+		coefs = dwt_dump_frame (src->dump, 0, &pts);
+	}
+	if(coefs == NULL)
+	{
+		GST_DEBUG_OBJECT (src, "end of the dump after %u frames", src->frame);
+		gst_pad_push_event (src->srcpad, gst_event_new_eos ());
+		gst_pad_pause_task (src->srcpad);
+		return;
+	}
+	if(src->frame == 0)
+		src->first_pts = pts;
+	src->last_pts = pts;
+	src->frame++;
+
+	buf = gst_buffer_new_allocate (NULL, (gsize) h->width * h->height, NULL);
+	gst_buffer_map (buf, &info, GST_MAP_WRITE);
+	for(t = 0; t < h->height / h->tile_height; t++)
+	{
+		dwt_plan_synthesize(src->plan, coefs + t * tile_size, src->plane, src->scratch);
+		dwt_plane_to_u8(src->plane, info.data + t * tile_size, tile_size);
+	}
+	gst_buffer_unmap (buf, &info);
+	if(pts != G_MAXUINT64)
+		GST_BUFFER_PTS (buf) = pts + src->offset;
+
+	ret = gst_pad_push (src->srcpad, buf);
+	if(ret != GST_FLOW_OK)
+	{
+		GST_DEBUG_OBJECT (src, "replay task pausing: %s", gst_flow_get_name (ret));
+		if(ret == GST_FLOW_EOS || ret <= GST_FLOW_NOT_NEGOTIATED)
+		{
+			if(ret != GST_FLOW_EOS)
+				GST_ELEMENT_ERROR (src, STREAM, FAILED, (NULL),
+						("streaming stopped, reason %s", gst_flow_get_name (ret)));
+			gst_pad_push_event (src->srcpad, gst_event_new_eos ());
+		}
+		gst_pad_pause_task (src->srcpad);
+	}
+}
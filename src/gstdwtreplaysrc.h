@@ -0,0 +1,102 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_DWTREPLAYSRC_H__
+#define __GST_DWTREPLAYSRC_H__
+
+#include <gst/gst.h>
+
+#include "gstdwtfilter.h"
+#include "dwtdump.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_DWTREPLAYSRC \
+  (gst_dwt_replay_src_get_type())
+#define GST_DWTREPLAYSRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_DWTREPLAYSRC,GstDwtReplaySrc))
+#define GST_DWTREPLAYSRC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_DWTREPLAYSRC,GstDwtReplaySrcClass))
+#define GST_IS_DWTREPLAYSRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_DWTREPLAYSRC))
+#define GST_IS_DWTREPLAYSRC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_DWTREPLAYSRC))
+
+typedef struct _GstDwtReplaySrc      GstDwtReplaySrc;
+typedef struct _GstDwtReplaySrcClass GstDwtReplaySrcClass;
+
+struct _GstDwtReplaySrc
+{
+	GstElement element;
+
+	GstPad *srcpad;
+
+	/* settings, under the object lock */
+	gchar *location;
+	GstDwtFilterBand band;
+	guint cutoff;
+	gchar *subbands_str;
+	GArray *subbands;	/* DwtSubbandRule */
+	gboolean loop;
+
+	/* task of the src pad */
+	DwtDump *dump;		/* mapped while the pad is active */
+	DwtPlan *plan;		/* one tile */
+	gdouble *plane;
+	gdouble *scratch;
+	guint frame;		/* next to push, 0 the oldest of the dump */
+	gboolean started;	/* stream-start, caps and segment sent */
+	guint64 offset;		/* added to the timestamps of every loop */
+	guint64 first_pts, last_pts;
+};
+
+struct _GstDwtReplaySrcClass
+{
+  GstElementClass parent_class;
+};
+
+GType gst_dwt_replay_src_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_DWTREPLAYSRC_H__ */
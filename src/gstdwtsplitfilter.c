@@ -0,0 +1,640 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:element-dwtsplitfilter
+ *
+ * Filters one GRAY8 stream into several outputs sharing one forward
+ * transform. Every requested src_%u pad has its own band, cutoff and
+ * subbands, given as properties of the pad; the frame is transformed
+ * once and each output only costs its mask and the inverse transform,
+ * about half of a dwtfilter behind a tee for two outputs.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 videotestsrc ! video/x-raw,format=GRAY8,width=512,height=512 ! \
+ *     dwtsplitfilter name=s src_0::cutoff=64 src_1::band=high src_1::cutoff=64 \
+ *     s.src_0 ! videoconvert ! autovideosink \
+ *     s.src_1 ! videoconvert ! autovideosink
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <gst/gst.h>
+
+#include <stdio.h>
+
+#include "gstdwtsplitfilter.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_dwt_split_filter_debug);
+#define GST_CAT_DEFAULT gst_dwt_split_filter_debug
+
+enum
+{
+	PROP_0,
+	PROP_WAVELET,
+};
+
+enum
+{
+	PROP_PAD_0,
+	PROP_PAD_BAND,
+	PROP_PAD_CUTOFF,
+	PROP_PAD_SUBBANDS,
+};
+
+static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
+		GST_PAD_SINK,
+		GST_PAD_ALWAYS,
+		GST_STATIC_CAPS ("video/x-raw,format=GRAY8")
+);
+
+static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src_%u",
+		GST_PAD_SRC,
+		GST_PAD_REQUEST,
+		GST_STATIC_CAPS ("video/x-raw,format=GRAY8")
+);
+
+G_DEFINE_TYPE (GstDwtSplitFilterPad, gst_dwt_split_filter_pad, GST_TYPE_PAD);
+
+#define gst_dwt_split_filter_parent_class parent_class
+G_DEFINE_TYPE (GstDwtSplitFilter, gst_dwt_split_filter, GST_TYPE_ELEMENT);
+
+static void gst_dwt_split_filter_pad_set_property (GObject * object, guint prop_id,
+		const GValue * value, GParamSpec * pspec);
+static void gst_dwt_split_filter_pad_get_property (GObject * object, guint prop_id,
+		GValue * value, GParamSpec * pspec);
+static void gst_dwt_split_filter_pad_finalize (GObject * object);
+
+static void gst_dwt_split_filter_set_property (GObject * object, guint prop_id,
+		const GValue * value, GParamSpec * pspec);
+static void gst_dwt_split_filter_get_property (GObject * object, guint prop_id,
+		GValue * value, GParamSpec * pspec);
+static void gst_dwt_split_filter_finalize (GObject * object);
+
+static GstStateChangeReturn gst_dwt_split_filter_change_state (GstElement * element,
+		GstStateChange transition);
+static GstPad *gst_dwt_split_filter_request_new_pad (GstElement * element,
+		GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
+static void gst_dwt_split_filter_release_pad (GstElement * element, GstPad * pad);
+
+static gboolean gst_dwt_split_filter_sink_event (GstPad * pad, GstObject * parent, GstEvent * event);
+static GstFlowReturn gst_dwt_split_filter_chain (GstPad * pad, GstObject * parent, GstBuffer * buf);
+
+static gboolean set_wavelet(GstDwtSplitFilter *split, const gchar *name);
+static gboolean forward_sticky_event(GstPad *pad, GstEvent **event, gpointer user_data);
+static void set_geometry(GstDwtSplitFilter *split, GstCaps *caps);
+static void update_output(GstDwtSplitFilter *split, GstDwtSplitFilterPad *spad);
+static GstFlowReturn combine_flow(GstFlowReturn ret, GstFlowReturn pad_ret);
+
+static void
+gst_dwt_split_filter_pad_class_init (GstDwtSplitFilterPadClass * klass)
+{
+	GObjectClass *gobject_class = (GObjectClass *) klass;
+
+	gobject_class->set_property = gst_dwt_split_filter_pad_set_property;
+	gobject_class->get_property = gst_dwt_split_filter_pad_get_property;
+	gobject_class->finalize = gst_dwt_split_filter_pad_finalize;
+
+	g_object_class_install_property (gobject_class, PROP_PAD_BAND,
+			g_param_spec_enum ("band", "Band",
+					"Determines whether the filter is low-pass or high-pass",
+					GST_TYPE_DWTFILTER_BAND, GST_DWTFILTER_LOWPASS,
+					G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (gobject_class, PROP_PAD_CUTOFF,
+			g_param_spec_uint ("cutoff", "Cutoff",
+					"The cutoff of the filter, not bigger than the image size",
+					0, 8096, 1, G_PARAM_READWRITE));
+
+	g_object_class_install_property (gobject_class, PROP_PAD_SUBBANDS,
+			g_param_spec_string ("subbands", "Subbands",
+					"Gains of individual subbands on top of band and cutoff, "
+					"with the syntax of the dwtfilter property",
+					NULL, G_PARAM_READWRITE));
+}
+
+static void
+gst_dwt_split_filter_pad_init (GstDwtSplitFilterPad * spad)
+{
+	spad->band = GST_DWTFILTER_LOWPASS;
+	spad->cutoff = 1;
+	spad->subbands_str = NULL;
+	spad->subbands = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+	spad->plan = NULL;
+}
+
+static void
+gst_dwt_split_filter_pad_set_property (GObject * object, guint prop_id,
+		const GValue * value, GParamSpec * pspec)
+{
+	GstDwtSplitFilterPad *spad = GST_DWTSPLITFILTER_PAD (object);
+
+	switch (prop_id) {
+	case PROP_PAD_BAND:
+		GST_OBJECT_LOCK (spad);
+		spad->band = g_value_get_enum (value);
+		GST_OBJECT_UNLOCK (spad);
+		break;
+	case PROP_PAD_CUTOFF:
+		GST_OBJECT_LOCK (spad);
+		spad->cutoff = g_value_get_uint (value);
+		GST_OBJECT_UNLOCK (spad);
+		break;
+	case PROP_PAD_SUBBANDS:
+	{
+		GArray *rules = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+
+		if(!dwt_subband_rules_parse(g_value_get_string (value), rules))
+		{
+			GST_WARNING_OBJECT (spad, "invalid subbands \"%s\"",
+					g_value_get_string (value));
+			g_array_free (rules, TRUE);
+			break;
+		}
+
+		GST_OBJECT_LOCK (spad);
+		g_array_free (spad->subbands, TRUE);
+		spad->subbands = rules;
+		g_free (spad->subbands_str);
+		spad->subbands_str = g_value_dup_string (value);
+		GST_OBJECT_UNLOCK (spad);
+		break;
+	}
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+gst_dwt_split_filter_pad_get_property (GObject * object, guint prop_id,
+		GValue * value, GParamSpec * pspec)
+{
+	GstDwtSplitFilterPad *spad = GST_DWTSPLITFILTER_PAD (object);
+
+	GST_OBJECT_LOCK (spad);
+	switch (prop_id) {
+	case PROP_PAD_BAND:
+		g_value_set_enum (value, spad->band);
+		break;
+	case PROP_PAD_CUTOFF:
+		g_value_set_uint (value, spad->cutoff);
+		break;
+	case PROP_PAD_SUBBANDS:
+		g_value_set_string (value, spad->subbands_str);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+	GST_OBJECT_UNLOCK (spad);
+}
+
+static void
+gst_dwt_split_filter_pad_finalize (GObject * object)
+{
+	GstDwtSplitFilterPad *spad = GST_DWTSPLITFILTER_PAD (object);
+
+	g_free (spad->subbands_str);
+	g_array_free (spad->subbands, TRUE);
+	dwt_plan_free (spad->plan);
+
+	G_OBJECT_CLASS (gst_dwt_split_filter_pad_parent_class)->finalize (object);
+}
+
+static void
+gst_dwt_split_filter_class_init (GstDwtSplitFilterClass * klass)
+{
+	GObjectClass *gobject_class;
+	GstElementClass *gstelement_class;
+
+	gobject_class = (GObjectClass *) klass;
+	gstelement_class = (GstElementClass *) klass;
+
+	gobject_class->set_property = gst_dwt_split_filter_set_property;
+	gobject_class->get_property = gst_dwt_split_filter_get_property;
+	gobject_class->finalize = gst_dwt_split_filter_finalize;
+
+	gstelement_class->change_state = gst_dwt_split_filter_change_state;
+	gstelement_class->request_new_pad = gst_dwt_split_filter_request_new_pad;
+	gstelement_class->release_pad = gst_dwt_split_filter_release_pad;
+
+	g_object_class_install_property (gobject_class, PROP_WAVELET,
+			g_param_spec_string("wavelet", "Wavelet",
+					"Family and order of the wavelet, shared by the outputs",
+					"h2", G_PARAM_READWRITE));
+
+	gst_element_class_set_details_simple(gstelement_class,
+			"DwtSplitFilter",
+			"Filter/Effect/Video",
+			"DWT filter with several outputs sharing one forward transform. "
+			"Every src_%u pad has its own band, cutoff and subbands.",
+			"Martin Petrov Vachovski <<user@hostname.org>>");
+
+	gst_element_class_add_pad_template (gstelement_class,
+			gst_static_pad_template_get (&src_factory));
+	gst_element_class_add_pad_template (gstelement_class,
+			gst_static_pad_template_get (&sink_factory));
+
+	GST_DEBUG_CATEGORY_INIT (gst_dwt_split_filter_debug, "dwtsplitfilter",
+			0, "DWT filter with several outputs");
+}
+
+static void
+gst_dwt_split_filter_init (GstDwtSplitFilter * split)
+{
+	split->sinkpad = gst_pad_new_from_static_template (&sink_factory, "sink");
+	GST_PAD_SET_PROXY_CAPS (split->sinkpad);
+	gst_pad_set_event_function (split->sinkpad,
+			GST_DEBUG_FUNCPTR(gst_dwt_split_filter_sink_event));
+	gst_pad_set_chain_function (split->sinkpad,
+			GST_DEBUG_FUNCPTR(gst_dwt_split_filter_chain));
+	gst_element_add_pad (GST_ELEMENT (split), split->sinkpad);
+
+	split->wavelet_name = g_strdup ("h2");
+	split->next_index = 0;
+	split->width = 0;
+	split->height = 0;
+	split->plan = NULL;
+
+	set_wavelet(split, "h2");
+	split->active_kernel = split->kernel;
+}
+
+static void
+gst_dwt_split_filter_set_property (GObject * object, guint prop_id,
+		const GValue * value, GParamSpec * pspec)
+{
+	GstDwtSplitFilter *split = GST_DWTSPLITFILTER (object);
+
+	switch (prop_id) {
+	case PROP_WAVELET:
+		if(!set_wavelet(split, g_value_get_string (value)))
+		{
+			GST_WARNING_OBJECT (split, "unknown wavelet \"%s\"",
+					g_value_get_string (value));
+			break;
+		}
+		GST_OBJECT_LOCK (split);
+		g_free (split->wavelet_name);
+		split->wavelet_name = g_value_dup_string (value);
+		GST_OBJECT_UNLOCK (split);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+gst_dwt_split_filter_get_property (GObject * object, guint prop_id,
+		GValue * value, GParamSpec * pspec)
+{
+	GstDwtSplitFilter *split = GST_DWTSPLITFILTER (object);
+
+	switch (prop_id) {
+	case PROP_WAVELET:
+		GST_OBJECT_LOCK (split);
+		g_value_set_string (value, split->wavelet_name);
+		GST_OBJECT_UNLOCK (split);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+gst_dwt_split_filter_finalize (GObject * object)
+{
+	GstDwtSplitFilter *split = GST_DWTSPLITFILTER (object);
+
+	g_free (split->wavelet_name);
+	dwt_plan_free (split->plan);
+
+	G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static GstStateChangeReturn
+gst_dwt_split_filter_change_state (GstElement * element, GstStateChange transition)
+{
+	GstDwtSplitFilter *split = GST_DWTSPLITFILTER (element);
+	GstStateChangeReturn ret;
+
+	switch (transition) {
+	case GST_STATE_CHANGE_NULL_TO_READY:
+		dwt_arena_ref ();
+		break;
+	default:
+		break;
+	}
+
+	ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+	switch (transition) {
+	case GST_STATE_CHANGE_NULL_TO_READY:
+		if (ret == GST_STATE_CHANGE_FAILURE)
+			dwt_arena_unref ();
+		break;
+	case GST_STATE_CHANGE_READY_TO_NULL:
+		dwt_plan_free (split->plan);
+		split->plan = NULL;
+		split->width = split->height = 0;
+		dwt_arena_unref ();
+		break;
+	default:
+		break;
+	}
+
+	return ret;
+}
+
+/* an output with the settings of a lowpass dwtfilter, replaying the
+ * sticky events so far when requested while streaming */
+static GstPad *
+gst_dwt_split_filter_request_new_pad (GstElement * element,
+		GstPadTemplate * templ, const gchar * name, const GstCaps * caps)
+{
+	GstDwtSplitFilter *split = GST_DWTSPLITFILTER (element);
+	GstPad *pad;
+	gchar *pad_name;
+	guint index;
+
+	GST_OBJECT_LOCK (split);
+	if(name != NULL && sscanf (name, "src_%u", &index) == 1)
+	{
+		if(index >= split->next_index)
+			split->next_index = index + 1;
+	}
+	else
+		index = split->next_index++;
+	GST_OBJECT_UNLOCK (split);
+
+	pad_name = g_strdup_printf ("src_%u", index);
+	pad = g_object_new (GST_TYPE_DWTSPLITFILTER_PAD, "name", pad_name,
+			"direction", GST_PAD_SRC, "template", templ, NULL);
+	g_free (pad_name);
+	GST_PAD_SET_PROXY_CAPS (pad);
+
+	if(!gst_element_add_pad (element, pad))
+	{
+		GST_WARNING_OBJECT (split, "pad src_%u exists already", index);
+		gst_object_unref (pad);
+		return NULL;
+	}
+
+	gst_pad_sticky_events_foreach (split->sinkpad, forward_sticky_event, pad);
+
+	return pad;
+}
+
+static void
+gst_dwt_split_filter_release_pad (GstElement * element, GstPad * pad)
+{
+	gst_pad_set_active (pad, FALSE);
+	gst_element_remove_pad (element, pad);
+}
+
+/* the caps and every other event go to all outputs */
+static gboolean
+gst_dwt_split_filter_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+	GstDwtSplitFilter *split = GST_DWTSPLITFILTER (parent);
+
+	if(GST_EVENT_TYPE (event) == GST_EVENT_CAPS)
+	{
+		GstCaps *caps;
+
+		gst_event_parse_caps (event, &caps);
+		set_geometry(split, caps);
+	}
+
+	return gst_pad_event_default (pad, parent, event);
+}
+
+/* Transforms the frame once, then masks and transforms back the
+ * coefficients for every output. The outputs are all filtered before the
+ * first push, so the planes go back to the arena while downstream runs;
+ * the last output reuses the input buffer. Frames without outputs are
+ * dropped. */
+static GstFlowReturn
+gst_dwt_split_filter_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+	GstDwtSplitFilter *split = GST_DWTSPLITFILTER (parent);
+	gsize size = split->width * split->height;
+	DwtArenaBlock *coefs, *block;
+	GstFlowReturn ret = GST_FLOW_NOT_LINKED;
+	GstMapInfo info;
+	GstBuffer **out;
+	GList *pads, *l;
+	guint n, i;
+
+	if(split->plan == NULL)
+	{
+		GST_ELEMENT_ERROR (split, CORE, NEGOTIATION, (NULL),
+				("received a buffer before usable caps"));
+		gst_buffer_unref (buf);
+		return GST_FLOW_NOT_NEGOTIATED;
+	}
+
+	GST_OBJECT_LOCK (split);
+	pads = g_list_copy_deep (GST_ELEMENT (split)->srcpads, (GCopyFunc) gst_object_ref, NULL);
+	split->active_kernel = split->kernel;
+	GST_OBJECT_UNLOCK (split);
+
+	n = g_list_length (pads);
+	if(n == 0)
+	{
+		gst_buffer_unref (buf);
+		return GST_FLOW_OK;
+	}
+
+	gst_buffer_map (buf, &info, GST_MAP_READ);
+	if(info.size < size)
+	{
+		gst_buffer_unmap (buf, &info);
+		GST_ELEMENT_ERROR (split, STREAM, FORMAT, (NULL),
+				("frame of %" G_GSIZE_FORMAT " bytes for %dx%d",
+				info.size, split->width, split->height));
+		gst_buffer_unref (buf);
+		g_list_free_full (pads, gst_object_unref);
+		return GST_FLOW_ERROR;
+	}
+
+	coefs = dwt_arena_acquire(size, MAX(split->width, split->height), DWT_ARENA_PAGES_DEFAULT);
+	block = coefs ? dwt_arena_acquire(size, MAX(split->width, split->height),
+			DWT_ARENA_PAGES_DEFAULT) : NULL;
+	if(block == NULL)
+	{
+		if(coefs)
+			dwt_arena_release(coefs);
+		gst_buffer_unmap (buf, &info);
+		GST_ELEMENT_ERROR (split, RESOURCE, NO_SPACE_LEFT, (NULL),
+				("could not allocate the coefficient planes"));
+		gst_buffer_unref (buf);
+		g_list_free_full (pads, gst_object_unref);
+		return GST_FLOW_ERROR;
+	}
+
+	dwt_plane_from_u8(info.data, coefs->plane, size);
+	gst_buffer_unmap (buf, &info);
+
+	dwt_plan_forward(split->plan, coefs->plane, coefs->line);
+
+	out = g_new (GstBuffer *, n);
+	for(l = pads, i = 0; l != NULL; l = l->next, i++)
+	{
+		GstDwtSplitFilterPad *spad = l->data;
+
+		update_output(split, spad);
+		dwt_plan_synthesize(spad->plan, coefs->plane, block->plane, block->line);
+
+		if(l->next == NULL)
+			out[i] = gst_buffer_make_writable (buf);
+		else
+		{
+			out[i] = gst_buffer_new_allocate (NULL, size, NULL);
+			gst_buffer_copy_into (out[i], buf, GST_BUFFER_COPY_METADATA, 0, -1);
+		}
+
+		gst_buffer_map (out[i], &info, GST_MAP_WRITE);
+		dwt_plane_to_u8(block->plane, info.data, size);
+		gst_buffer_unmap (out[i], &info);
+	}
+
+	dwt_arena_release(block);
+	dwt_arena_release(coefs);
+
+	for(l = pads, i = 0; l != NULL; l = l->next, i++)
+		ret = combine_flow(ret, gst_pad_push (GST_PAD (l->data), out[i]));
+
+	g_free (out);
+	g_list_free_full (pads, gst_object_unref);
+
+	return ret;
+}
+
+/* copies the taps of the named wavelet into the element */
+static gboolean set_wavelet(GstDwtSplitFilter *split, const gchar *name)
+{
+	const DwtWavelet *w = dwt_wavelet_lookup(name);
+
+	if(w == NULL)
+		return FALSE;
+
+	GST_OBJECT_LOCK (split);
+	split->kernel = w->kernel;
+	GST_OBJECT_UNLOCK (split);
+	return TRUE;
+}
+
+static gboolean forward_sticky_event(GstPad *pad, GstEvent **event, gpointer user_data)
+{
+	gst_pad_push_event (GST_PAD (user_data), gst_event_ref (*event));
+
+	return TRUE;
+}
+
+/* resizes the shared plan, the outputs follow on their next frame */
+static void set_geometry(GstDwtSplitFilter *split, GstCaps *caps)
+{
+	GstStructure *s = gst_caps_get_structure (caps, 0);
+
+	if(!gst_structure_get_int (s, "width", &split->width) ||
+			!gst_structure_get_int (s, "height", &split->height))
+		split->width = split->height = 0;
+
+	GST_DEBUG_OBJECT (split, "%dx%d", split->width, split->height);
+
+	if(split->plan != NULL && split->plan->width == split->width &&
+			split->plan->height == split->height)
+		return;
+
+	dwt_plan_free (split->plan);
+	split->plan = NULL;
+	if(split->width > 0 && split->height > 0)
+	{
+		split->plan = dwt_plan_new (split->width, split->height);
+		dwt_plan_set_kernel(split->plan, &split->active_kernel);
+	}
+}
+
+/* sizes the plan of an output like the shared one and compiles its mask
+ * when the settings of the pad changed */
+static void update_output(GstDwtSplitFilter *split, GstDwtSplitFilterPad *spad)
+{
+	if(spad->plan == NULL || spad->plan->width != split->width ||
+			spad->plan->height != split->height)
+	{
+		dwt_plan_free (spad->plan);
+		spad->plan = dwt_plan_new (split->width, split->height);
+		dwt_plan_set_kernel(spad->plan, &split->active_kernel);
+	}
+
+	GST_OBJECT_LOCK (spad);
+	dwt_mask_set_band(spad->plan->mask, spad->band == GST_DWTFILTER_HIGHPASS, spad->cutoff);
+	dwt_mask_set_subbands(spad->plan->mask,
+			(DwtSubbandRule *) spad->subbands->data, spad->subbands->len);
+	GST_OBJECT_UNLOCK (spad);
+}
+
+/* An output that is not linked or finished does not stop the others,
+ * flushing and errors do. NOT_LINKED when no output is linked, EOS when
+ * all linked ones are finished. */
+static GstFlowReturn combine_flow(GstFlowReturn ret, GstFlowReturn pad_ret)
+{
+	if(ret == GST_FLOW_NOT_LINKED)
+		return pad_ret;
+	if(ret == GST_FLOW_EOS)
+		return pad_ret == GST_FLOW_NOT_LINKED ? ret : pad_ret;
+	if(ret == GST_FLOW_OK && pad_ret != GST_FLOW_NOT_LINKED && pad_ret != GST_FLOW_EOS)
+		return pad_ret;
+
+	return ret;
+}
@@ -0,0 +1,206 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Times the column pass of the forward transform over a plane from the
+ * arena with every hugepages mode, and counts its dTLB load misses
+ * through perf_event_open where the kernel lets us. The columns stride
+ * a whole row per sample, so every one of them walks all the pages of
+ * the plane. Built by "make bench", not run by make check. */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef HAVE_LINUX_PERF_EVENT_H
+#  include <linux/perf_event.h>
+#  include <sys/syscall.h>
+#endif
+
+#include "dwtarena.h"
+#include "dwtfilter.h"
+
+static gint width = 4096, height = 4096, passes = 4;
+static gchar *wavelet = "d4";
+
+static GOptionEntry entries[] = {
+	{ "width", 0, 0, G_OPTION_ARG_INT, &width, "width of the plane", "N" },
+	{ "height", 0, 0, G_OPTION_ARG_INT, &height, "height of the plane", "N" },
+	{ "passes", 0, 0, G_OPTION_ARG_INT, &passes, "column passes per mode", "N" },
+	{ "wavelet", 0, 0, G_OPTION_ARG_STRING, &wavelet, "wavelet name", "NAME" },
+	{ NULL }
+};
+
+static const gchar *const page_names[] = { "default", "transparent", "explicit" };
+
+static gint open_tlb_counter (void);
+static gboolean read_counter (gint fd, guint64 *value);
+static gdouble now (void);
+
+int
+main (int argc, char **argv)
+{
+	GOptionContext *context = g_option_context_new ("- column pass per hugepages mode");
+	GError *error = NULL;
+	const DwtWavelet *w;
+	guint pages;
+
+	g_option_context_add_main_entries (context, entries, NULL);
+	if (!g_option_context_parse (context, &argc, &argv, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		return 1;
+	}
+	g_option_context_free (context);
+
+	w = dwt_wavelet_lookup (wavelet);
+	if (w == NULL || width < 2 || height < 2 || passes < 1)
+	{
+		g_printerr ("bad wavelet or sizes\n");
+		return 1;
+	}
+
+	g_print ("%dx%d, %s, %d passes\n", width, height, wavelet, passes);
+	g_print ("%-12s %-12s %12s %16s\n", "hugepages", "backing", "ms/pass", "dTLB misses/pass");
+
+	for (pages = DWT_ARENA_PAGES_DEFAULT; pages <= DWT_ARENA_PAGES_EXPLICIT; pages++)
+	{
+		DwtArenaBlock *block = dwt_arena_acquire ((gsize) width * height,
+			MAX (width, height), pages);
+		guint64 misses = 0;
+		gboolean counted;
+		gdouble start, elapsed;
+		gsize i;
+		gint fd, p;
+
+		if (block == NULL)
+		{
+			g_print ("%-12s out of memory\n", page_names[pages]);
+			continue;
+		}
+
+		/* the first touch faults the pages in, outside the measurement */
+		for (i = 0; i < (gsize) width * height; i++)
+			block->plane[i] = i % 251;
+
+		fd = open_tlb_counter ();
+		start = now ();
+		for (p = 0; p < passes; p++)
+		{
+			for (i = 0; i < (gsize) width; i++)
+				dwt_kernel_forward (&w->kernel, block->plane + i, width, height, block->line);
+		}
+		elapsed = now () - start;
+		counted = read_counter (fd, &misses);
+
+		if (counted)
+			g_print ("%-12s %-12s %12.2f %16" G_GUINT64_FORMAT "\n", page_names[pages],
+				page_names[block->pages], 1000 * elapsed / passes, misses / passes);
+		else
+			g_print ("%-12s %-12s %12.2f %16s\n", page_names[pages],
+				page_names[block->pages], 1000 * elapsed / passes, "n/a");
+
+		dwt_arena_release (block);
+	}
+
+	return 0;
+}
+
+#ifdef HAVE_LINUX_PERF_EVENT_H
+
+/* dTLB load misses of this thread in user space, -1 when perf events
+ * are not available or not allowed */
+static gint
+open_tlb_counter (void)
+{
+	struct perf_event_attr attr;
+
+	memset (&attr, 0, sizeof (attr));
+	attr.size = sizeof (attr);
+	attr.type = PERF_TYPE_HW_CACHE;
+	attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+		(PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return syscall (SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static gboolean
+read_counter (gint fd, guint64 *value)
+{
+	gboolean ok;
+
+	if (fd < 0)
+		return FALSE;
+	ok = read (fd, value, sizeof (*value)) == sizeof (*value);
+	close (fd);
+	return ok;
+}
+
+#else /* HAVE_LINUX_PERF_EVENT_H */
+
+static gint
+open_tlb_counter (void)
+{
+	return -1;
+}
+
+static gboolean
+read_counter (gint fd, guint64 *value)
+{
+	return FALSE;
+}
+
+#endif /* HAVE_LINUX_PERF_EVENT_H */
+
+static gdouble
+now (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
@@ -0,0 +1,241 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <math.h>
+
+#include <gsl/gsl_wavelet2d.h>
+
+#include "check.h"
+
+const gchar *const check_wavelet_names[] = {
+	"h2", "hc2",
+	"d4", "dc4", "d6", "d8", "dc8", "d12", "d20", "dc20",
+	"b103", "bc103", "b202", "b206", "bc208", "b301", "b309", "bc309"
+};
+const guint check_n_wavelet_names = G_N_ELEMENTS (check_wavelet_names);
+
+static guint side_level (guint s);
+static gboolean in_windows (const DwtMask *mask, guint s, guint bx, guint by);
+
+const DwtWavelet *
+check_random_wavelet (void)
+{
+	const gchar *name = check_wavelet_names[g_test_rand_int_range (0, check_n_wavelet_names)];
+	const DwtWavelet *w = dwt_wavelet_lookup (name);
+
+	g_assert_nonnull (w);
+	return w;
+}
+
+/* a power of two in [2^min_log, 2^max_log] */
+guint
+check_random_side (guint min_log, guint max_log)
+{
+	return 1u << g_test_rand_int_range (min_log, max_log + 1);
+}
+
+void
+check_random_plane (gdouble *plane, gsize n)
+{
+	gsize i;
+
+	for (i = 0; i < n; i++)
+		plane[i] = g_test_rand_double_range (0., 256.);
+}
+
+/* anywhere on the frame, now and then reaching past its edges or empty */
+void
+check_random_window (guint width, guint height, DwtWindow *win)
+{
+	win->x = g_test_rand_int_range (0, width + 8);
+	win->y = g_test_rand_int_range (0, height + 8);
+	win->w = g_test_rand_int_range (0, width + 1);
+	win->h = g_test_rand_int_range (0, height + 1);
+}
+
+/* The gain of coefficient (x, y) worked out from the settings the mask
+ * holds, one coefficient at a time, as the documentation of DwtMask
+ * states it: the band selection, the subband rules, and the windows
+ * keeping every detail coefficient whose support touches them. */
+gdouble
+check_gain (const DwtMask *mask, guint x, guint y)
+{
+	const guint levels = side_level (MIN (mask->width, mask->height));
+	guint sx = x ? 1u << side_level (x) : 0, sy = y ? 1u << side_level (y) : 0;
+	guint s = MAX (sx, sy), orientation, i;
+	gboolean inside;
+	gdouble gain = 1.;
+
+	if (s == 0)
+		orientation = DWT_SUBBAND_LL;
+	else if (sx > sy)
+		orientation = DWT_SUBBAND_HL;
+	else if (sy > sx)
+		orientation = DWT_SUBBAND_LH;
+	else
+		orientation = DWT_SUBBAND_HH;
+
+	if (orientation != DWT_SUBBAND_LL && 2 * s <= mask->width && 2 * s <= mask->height &&
+		in_windows (mask, s, orientation == DWT_SUBBAND_LH ? x : x - s,
+			orientation == DWT_SUBBAND_HL ? y : y - s))
+		return 1.;
+
+	for (i = 0; i < mask->rules->len; i++)
+	{
+		const DwtSubbandRule *rule = &g_array_index (mask->rules, DwtSubbandRule, i);
+		guint level = s ? levels - side_level (s) : 0;
+
+		if (!(rule->orientations & orientation))
+			continue;
+		if (orientation == DWT_SUBBAND_LL ||
+			(s < 1u << levels && level >= rule->first_level && level <= rule->last_level))
+			gain = rule->gain;
+	}
+
+	inside = x < MIN (mask->cutoff, MAX (mask->width, mask->height)) &&
+		y < MIN (mask->cutoff, MAX (mask->width, mask->height));
+
+	return inside != mask->highpass ? gain : 0.;
+}
+
+/* What the plan should leave for data: the transform of GSL itself,
+ * every coefficient times check_gain() and, with inverse, GSL's inverse.
+ * gsl_wavelet2d only takes square planes, the others go through the
+ * one dimensional transform of every column and row. */
+void
+check_reference (const gsl_wavelet *w, const DwtMask *mask, gboolean inverse,
+	gdouble *data)
+{
+	const guint width = mask->width, height = mask->height;
+	gsl_wavelet_workspace *ws = gsl_wavelet_workspace_alloc (MAX (width, height));
+	guint x, y;
+
+	if (width == height)
+		g_assert_cmpint (gsl_wavelet2d_transform_forward (w, data, width, height, width, ws), ==, 0);
+	else
+	{
+		for (x = 0; x < width; x++)
+			gsl_wavelet_transform_forward (w, data + x, width, height, ws);
+		for (y = 0; y < height; y++)
+			gsl_wavelet_transform_forward (w, data + (gsize) y * width, 1, width, ws);
+	}
+
+	for (y = 0; y < height; y++)
+		for (x = 0; x < width; x++)
+			data[(gsize) y * width + x] *= check_gain (mask, x, y);
+
+	if (inverse && width == height)
+		g_assert_cmpint (gsl_wavelet2d_transform_inverse (w, data, width, height, width, ws), ==, 0);
+	else if (inverse)
+	{
+		for (y = 0; y < height; y++)
+			gsl_wavelet_transform_inverse (w, data + (gsize) y * width, 1, width, ws);
+		for (x = 0; x < width; x++)
+			gsl_wavelet_transform_inverse (w, data + x, width, height, ws);
+	}
+
+	gsl_wavelet_workspace_free (ws);
+}
+
+gdouble
+check_max_diff (const gdouble *a, const gdouble *b, gsize n)
+{
+	gdouble diff = 0;
+	gsize i;
+
+	for (i = 0; i < n; i++)
+		diff = MAX (diff, fabs (a[i] - b[i]));
+
+	return diff;
+}
+
+gdouble
+check_max_abs (const gdouble *a, gsize n)
+{
+	gdouble max = 0;
+	gsize i;
+
+	for (i = 0; i < n; i++)
+		max = MAX (max, fabs (a[i]));
+
+	return max;
+}
+
+/* log2 of the largest power of two not above s */
+static guint
+side_level (guint s)
+{
+	guint level = 0;
+
+	while (s >> (level + 1))
+		level++;
+
+	return level;
+}
+
+/* whether a window touches the support of the coefficient at (bx, by) of
+ * a detail block of scale s, in exact integer arithmetic: the support
+ * covers [bx * width / s, (bx + 1) * width / s) of the columns */
+static gboolean
+in_windows (const DwtMask *mask, guint s, guint bx, guint by)
+{
+	guint i;
+
+	for (i = 0; i < mask->windows->len; i++)
+	{
+		const DwtWindow *win = &g_array_index (mask->windows, DwtWindow, i);
+
+		if ((guint64) bx * mask->width < ((guint64) win->x + win->w) * s &&
+			(guint64) (bx + 1) * mask->width > (guint64) win->x * s &&
+			(guint64) by * mask->height < ((guint64) win->y + win->h) * s &&
+			(guint64) (by + 1) * mask->height > (guint64) win->y * s &&
+			win->w > 0 && win->h > 0)
+			return TRUE;
+	}
+
+	return FALSE;
+}
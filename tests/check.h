@@ -0,0 +1,74 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __CHECK_H__
+#define __CHECK_H__
+
+#include <glib.h>
+
+#include "dwtfilter.h"
+
+G_BEGIN_DECLS
+
+/* Helpers shared by the tests of libdwtfilter. The random values come
+ * from the GLib test generator, so a failing run repeats with the seed
+ * it prints (--seed). */
+
+/* wavelets of every family GSL provides, centered or not */
+extern const gchar *const check_wavelet_names[];
+extern const guint check_n_wavelet_names;
+
+const DwtWavelet *check_random_wavelet (void);
+guint check_random_side (guint min_log, guint max_log);
+void check_random_plane (gdouble *plane, gsize n);
+void check_random_window (guint width, guint height, DwtWindow *win);
+
+gdouble check_gain (const DwtMask *mask, guint x, guint y);
+void check_reference (const gsl_wavelet *w, const DwtMask *mask, gboolean inverse,
+	gdouble *data);
+gdouble check_max_diff (const gdouble *a, const gdouble *b, gsize n);
+gdouble check_max_abs (const gdouble *a, gsize n);
+
+G_END_DECLS
+
+#endif /* __CHECK_H__ */
@@ -0,0 +1,186 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* the bitplane coder: header and coefficients through encode and decode,
+ * and decoding of damaged records */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "check.h"
+#include "dwtcodec.h"
+
+#define ROUNDS 200
+
+/* dense, empty or sparse with a few large coefficients */
+static void
+random_coefs (gdouble *coefs, gsize n)
+{
+	guint kind = g_test_rand_int_range (0, 3);
+	gsize i;
+
+	for (i = 0; i < n; i++)
+	{
+		if (kind == 0)
+			coefs[i] = g_test_rand_double_range (-300., 300.);
+		else if (kind == 1)
+			coefs[i] = 0.;
+		else if (g_test_rand_int_range (0, 50) == 0)
+			coefs[i] = g_test_rand_double_range (-50000., 50000.);
+		else
+			coefs[i] = 0.3;
+	}
+}
+
+/* the dead zone quantizer of the codec, reconstructed at the middle of
+ * the interval */
+static gdouble
+quantized (gdouble c, gdouble step)
+{
+	gdouble q = floor (fabs (c) / step);
+
+	return q > 0 ? copysign ((q + 0.5) * step, c) : 0.;
+}
+
+static void
+test_round_trip (void)
+{
+	guint round;
+
+	for (round = 0; round < ROUNDS; round++)
+	{
+		guint width = check_random_side (0, 7), height = check_random_side (0, 7);
+		guint n_tiles = g_test_rand_int_range (1, 4), t, w, th, nt;
+		const gsize n = (gsize) width * height;
+		gdouble step = g_test_rand_int_range (1, 9) * 0.5, st;
+		gdouble *coefs = g_new (gdouble, n * n_tiles);
+		gdouble *decoded = g_new (gdouble, n);
+		DwtCodec *encoder = dwt_codec_new (width, height);
+		DwtCodec *decoder = dwt_codec_new (width, height);
+		GByteArray *out = g_byte_array_new ();
+		gsize pos = DWT_CODEC_HEADER_SIZE, i;
+
+		random_coefs (coefs, n * n_tiles);
+		dwt_codec_write_header (out, width, height, n_tiles, step);
+		for (t = 0; t < n_tiles; t++)
+			dwt_codec_encode (encoder, coefs + t * n, step, out);
+
+		g_assert_true (dwt_codec_read_header (out->data, out->len, &w, &th, &nt, &st));
+		g_assert_cmpuint (w, ==, width);
+		g_assert_cmpuint (th, ==, height);
+		g_assert_cmpuint (nt, ==, n_tiles);
+		g_assert_cmpfloat (st, ==, step);
+
+		for (t = 0; t < n_tiles; t++)
+		{
+			gsize used = dwt_codec_decode (decoder, out->data + pos, out->len - pos, st, decoded);
+
+			g_assert_cmpuint (used, >, 0);
+			pos += used;
+			for (i = 0; i < n; i++)
+				g_assert_cmpfloat (decoded[i], ==, quantized (coefs[t * n + i], step));
+		}
+		g_assert_cmpuint (pos, ==, out->len);
+
+		g_byte_array_free (out, TRUE);
+		dwt_codec_free (encoder);
+		dwt_codec_free (decoder);
+		g_free (coefs);
+		g_free (decoded);
+	}
+}
+
+/* truncated and corrupted records fail or decode something, they never
+ * read past the data */
+static void
+test_damaged (void)
+{
+	guint round;
+
+	for (round = 0; round < ROUNDS; round++)
+	{
+		guint width = check_random_side (0, 6), height = check_random_side (0, 6);
+		const gsize n = (gsize) width * height;
+		gdouble *coefs = g_new (gdouble, n);
+		DwtCodec *codec = dwt_codec_new (width, height);
+		GByteArray *out = g_byte_array_new ();
+		guint w, th, nt;
+		gdouble step;
+		guint8 *copy;
+		gsize len, i;
+
+		random_coefs (coefs, n);
+		dwt_codec_encode (codec, coefs, 1., out);
+
+		/* an exact copy, so a sanitizer sees any read past len */
+		len = g_test_rand_int_range (0, out->len + 1);
+		copy = g_malloc (MAX (len, 1));
+		memcpy (copy, out->data, len);
+		for (i = 0; len > 0 && i < 4; i++)
+			copy[g_test_rand_int_range (0, len)] ^= 1 << g_test_rand_int_range (0, 8);
+
+		g_assert_cmpuint (dwt_codec_decode (codec, copy, len, 1., coefs), <=, len);
+		g_assert_false (dwt_codec_read_header (copy, MIN (len, DWT_CODEC_HEADER_SIZE - 1),
+					&w, &th, &nt, &step));
+
+		g_free (copy);
+		g_byte_array_free (out, TRUE);
+		dwt_codec_free (codec);
+		g_free (coefs);
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/codec/round-trip", test_round_trip);
+	g_test_add_func ("/codec/damaged", test_damaged);
+
+	return g_test_run ();
+}
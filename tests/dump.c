@@ -0,0 +1,269 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* the coefficient dump: frames through the ring and back, headers
+ * claiming more than the file holds, and replays of what dwtfilter
+ * dumped */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <unistd.h>
+#include <glib/gstdio.h>
+
+#include "check.h"
+#include "dwtdump.h"
+
+#define WIDTH  8
+#define HEIGHT 4
+#define SLOTS  3
+
+static gchar *
+tmp_path (void)
+{
+	GError *error = NULL;
+	gchar *path;
+	gint fd = g_file_open_tmp ("dwtdump-XXXXXX", &path, &error);
+
+	g_assert_no_error (error);
+	close (fd);
+	return path;
+}
+
+/* a dump of SLOTS slots after five frames, frame f all f and pts f */
+static gchar *
+write_dump (void)
+{
+	gchar *path = tmp_path ();
+	DwtDump *dump = dwt_dump_create (path, WIDTH, HEIGHT, HEIGHT / 2, "d4", SLOTS);
+	guint f, i;
+
+	g_assert_nonnull (dump);
+	for (f = 0; f < 5; f++)
+	{
+		gdouble *coefs = dwt_dump_begin (dump);
+
+		for (i = 0; i < WIDTH * HEIGHT; i++)
+			coefs[i] = f;
+		dwt_dump_commit (dump, f);
+	}
+	dwt_dump_close (dump);
+
+	return path;
+}
+
+static void
+test_round_trip (void)
+{
+	gchar *path = write_dump ();
+	DwtDump *dump = dwt_dump_open (path);
+	guint64 pts;
+	guint f, i;
+
+	g_assert_nonnull (dump);
+	g_assert_cmpuint (dump->header->width, ==, WIDTH);
+	g_assert_cmpuint (dump->header->height, ==, HEIGHT);
+	g_assert_cmpstr (dump->header->wavelet, ==, "d4");
+	g_assert_cmpuint (dwt_dump_n_frames (dump), ==, SLOTS);
+
+	for (f = 0; f < SLOTS; f++)
+	{
+		const gdouble *coefs = dwt_dump_frame (dump, f, &pts);
+
+		g_assert_cmpuint (pts, ==, f + 2);
+		for (i = 0; i < WIDTH * HEIGHT; i++)
+			g_assert_cmpfloat (coefs[i], ==, f + 2);
+	}
+	g_assert_null (dwt_dump_frame (dump, SLOTS, NULL));
+
+	dwt_dump_close (dump);
+	g_unlink (path);
+	g_free (path);
+}
+
+/* the dump of write_dump() with its header changed, or cut short */
+static void
+assert_rejected (guint32 width, guint32 height, guint32 slots, gsize cut)
+{
+	gchar *path = write_dump ();
+	GError *error = NULL;
+	DwtDumpHeader *h;
+	gchar *data;
+	gsize size;
+
+	g_assert_true (g_file_get_contents (path, &data, &size, &error));
+	h = (DwtDumpHeader *) data;
+	h->width = width;
+	h->height = height;
+	h->tile_height = height;
+	h->slots = slots;
+	g_assert_true (g_file_set_contents (path, data, size - cut, &error));
+
+	g_assert_null (dwt_dump_open (path));
+
+	g_unlink (path);
+	g_free (data);
+	g_free (path);
+}
+
+static void
+test_damaged (void)
+{
+	/* the plane in bytes and the slots product wrapping around */
+	assert_rejected (G_MAXUINT32, G_MAXUINT32, SLOTS, 0);
+	assert_rejected (1u << 31, 4, SLOTS, 0);
+	assert_rejected (WIDTH, HEIGHT, G_MAXUINT32, 0);
+	/* more than the file holds */
+	assert_rejected (WIDTH, HEIGHT, SLOTS + 1, 0);
+	assert_rejected (WIDTH * 2, HEIGHT, SLOTS, 0);
+	assert_rejected (WIDTH, HEIGHT, SLOTS, 1);
+}
+
+/* sets the band and subbands both sides use */
+static void
+set_mask (DwtPlan *plan, gboolean highpass, guint cutoff)
+{
+	static const DwtSubbandRule rules[] = {
+		{ 1, 1, DWT_SUBBAND_HH, 0. },
+		{ 2, 3, DWT_SUBBAND_LH, 0.5 },
+	};
+
+	dwt_mask_set_band (plan->mask, highpass, cutoff);
+	dwt_mask_set_subbands (plan->mask, rules, G_N_ELEMENTS (rules));
+}
+
+/* Tiles filtered the way dwtfilter does with a dump open (forward, dump,
+ * synthesize) and without one (execute), against dwtreplaysrc
+ * synthesizing the dump with the same settings: the same bytes. */
+static void
+test_replay (void)
+{
+	guint round;
+
+	for (round = 0; round < 20; round++)
+	{
+		const gchar *name = check_wavelet_names[g_test_rand_int_range (0, check_n_wavelet_names)];
+		const DwtWavelet *w = dwt_wavelet_lookup (name);
+		guint width = check_random_side (3, 7), tile_height = check_random_side (3, 6);
+		guint n_tiles = g_test_rand_int_range (1, 4), t;
+		const gsize tile_size = (gsize) width * tile_height;
+		gboolean highpass = g_test_rand_bit ();
+		guint cutoff = g_test_rand_int_range (0, MAX (width, tile_height) + 1);
+		gchar *path = tmp_path ();
+		DwtDump *dump = dwt_dump_create (path, width, tile_height * n_tiles, tile_height,
+			name, 2);
+		DwtPlan *plan = dwt_plan_new (width, tile_height);
+		gdouble *scratch = g_new (gdouble, dwt_plan_scratch_size (plan));
+		gdouble *plane = g_new (gdouble, tile_size);
+		guint8 *pixels = g_new (guint8, tile_size * n_tiles);
+		guint8 *filtered = g_new (guint8, tile_size * n_tiles);
+		guint8 *executed = g_new (guint8, tile_size * n_tiles);
+		guint8 *replayed = g_new (guint8, tile_size * n_tiles);
+		gdouble *dump_frame;
+		gsize i;
+
+		g_assert_nonnull (dump);
+
+		for (i = 0; i < tile_size * n_tiles; i++)
+			pixels[i] = g_test_rand_int_range (0, 256);
+
+		dwt_plan_set_kernel (plan, &w->kernel);
+		set_mask (plan, highpass, cutoff);
+		dump_frame = dwt_dump_begin (dump);
+		for (t = 0; t < n_tiles; t++)
+		{
+			dwt_plane_from_u8 (pixels + t * tile_size, plane, tile_size);
+			dwt_plan_forward (plan, plane, scratch);
+			memcpy (dump_frame + t * tile_size, plane, tile_size * sizeof (gdouble));
+			dwt_plan_synthesize (plan, plane, plane, scratch);
+			dwt_plane_to_u8 (plane, filtered + t * tile_size, tile_size);
+
+			dwt_plane_from_u8 (pixels + t * tile_size, plane, tile_size);
+			dwt_plan_execute (plan, plane, scratch);
+			dwt_plane_to_u8 (plane, executed + t * tile_size, tile_size);
+		}
+		dwt_dump_commit (dump, 0);
+		dwt_dump_close (dump);
+		dwt_plan_free (plan);
+
+		/* dwtreplaysrc */
+		dump = dwt_dump_open (path);
+		g_assert_nonnull (dump);
+		plan = dwt_plan_new (dump->header->width, dump->header->tile_height);
+		dwt_plan_set_kernel (plan, &dwt_wavelet_lookup (dump->header->wavelet)->kernel);
+		set_mask (plan, highpass, cutoff);
+		for (t = 0; t < n_tiles; t++)
+		{
+			dwt_plan_synthesize (plan, dwt_dump_frame (dump, 0, NULL) + t * tile_size,
+				plane, scratch);
+			dwt_plane_to_u8 (plane, replayed + t * tile_size, tile_size);
+		}
+
+		g_assert_cmpmem (replayed, tile_size * n_tiles, filtered, tile_size * n_tiles);
+		g_assert_cmpmem (replayed, tile_size * n_tiles, executed, tile_size * n_tiles);
+
+		dwt_dump_close (dump);
+		dwt_plan_free (plan);
+		g_unlink (path);
+		g_free (path);
+		g_free (scratch);
+		g_free (plane);
+		g_free (pixels);
+		g_free (filtered);
+		g_free (executed);
+		g_free (replayed);
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/dump/round-trip", test_round_trip);
+	g_test_add_func ("/dump/damaged", test_damaged);
+	g_test_add_func ("/dump/replay", test_replay);
+
+	return g_test_run ();
+}
@@ -0,0 +1,104 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Runs a fuzz target without libFuzzer: on every file named on the
+ * command line, or on stdin without any, which is what AFL drives
+ * ("afl-fuzz -i corpus/codec -o out -- ./fuzz_codec @@") and what
+ * make check replays the corpus with. */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+int LLVMFuzzerTestOneInput (const guint8 *data, gsize size);
+
+static void
+run (const guint8 *data, gsize size)
+{
+	/* an exact copy, so a sanitizer sees any read past the end */
+	guint8 *copy = g_malloc (MAX (size, 1));
+
+	memcpy (copy, data, size);
+	LLVMFuzzerTestOneInput (copy, size);
+	g_free (copy);
+}
+
+int
+main (int argc, char **argv)
+{
+	GError *error = NULL;
+	gchar *data;
+	gsize size;
+	int i;
+
+	if (argc < 2)
+	{
+		GString *in = g_string_new (NULL);
+		gchar buf[4096];
+
+		while ((size = fread (buf, 1, sizeof buf, stdin)) > 0)
+			g_string_append_len (in, buf, size);
+		run ((const guint8 *) in->str, in->len);
+		g_string_free (in, TRUE);
+		return 0;
+	}
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!g_file_get_contents (argv[i], &data, &size, &error))
+		{
+			g_printerr ("%s\n", error->message);
+			g_clear_error (&error);
+			return 1;
+		}
+		run ((const guint8 *) data, size);
+		g_free (data);
+	}
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Caps parsed from arbitrary text offered to the sink pads of dwtfilter
+ * and dwtdecoder: the caps and accept-caps queries, and fixed caps as a
+ * caps event on a pad of a paused element. The plugin is loaded from
+ * the build tree. */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <gst/gst.h>
+
+static const gchar *const element_names[] = { "dwtfilter", "dwtdecoder" };
+
+int LLVMFuzzerTestOneInput (const guint8 *data, gsize size);
+
+static void
+offer_caps (const gchar *element_name, GstCaps *caps)
+{
+	GstElement *element = gst_element_factory_make (element_name, NULL);
+	GstPad *sinkpad;
+	GstCaps *result;
+
+	g_assert (element != NULL);
+	sinkpad = gst_element_get_static_pad (element, "sink");
+	gst_element_set_state (element, GST_STATE_PAUSED);
+
+	result = gst_pad_query_caps (sinkpad, caps);
+	gst_caps_unref (result);
+	gst_pad_query_accept_caps (sinkpad, caps);
+
+	if (gst_caps_is_fixed (caps))
+	{
+		gst_pad_send_event (sinkpad, gst_event_new_stream_start ("fuzz"));
+		gst_pad_send_event (sinkpad, gst_event_new_caps (caps));
+	}
+
+	gst_element_set_state (element, GST_STATE_NULL);
+	gst_object_unref (sinkpad);
+	gst_object_unref (element);
+}
+
+int
+LLVMFuzzerTestOneInput (const guint8 *data, gsize size)
+{
+	static gsize loaded = 0;
+	gchar *str;
+	GstCaps *caps;
+	guint i;
+
+	if (g_once_init_enter (&loaded))
+	{
+		GError *error = NULL;
+		GstPlugin *plugin;
+
+		gst_init (NULL, NULL);
+		plugin = gst_plugin_load_file (DWT_PLUGIN_FILE, &error);
+		if (plugin == NULL)
+			g_error ("%s: %s", DWT_PLUGIN_FILE, error->message);
+		gst_object_unref (plugin);
+		g_once_init_leave (&loaded, 1);
+	}
+
+	str = g_strndup ((const gchar *) data, size);
+	caps = gst_caps_from_string (str);
+	g_free (str);
+	if (caps == NULL)
+		return 0;
+
+	for (i = 0; i < G_N_ELEMENTS (element_names); i++)
+		offer_caps (element_names[i], caps);
+	gst_caps_unref (caps);
+
+	return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* a coded frame through dwt_codec_read_header() and dwt_codec_decode(),
+ * tile after tile like dwtdecoder does */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "dwtcodec.h"
+
+/* keeps a single input from allocating gigabytes */
+#define MAX_PIXELS (1 << 16)
+
+int LLVMFuzzerTestOneInput (const guint8 *data, gsize size);
+
+int
+LLVMFuzzerTestOneInput (const guint8 *data, gsize size)
+{
+	guint width, tile_height, n_tiles, t;
+	gsize pos = DWT_CODEC_HEADER_SIZE;
+	DwtCodec *codec;
+	gdouble *plane;
+	gdouble step;
+
+	if (!dwt_codec_read_header (data, size, &width, &tile_height, &n_tiles, &step) ||
+		width == 0 || tile_height == 0 ||
+		(guint64) width * tile_height * n_tiles > MAX_PIXELS)
+		return 0;
+
+	codec = dwt_codec_new (width, tile_height);
+	plane = g_new (gdouble, (gsize) width * tile_height);
+
+	for (t = 0; t < n_tiles; t++)
+	{
+		gsize used = dwt_codec_decode (codec, data + pos, size - pos, step, plane);
+
+		if (used == 0)
+			break;
+		g_assert (used <= size - pos);
+		pos += used;
+	}
+
+	g_free (plane);
+	dwt_codec_free (codec);
+
+	return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* dwt_windows_parse() on arbitrary text, the windows it accepts set on
+ * a mask, applied and drawn like the element draws them */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include "dwtfilter.h"
+
+int LLVMFuzzerTestOneInput (const guint8 *data, gsize size);
+
+int
+LLVMFuzzerTestOneInput (const guint8 *data, gsize size)
+{
+	const guint width = 48, height = 32;
+	gchar *str = g_strndup ((const gchar *) data, size);
+	GArray *windows = g_array_new (FALSE, FALSE, sizeof (DwtWindow));
+	guint i;
+
+	if (dwt_windows_parse (str, windows))
+	{
+		DwtMask *mask = dwt_mask_new (width, height);
+		gdouble *coefs = g_new (gdouble, width * height);
+		guint8 *image = g_new0 (guint8, width * height);
+
+		for (i = 0; i < width * height; i++)
+			coefs[i] = i;
+		dwt_mask_set_band (mask, TRUE, 4);
+		dwt_mask_set_windows (mask, (const DwtWindow *) windows->data, windows->len);
+		dwt_mask_apply (mask, coefs);
+
+		for (i = 0; i < windows->len; i++)
+			dwt_draw_window_outline (image, width, height,
+				&g_array_index (windows, DwtWindow, i));
+
+		g_free (image);
+		g_free (coefs);
+		dwt_mask_free (mask);
+	}
+
+	g_array_free (windows, TRUE);
+	g_free (str);
+
+	return 0;
+}
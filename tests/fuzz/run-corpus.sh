@@ -0,0 +1,9 @@
+#!/bin/sh
+# Replays the seed corpus of a fuzz target, $CORPUS/<name>/* for
+# fuzz_<name>: one run per file, which libFuzzer and driver.c both do
+# when given files.
+
+prog=$1
+name=`basename "$prog" | sed -e 's/^fuzz_//' -e 's/\.exe$//'`
+
+exec "$prog" "${CORPUS:-corpus}/$name"/*
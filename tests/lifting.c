@@ -0,0 +1,161 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* the directional lifting of "l202": perfect reconstruction, through
+ * dwt_plan_execute() and through dwt_plan_forward() and
+ * dwt_plan_synthesize() */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include "check.h"
+
+#define ROUNDS 100
+#define TOLERANCE 1e-9
+
+/* even sides, not only powers of two */
+static DwtPlan *
+random_plan (void)
+{
+	const DwtWavelet *w = dwt_wavelet_lookup ("l202");
+	DwtPlan *plan;
+
+	g_assert_nonnull (w);
+	g_assert_nonnull (w->lifting);
+
+	plan = dwt_plan_new (check_random_side (1, 7) * g_test_rand_int_range (1, 4),
+			check_random_side (1, 7) * g_test_rand_int_range (1, 4));
+	dwt_plan_set_kernel (plan, &w->kernel);
+	dwt_plan_set_lifting (plan, w->lifting);
+
+	return plan;
+}
+
+/* diagonal stripes, the edges the directions are picked for, and noise */
+static void
+random_image (gdouble *data, guint width, guint height)
+{
+	guint slope = g_test_rand_int_range (1, 4), period = g_test_rand_int_range (5, 40);
+	guint x, y;
+
+	for (y = 0; y < height; y++)
+		for (x = 0; x < width; x++)
+			data[(gsize) y * width + x] = ((slope * x + y) % period < period / 2 ? 200. : 30.) +
+				g_test_rand_double_range (-8., 8.);
+}
+
+static void
+test_reconstruction (void)
+{
+	guint round;
+
+	for (round = 0; round < ROUNDS; round++)
+	{
+		DwtPlan *plan = random_plan ();
+		const gsize n = (gsize) plan->width * plan->height;
+		gdouble *input = g_new (gdouble, n), *data = g_new (gdouble, n);
+		gdouble *scratch = g_new (gdouble, dwt_plan_scratch_size (plan));
+
+		random_image (input, plan->width, plan->height);
+		memcpy (data, input, n * sizeof (gdouble));
+		dwt_plan_execute (plan, data, scratch);
+		g_assert_cmpfloat (check_max_diff (data, input, n), <=, TOLERANCE * 256);
+
+		dwt_plan_free (plan);
+		g_free (input);
+		g_free (data);
+		g_free (scratch);
+	}
+}
+
+/* the coefficients of the split transform are those of execute without
+ * inverse, and synthesizing them gives the input back */
+static void
+test_forward_synthesize (void)
+{
+	guint round;
+
+	for (round = 0; round < ROUNDS; round++)
+	{
+		DwtPlan *plan = random_plan ();
+		const gsize n = (gsize) plan->width * plan->height;
+		gdouble *input = g_new (gdouble, n), *coefs = g_new (gdouble, n);
+		gdouble *data = g_new (gdouble, n), *out = g_new (gdouble, n);
+		gdouble *scratch = g_new (gdouble, dwt_plan_scratch_size (plan));
+
+		random_image (input, plan->width, plan->height);
+
+		memcpy (coefs, input, n * sizeof (gdouble));
+		dwt_plan_forward (plan, coefs, scratch);
+
+		dwt_plan_set_inverse (plan, FALSE);
+		memcpy (data, input, n * sizeof (gdouble));
+		dwt_plan_execute (plan, data, scratch);
+		g_assert_cmpfloat (check_max_diff (data, coefs, n), ==, 0.);
+
+		dwt_plan_set_inverse (plan, TRUE);
+		dwt_plan_synthesize (plan, coefs, out, scratch);
+		g_assert_cmpfloat (check_max_diff (out, input, n), <=, TOLERANCE * 256);
+
+		dwt_plan_free (plan);
+		g_free (input);
+		g_free (coefs);
+		g_free (data);
+		g_free (out);
+		g_free (scratch);
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/lifting/reconstruction", test_reconstruction);
+	g_test_add_func ("/lifting/forward-synthesize", test_forward_synthesize);
+
+	return g_test_run ();
+}
@@ -0,0 +1,173 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* DwtLines against the stationary transform of a plan. The line buffer
+ * repeats the first and last row where the plan wraps around, so the
+ * plan gets the frame with those rows repeated far enough above and
+ * below, and the rows in between must match. Frames at least as high as
+ * wide, as both masks then count the levels of the width. */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include "check.h"
+#include "dwtlines.h"
+
+#define ROUNDS 40
+#define TOLERANCE 1e-9
+
+typedef struct
+{
+	gdouble *out;
+	guint width;
+	guint rows;
+} Output;
+
+static void
+collect (guint r, const gdouble *row, gpointer user_data)
+{
+	Output *o = user_data;
+
+	memcpy (o->out + (gsize) r * o->width, row, o->width * sizeof (gdouble));
+	o->rows++;
+}
+
+static void
+test_plan (void)
+{
+	guint round;
+
+	for (round = 0; round < ROUNDS; round++)
+	{
+		const DwtWavelet *w = check_random_wavelet ();
+		guint width = check_random_side (4, 7);
+		guint height = width + g_test_rand_int_range (0, 200);
+		guint levels = g_test_rand_int_range (1, 5);
+		guint pad = 2 * (w->kernel.nc - 1) * ((1u << levels) - 1) + 8;
+		guint padded = height + 2 * pad, y;
+		gdouble *input = g_new (gdouble, (gsize) width * height);
+		gdouble *ref = g_new (gdouble, (gsize) width * padded);
+		gdouble *scratch;
+		DwtPlan *plan = dwt_plan_new (width, padded);
+		DwtLines *lines = dwt_lines_new (width, height, levels);
+		DwtWindow win, plan_win;
+		Output o = { g_new0 (gdouble, (gsize) width * height), width, 0 };
+
+		check_random_plane (input, (gsize) width * height);
+		for (y = 0; y < padded; y++)
+			memcpy (ref + (gsize) y * width,
+					input + (gsize) CLAMP ((gint) y - (gint) pad, 0, (gint) height - 1) * width,
+					width * sizeof (gdouble));
+
+		dwt_plan_set_kernel (plan, &w->kernel);
+		g_assert_true (dwt_plan_set_stationary (plan, levels));
+		dwt_lines_set_kernel (lines, &w->kernel);
+
+		switch (g_test_rand_int_range (0, 4))
+		{
+		case 0:
+		{
+			guint cutoff = g_test_rand_int_range (0, width);
+
+			dwt_mask_set_band (plan->mask, FALSE, cutoff);
+			dwt_mask_set_band (lines->mask, FALSE, cutoff);
+			break;
+		}
+		case 1:
+			check_random_window (width, height, &win);
+			/* the rows the plan has past the frame are not in it */
+			plan_win = win;
+			plan_win.y += pad;
+			plan_win.h = win.y < height ? MIN (win.h, height - win.y) : 0;
+			dwt_mask_set_band (plan->mask, TRUE, width / 4);
+			dwt_mask_set_band (lines->mask, TRUE, width / 4);
+			dwt_mask_set_windows (plan->mask, &plan_win, 1);
+			dwt_mask_set_windows (lines->mask, &win, 1);
+			break;
+		case 2:
+		{
+			DwtSubbandRule rule = { 1, 2, DWT_SUBBAND_HL | DWT_SUBBAND_HH, 0.3 };
+
+			dwt_mask_set_subbands (plan->mask, &rule, 1);
+			dwt_mask_set_subbands (lines->mask, &rule, 1);
+			break;
+		}
+		default:
+			dwt_plan_set_inverse (plan, FALSE);
+			dwt_lines_set_inverse (lines, FALSE);
+			break;
+		}
+
+		scratch = g_new (gdouble, dwt_plan_scratch_size (plan));
+		dwt_plan_execute (plan, ref, scratch);
+
+		dwt_lines_begin (lines, collect, &o);
+		for (y = 0; y < height; y++)
+			dwt_lines_push (lines, input + (gsize) y * width);
+
+		g_assert_cmpuint (o.rows, ==, height);
+		g_assert_cmpfloat (check_max_diff (o.out, ref + (gsize) pad * width,
+					(gsize) width * height), <=,
+				TOLERANCE * MAX (1., check_max_abs (o.out, (gsize) width * height)));
+
+		dwt_plan_free (plan);
+		dwt_lines_free (lines);
+		g_free (input);
+		g_free (ref);
+		g_free (scratch);
+		g_free (o.out);
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/lines/plan", test_plan);
+
+	return g_test_run ();
+}
@@ -0,0 +1,219 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* the compiled runs of DwtMask against the gain of every coefficient
+ * worked out one by one, and its incremental updates against masks
+ * built from scratch */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "check.h"
+
+#define ROUNDS 100
+
+/* the gains the runs of mask give, one per coefficient */
+static gdouble *
+mask_gains (const DwtMask *mask)
+{
+	const gsize n = (gsize) mask->width * mask->height;
+	gdouble *gains = g_new (gdouble, n);
+	gsize i;
+
+	for (i = 0; i < n; i++)
+		gains[i] = 1.;
+	dwt_mask_apply (mask, gains);
+
+	return gains;
+}
+
+static void
+assert_gains (const DwtMask *mask)
+{
+	gdouble *gains = mask_gains (mask);
+	guint x, y;
+
+	for (y = 0; y < mask->height; y++)
+	{
+		for (x = 0; x < mask->width; x++)
+		{
+			gdouble expected = check_gain (mask, x, y);
+
+			if (gains[(gsize) y * mask->width + x] != expected)
+				g_test_message ("%ux%u coefficient (%u, %u): %g, expected %g",
+						mask->width, mask->height, x, y,
+						gains[(gsize) y * mask->width + x], expected);
+			g_assert_cmpfloat (gains[(gsize) y * mask->width + x], ==, expected);
+		}
+	}
+
+	g_free (gains);
+}
+
+static void
+random_rules (GArray *rules)
+{
+	guint n = g_test_rand_int_range (0, 4), i;
+
+	g_array_set_size (rules, 0);
+	for (i = 0; i < n; i++)
+	{
+		DwtSubbandRule rule;
+
+		rule.first_level = g_test_rand_int_range (1, 6);
+		rule.last_level = g_test_rand_bit () ? G_MAXUINT :
+			rule.first_level + g_test_rand_int_range (0, 3);
+		rule.orientations = g_test_rand_int_range (1, 16);
+		rule.gain = g_test_rand_bit () ? 0. : g_test_rand_double_range (0., 2.);
+		g_array_append_val (rules, rule);
+	}
+}
+
+static void
+random_windows (guint width, guint height, GArray *windows)
+{
+	guint n = g_test_rand_int_range (0, 6), i;
+
+	g_array_set_size (windows, n);
+	for (i = 0; i < n; i++)
+		check_random_window (width, height, &g_array_index (windows, DwtWindow, i));
+}
+
+static void
+test_gains (void)
+{
+	GArray *rules = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+	GArray *windows = g_array_new (FALSE, FALSE, sizeof (DwtWindow));
+	guint round;
+
+	for (round = 0; round < ROUNDS; round++)
+	{
+		guint width = check_random_side (0, 7), height = check_random_side (0, 7);
+		DwtMask *mask = dwt_mask_new (width, height);
+
+		random_rules (rules);
+		random_windows (width, height, windows);
+
+		dwt_mask_set_band (mask, g_test_rand_bit (),
+				g_test_rand_int_range (0, MAX (width, height) + 2));
+		dwt_mask_set_subbands (mask, (DwtSubbandRule *) rules->data, rules->len);
+		dwt_mask_set_windows (mask, (DwtWindow *) windows->data, windows->len);
+		assert_gains (mask);
+
+		dwt_mask_free (mask);
+	}
+
+	g_array_free (rules, TRUE);
+	g_array_free (windows, TRUE);
+}
+
+/* A mask taken through random settings and back must compile to what a
+ * new mask with the final settings compiles to. */
+static void
+test_round_trip (void)
+{
+	GArray *rules = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+	GArray *windows = g_array_new (FALSE, FALSE, sizeof (DwtWindow));
+	guint width = check_random_side (3, 8), height = check_random_side (3, 8);
+	DwtMask *mask = dwt_mask_new (width, height);
+	guint round;
+
+	for (round = 0; round < ROUNDS; round++)
+	{
+		DwtMask *fresh = dwt_mask_new (width, height);
+		gdouble *a, *b;
+		gboolean highpass = g_test_rand_bit ();
+		guint cutoff = g_test_rand_int_range (0, MAX (width, height) + 1);
+
+		/* mostly small moves of the windows, the case the updates are for */
+		if (g_test_rand_int_range (0, 4) == 0)
+			random_windows (width, height, windows);
+		else if (windows->len > 0)
+		{
+			DwtWindow *win = &g_array_index (windows, DwtWindow,
+					g_test_rand_int_range (0, windows->len));
+
+			win->x += g_test_rand_int_range (0, 3);
+			win->h = MAX (win->h, 1) - 1;
+		}
+		if (g_test_rand_int_range (0, 4) == 0)
+			random_rules (rules);
+
+		dwt_mask_set_band (mask, highpass, cutoff);
+		dwt_mask_set_subbands (mask, (DwtSubbandRule *) rules->data, rules->len);
+		dwt_mask_set_windows (mask, (DwtWindow *) windows->data, windows->len);
+
+		dwt_mask_set_windows (fresh, (DwtWindow *) windows->data, windows->len);
+		dwt_mask_set_subbands (fresh, (DwtSubbandRule *) rules->data, rules->len);
+		dwt_mask_set_band (fresh, highpass, cutoff);
+
+		a = mask_gains (mask);
+		b = mask_gains (fresh);
+		g_assert_cmpfloat (check_max_diff (a, b, (gsize) width * height), ==, 0.);
+		g_free (a);
+		g_free (b);
+		dwt_mask_free (fresh);
+	}
+	assert_gains (mask);
+
+	/* unchanged settings report no change */
+	g_assert_false (dwt_mask_set_windows (mask, (DwtWindow *) windows->data, windows->len));
+	g_assert_false (dwt_mask_set_subbands (mask, (DwtSubbandRule *) rules->data, rules->len));
+	g_assert_false (dwt_mask_set_band (mask, mask->highpass, mask->cutoff));
+
+	dwt_mask_free (mask);
+	g_array_free (rules, TRUE);
+	g_array_free (windows, TRUE);
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/mask/gains", test_gains);
+	g_test_add_func ("/mask/round-trip", test_round_trip);
+
+	return g_test_run ();
+}
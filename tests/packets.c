@@ -0,0 +1,213 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* wavelet packets: perfect reconstruction, the energy of orthogonal
+ * wavelets and the LL band the dyadic transform leaves */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "check.h"
+
+#define ROUNDS 100
+#define TOLERANCE 1e-9
+
+static DwtPlan *
+random_plan (const DwtWavelet *w, guint *levels)
+{
+	DwtPlan *plan = dwt_plan_new (check_random_side (1, 8), check_random_side (1, 8));
+
+	*levels = g_test_rand_int_range (1, DWT_PACKET_MAX_LEVELS + 1);
+	dwt_plan_set_kernel (plan, &w->kernel);
+	dwt_plan_set_packets (plan, *levels);
+
+	return plan;
+}
+
+static gdouble
+run (const DwtPlan *plan, const gdouble *input, gdouble *data)
+{
+	const gsize n = (gsize) plan->width * plan->height;
+	gdouble *scratch = g_new (gdouble, dwt_plan_scratch_size (plan));
+
+	memcpy (data, input, n * sizeof (gdouble));
+	dwt_plan_execute (plan, data, scratch);
+	g_free (scratch);
+
+	return check_max_diff (data, input, n) / MAX (1., check_max_abs (input, n));
+}
+
+static void
+test_reconstruction (void)
+{
+	guint round, levels;
+
+	for (round = 0; round < ROUNDS; round++)
+	{
+		DwtPlan *plan = random_plan (check_random_wavelet (), &levels);
+		const gsize n = (gsize) plan->width * plan->height;
+		gdouble *input = g_new (gdouble, n), *data = g_new (gdouble, n);
+
+		g_assert_cmpuint (plan->packet_levels, <=, levels);
+		check_random_plane (input, n);
+		g_assert_cmpfloat (run (plan, input, data), <=, TOLERANCE);
+
+		dwt_plan_free (plan);
+		g_free (input);
+		g_free (data);
+	}
+}
+
+/* orthogonal wavelets keep the energy in whatever basis is picked */
+static void
+test_energy (void)
+{
+	static const gchar *const names[] = { "h2", "d4", "dc6", "d12" };
+	guint round, levels;
+
+	for (round = 0; round < ROUNDS; round++)
+	{
+		const DwtWavelet *w = dwt_wavelet_lookup (names[g_test_rand_int_range (0, G_N_ELEMENTS (names))]);
+		DwtPlan *plan = random_plan (w, &levels);
+		const gsize n = (gsize) plan->width * plan->height;
+		gdouble *input = g_new (gdouble, n), *data = g_new (gdouble, n);
+		gdouble e_in = 0, e_out = 0;
+		gsize i;
+
+		check_random_plane (input, n);
+		dwt_plan_set_inverse (plan, FALSE);
+		run (plan, input, data);
+		for (i = 0; i < n; i++)
+		{
+			e_in += input[i] * input[i];
+			e_out += data[i] * data[i];
+		}
+		g_assert_cmpfloat (fabs (e_out - e_in), <=, TOLERANCE * e_in);
+
+		dwt_plan_free (plan);
+		g_free (input);
+		g_free (data);
+	}
+}
+
+/* only the detail bands split further, the preview is the dyadic one */
+static void
+test_preview (void)
+{
+	guint round, levels;
+
+	for (round = 0; round < ROUNDS; round++)
+	{
+		const DwtWavelet *w = check_random_wavelet ();
+		DwtPlan *packets = random_plan (w, &levels);
+		DwtPlan *dyadic = dwt_plan_new (packets->width, packets->height);
+		const gsize n = (gsize) packets->width * packets->height;
+		guint level = g_test_rand_int_range (1, dwt_max_level (packets->width, packets->height) + 1);
+		const gsize p = (gsize) (packets->width >> level) * (packets->height >> level);
+		gdouble *input = g_new (gdouble, n), *data = g_new (gdouble, n);
+		gdouble *a = g_new0 (gdouble, MAX (p, 1)), *b = g_new0 (gdouble, MAX (p, 1));
+
+		dwt_plan_set_kernel (dyadic, &w->kernel);
+		dwt_plan_set_preview (packets, level, a);
+		dwt_plan_set_preview (dyadic, level, b);
+
+		check_random_plane (input, n);
+		run (packets, input, data);
+		run (dyadic, input, data);
+		g_assert_cmpfloat (check_max_diff (a, b, p), <=, TOLERANCE * 256);
+
+		dwt_plan_free (packets);
+		dwt_plan_free (dyadic);
+		g_free (input);
+		g_free (data);
+		g_free (a);
+		g_free (b);
+	}
+}
+
+/* packet-levels 1 splits once more: columns of alternating pixels leave
+ * HL constant, which the best basis splits into its LL quarter */
+static void
+test_one_split (void)
+{
+	const guint side = 16, q = side / 2;
+	DwtPlan *plan = dwt_plan_new (side, side);
+	gdouble *input = g_new (gdouble, side * side), *data = g_new (gdouble, side * side);
+	guint x, y, nonzero = 0;
+
+	dwt_plan_set_kernel (plan, &dwt_wavelet_lookup ("h2")->kernel);
+	dwt_plan_set_packets (plan, 1);
+	dwt_plan_set_inverse (plan, FALSE);
+	g_assert_cmpuint (plan->packet_levels, ==, 1);
+
+	for (y = 0; y < side; y++)
+		for (x = 0; x < side; x++)
+			input[y * side + x] = x & 1 ? 192 : 64;
+	run (plan, input, data);
+
+	for (y = 0; y < q; y++)
+		for (x = q; x < side; x++)
+			nonzero += fabs (data[y * side + x]) > TOLERANCE;
+	g_assert_cmpuint (nonzero, ==, q * q / 4);
+
+	dwt_plan_free (plan);
+	g_free (input);
+	g_free (data);
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/packets/reconstruction", test_reconstruction);
+	g_test_add_func ("/packets/energy", test_energy);
+	g_test_add_func ("/packets/preview", test_preview);
+	g_test_add_func ("/packets/one-split", test_one_split);
+
+	return g_test_run ();
+}
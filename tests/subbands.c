@@ -0,0 +1,193 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* dwt_subband_rules_parse(): the documented forms, rejected input and
+ * rules written back as text and parsed again */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "check.h"
+
+#define ROUNDS 500
+
+typedef struct
+{
+	const gchar *str;
+	DwtSubbandRule rule;
+} ParseCase;
+
+static const ParseCase valid[] = {
+	{ "1:hh=drop", { 1, 1, DWT_SUBBAND_HH, 0. } },
+	{ "1-2:lh=0.5", { 1, 2, DWT_SUBBAND_LH, 0.5 } },
+	{ "*:*=keep", { 1, G_MAXUINT, DWT_SUBBAND_DETAILS, 1. } },
+	{ "hl+LH = 2", { 1, G_MAXUINT, DWT_SUBBAND_HL | DWT_SUBBAND_LH, 2. } },
+	{ " 3 : ll + hh = -1.25 ", { 3, 3, DWT_SUBBAND_LL | DWT_SUBBAND_HH, -1.25 } },
+	{ "2-7:*=1e-3", { 2, 7, DWT_SUBBAND_DETAILS, 1e-3 } },
+};
+
+static const gchar *const invalid[] = {
+	"hh", "=1", "hh=", "hh=x", "hh=1x", "0:hh=1", "2-1:hh=1", "1-:hh=1",
+	"a:hh=1", "1:=1", "1:hx=1", "1:hh+=1", "1:hh=keep;lh", "1:hh=1=2",
+};
+
+static void
+assert_rule (const DwtSubbandRule *a, const DwtSubbandRule *b)
+{
+	g_assert_cmpuint (a->first_level, ==, b->first_level);
+	g_assert_cmpuint (a->last_level, ==, b->last_level);
+	g_assert_cmpuint (a->orientations, ==, b->orientations);
+	g_assert_cmpfloat (a->gain, ==, b->gain);
+}
+
+static void
+test_valid (void)
+{
+	GArray *rules = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+	GString *all = g_string_new (NULL);
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (valid); i++)
+	{
+		g_array_set_size (rules, 0);
+		g_assert_true (dwt_subband_rules_parse (valid[i].str, rules));
+		g_assert_cmpuint (rules->len, ==, 1);
+		assert_rule (&g_array_index (rules, DwtSubbandRule, 0), &valid[i].rule);
+		g_string_append_printf (all, "%s;;", valid[i].str);
+	}
+
+	/* all of them at once, empty entries skipped */
+	g_array_set_size (rules, 0);
+	g_assert_true (dwt_subband_rules_parse (all->str, rules));
+	g_assert_cmpuint (rules->len, ==, G_N_ELEMENTS (valid));
+	for (i = 0; i < G_N_ELEMENTS (valid); i++)
+		assert_rule (&g_array_index (rules, DwtSubbandRule, i), &valid[i].rule);
+
+	g_array_set_size (rules, 0);
+	g_assert_true (dwt_subband_rules_parse (NULL, rules));
+	g_assert_true (dwt_subband_rules_parse ("", rules));
+	g_assert_cmpuint (rules->len, ==, 0);
+
+	g_string_free (all, TRUE);
+	g_array_free (rules, TRUE);
+}
+
+static void
+test_invalid (void)
+{
+	GArray *rules = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (invalid); i++)
+	{
+		if (dwt_subband_rules_parse (invalid[i], rules))
+			g_test_message ("\"%s\" parsed", invalid[i]);
+		g_assert_false (dwt_subband_rules_parse (invalid[i], rules));
+	}
+
+	g_array_free (rules, TRUE);
+}
+
+/* random rules written in the syntax, the gains exact in %.17g */
+static void
+test_round_trip (void)
+{
+	static const gchar *const names[] = { "ll", "hl", "lh", "hh" };
+	GArray *rules = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+	GArray *parsed = g_array_new (FALSE, FALSE, sizeof (DwtSubbandRule));
+	guint round, i, b;
+
+	for (round = 0; round < ROUNDS; round++)
+	{
+		GString *str = g_string_new (NULL);
+		guint n = g_test_rand_int_range (1, 5);
+
+		g_array_set_size (rules, n);
+		for (i = 0; i < n; i++)
+		{
+			DwtSubbandRule *rule = &g_array_index (rules, DwtSubbandRule, i);
+			const gchar *sep = "";
+
+			rule->first_level = g_test_rand_int_range (1, 10);
+			rule->last_level = rule->first_level + g_test_rand_int_range (0, 10);
+			rule->orientations = g_test_rand_int_range (1, 16);
+			rule->gain = g_test_rand_double_range (-4., 4.);
+
+			g_string_append_printf (str, "%u-%u:", rule->first_level, rule->last_level);
+			for (b = 0; b < G_N_ELEMENTS (names); b++)
+			{
+				if (rule->orientations & (1u << b))
+				{
+					g_string_append_printf (str, "%s%s", sep, names[b]);
+					sep = "+";
+				}
+			}
+			g_string_append_printf (str, "=%.17g;", rule->gain);
+		}
+
+		g_array_set_size (parsed, 0);
+		g_assert_true (dwt_subband_rules_parse (str->str, parsed));
+		g_assert_cmpuint (parsed->len, ==, n);
+		for (i = 0; i < n; i++)
+			assert_rule (&g_array_index (parsed, DwtSubbandRule, i),
+					&g_array_index (rules, DwtSubbandRule, i));
+
+		g_string_free (str, TRUE);
+	}
+
+	g_array_free (rules, TRUE);
+	g_array_free (parsed, TRUE);
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/subbands/valid", test_valid);
+	g_test_add_func ("/subbands/invalid", test_invalid);
+	g_test_add_func ("/subbands/round-trip", test_round_trip);
+
+	return g_test_run ();
+}
@@ -0,0 +1,205 @@
+/*
+ * GStreamer
+ * Copyright (C) 2015 Martin Petrov Vachovski <<user@hostname.org>>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ * Alternatively, the contents of this file may be used under the
+ * GNU Lesser General Public License Version 2.1 (the "LGPL"), in
+ * which case the following provisions apply instead of the ones
+ * mentioned above:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* dwt_plan_execute() against GSL's own transform, over random sizes,
+ * wavelets, bands, subband gains and phof windows */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include "check.h"
+
+#define ROUNDS 200
+
+/* relative to the largest coefficient, rounding alone stays far below */
+#define TOLERANCE 1e-9
+
+static void
+run_plan (const DwtWavelet *w, DwtPlan *plan, const gdouble *input)
+{
+	const gsize n = (gsize) plan->width * plan->height;
+	gdouble *data = g_new (gdouble, n);
+	gdouble *ref = g_new (gdouble, n);
+	gdouble *scratch = g_new (gdouble, dwt_plan_scratch_size (plan));
+	gdouble err;
+
+	memcpy (data, input, n * sizeof (gdouble));
+	memcpy (ref, input, n * sizeof (gdouble));
+
+	dwt_plan_execute (plan, data, scratch);
+	check_reference (w->gsl, plan->mask, plan->inverse, ref);
+
+	err = check_max_diff (data, ref, n) / MAX (1., check_max_abs (ref, n));
+	if (err > TOLERANCE)
+		g_test_message ("%ux%u %c%s%u %s cutoff %u, %u windows, %u rules: %g",
+				plan->width, plan->height, w->family, w->centered ? "c" : "", w->order,
+				plan->mask->highpass ? "high" : "low", plan->mask->cutoff,
+				plan->mask->windows->len, plan->mask->rules->len, err);
+	g_assert_cmpfloat (err, <=, TOLERANCE);
+
+	g_free (data);
+	g_free (ref);
+	g_free (scratch);
+}
+
+/* one plan per round, the mask set up from scratch */
+static void
+test_random (void)
+{
+	guint round;
+
+	for (round = 0; round < ROUNDS; round++)
+	{
+		const DwtWavelet *w = check_random_wavelet ();
+		guint width = check_random_side (1, 8), height = check_random_side (1, 8);
+		DwtPlan *plan = dwt_plan_new (width, height);
+		gdouble *input = g_new (gdouble, (gsize) width * height);
+		DwtWindow windows[4];
+		guint n_windows = g_test_rand_int_range (0, 5), i;
+
+		for (i = 0; i < n_windows; i++)
+			check_random_window (width, height, &windows[i]);
+
+		dwt_plan_set_kernel (plan, &w->kernel);
+		dwt_plan_set_inverse (plan, g_test_rand_int_range (0, 4) != 0);
+		dwt_mask_set_band (plan->mask, g_test_rand_bit (),
+				g_test_rand_int_range (0, MAX (width, height) + 2));
+		dwt_mask_set_windows (plan->mask, windows, n_windows);
+		if (g_test_rand_bit ())
+		{
+			DwtSubbandRule rule;
+
+			rule.first_level = g_test_rand_int_range (1, 4);
+			rule.last_level = rule.first_level + g_test_rand_int_range (0, 3);
+			rule.orientations = g_test_rand_int_range (1, 16);
+			rule.gain = g_test_rand_double_range (-1., 2.);
+			dwt_mask_set_subbands (plan->mask, &rule, 1);
+		}
+
+		check_random_plane (input, (gsize) width * height);
+		run_plan (w, plan, input);
+
+		dwt_plan_free (plan);
+		g_free (input);
+	}
+}
+
+/* One plan whose windows move from frame to frame, as with the ROI
+ * metas: the incremental mask updates must match the reference. */
+static void
+test_moving_windows (void)
+{
+	guint width = check_random_side (5, 8), height = check_random_side (5, 8);
+	const DwtWavelet *w = check_random_wavelet ();
+	DwtPlan *plan = dwt_plan_new (width, height);
+	gdouble *input = g_new (gdouble, (gsize) width * height);
+	DwtWindow windows[3];
+	guint frame, i;
+
+	dwt_plan_set_kernel (plan, &w->kernel);
+	dwt_mask_set_band (plan->mask, FALSE, MIN (width, height) / 8);
+	for (i = 0; i < G_N_ELEMENTS (windows); i++)
+		check_random_window (width, height, &windows[i]);
+
+	for (frame = 0; frame < 20; frame++)
+	{
+		i = g_test_rand_int_range (0, G_N_ELEMENTS (windows));
+		windows[i].x = MIN (windows[i].x + g_test_rand_int_range (0, 5), width);
+		windows[i].y = MIN (windows[i].y + g_test_rand_int_range (0, 5), height);
+		windows[i].w = g_test_rand_int_range (0, width / 2);
+		dwt_mask_set_windows (plan->mask, windows, g_test_rand_int_range (0, 4));
+
+		check_random_plane (input, (gsize) width * height);
+		run_plan (w, plan, input);
+	}
+
+	dwt_plan_free (plan);
+	g_free (input);
+}
+
+/* Plans of the cache other than the one just returned hold no
+ * stationary planes, and get them back when used again. */
+static void
+test_plan_cache (void)
+{
+	DwtPlanCache *cache = dwt_plan_cache_new (4);
+	DwtPlan *plans[3];
+	guint i, j;
+
+	for (i = 0; i < G_N_ELEMENTS (plans); i++)
+	{
+		plans[i] = dwt_plan_cache_get (cache, 16 << i, 16);
+		g_assert_true (dwt_plan_set_stationary (plans[i], 2));
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (plans); i++)
+	{
+		g_assert_true (dwt_plan_cache_get (cache, 16 << i, 16) == plans[i]);
+		for (j = 0; j < G_N_ELEMENTS (plans); j++)
+		{
+			if (j == i)
+				continue;
+			g_assert_cmpuint (plans[j]->stationary_levels, ==, 0);
+			g_assert_null (plans[j]->bands);
+		}
+		g_assert_true (dwt_plan_set_stationary (plans[i], 2));
+		g_assert_nonnull (plans[i]->bands);
+	}
+
+	dwt_plan_cache_free (cache);
+}
+
+int
+main (int argc, char **argv)
+{
+	g_test_init (&argc, &argv, NULL);
+
+	g_test_add_func ("/transform/random", test_random);
+	g_test_add_func ("/transform/moving-windows", test_moving_windows);
+	g_test_add_func ("/transform/plan-cache", test_plan_cache);
+
+	return g_test_run ();
+}